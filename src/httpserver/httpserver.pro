@@ -12,6 +12,12 @@ HEADERS += \
     qabstracthttpserver_p.h \
     qhttpserver.h \
     qhttpserver_p.h \
+    qhttpserverbodydevice_p.h \
+    qhttpserverconfiguration.h \
+    qhttpserverconnection_p.h \
+    qhttpserverhpack_p.h \
+    qhttpserverhttp2connection_p.h \
+    qhttpserverlisteneroptions.h \
     qhttpserverliterals_p.h \
     qhttpserverrequest.h \
     qhttpserverrequest_p.h \
@@ -23,19 +29,34 @@ HEADERS += \
     qhttpserverrouter_p.h \
     qhttpserverrouterrule.h \
     qhttpserverrouterrule_p.h \
+    qhttpservertimerwheel_p.h \
     qhttpserverrouterviewtraits.h \
     qhttpserverviewtraits.h \
-    qhttpserverviewtraits_impl.h
+    qhttpserverviewtraits_impl.h \
+    qhttpserverworker_p.h
 
 SOURCES += \
     qabstracthttpserver.cpp \
     qhttpserver.cpp \
+    qhttpserverbodydevice.cpp \
+    qhttpserverconfiguration.cpp \
+    qhttpserverconnection.cpp \
+    qhttpserverhpack.cpp \
+    qhttpserverhttp2connection.cpp \
+    qhttpserverlisteneroptions.cpp \
     qhttpserverliterals.cpp \
     qhttpserverrequest.cpp \
     qhttpserverresponder.cpp \
     qhttpserverresponse.cpp \
     qhttpserverrouter.cpp \
-    qhttpserverrouterrule.cpp
+    qhttpserverrouterrule.cpp \
+    qhttpservertimerwheel.cpp \
+    qhttpserverworker.cpp
+
+linux {
+    HEADERS += qhttpserverepolleventdispatcher_p.h
+    SOURCES += qhttpserverepolleventdispatcher.cpp
+}
 
 qtHaveModule(concurrent) {
     QT += concurrent
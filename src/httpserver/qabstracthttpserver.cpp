@@ -29,19 +29,41 @@
 
 #include <QtHttpServer/qabstracthttpserver.h>
 
+#include <QtHttpServer/qhttpserverconfiguration.h>
+#include <QtHttpServer/qhttpserverlisteneroptions.h>
 #include <QtHttpServer/qhttpserverrequest.h>
 #include <QtHttpServer/qhttpserverresponder.h>
 #include <private/qabstracthttpserver_p.h>
+#include <private/qhttpserverconnection_p.h>
+#include <private/qhttpserverhttp2connection_p.h>
 #include <private/qhttpserverrequest_p.h>
+#include <private/qhttpserverworker_p.h>
+#if defined(Q_OS_LINUX)
+#include <private/qhttpserverepolleventdispatcher_p.h>
+#endif
 
+#include <QtCore/qfile.h>
 #include <QtCore/qloggingcategory.h>
 #include <QtCore/qmetaobject.h>
+#include <QtCore/qthread.h>
 #include <QtNetwork/qtcpserver.h>
 #include <QtNetwork/qtcpsocket.h>
 
 #include "http_parser.h"
 
+#if defined(Q_OS_UNIX)
+#  include <errno.h>
+#  include <fcntl.h>
+#  include <netinet/in.h>
+#  include <netinet/tcp.h>
+#  include <sys/socket.h>
+#  include <sys/un.h>
+#  include <unistd.h>
+#endif
+
 #include <algorithm>
+#include <cstddef>
+#include <cstring>
 
 QT_BEGIN_NAMESPACE
 
@@ -51,83 +73,746 @@ QAbstractHttpServerPrivate::QAbstractHttpServerPrivate()
 {
 }
 
+QAbstractHttpServerPrivate::~QAbstractHttpServerPrivate()
+{
+}
+
+void QAbstractHttpServerPrivate::startWorkers()
+{
+    if (!workers.empty())
+        return;
+
+    const int count = configuration.workerThreadCount();
+    const bool epoll = configuration.eventBackend()
+            == QHttpServerConfiguration::EventBackend::Epoll;
+#if !defined(Q_OS_LINUX)
+    if (epoll && count > 0)
+        qCWarning(lcHttpServer, "The epoll event backend is not supported on this platform");
+#endif
+    for (int i = 0; i < count; ++i) {
+        auto thread = new QThread;
+        thread->setObjectName(QStringLiteral("QHttpServer worker %1").arg(i));
+#if defined(Q_OS_LINUX)
+        if (epoll) {
+            auto dispatcher = new QHttpServerEpollEventDispatcher;
+            if (dispatcher->isValid())
+                thread->setEventDispatcher(dispatcher);
+            else
+                delete dispatcher;
+        }
+#endif
+        auto worker = new QHttpServerWorker(this);
+        worker->moveToThread(thread);
+        QObject::connect(thread, &QThread::finished, worker, &QObject::deleteLater);
+        thread->start();
+        workerThreads.emplace_back(thread);
+        workers.push_back(worker);
+    }
+}
+
+void QAbstractHttpServerPrivate::stopWorkers()
+{
+    for (const auto &thread : workerThreads)
+        thread->quit();
+    for (const auto &thread : workerThreads)
+        thread->wait();
+    shardServers.clear();
+    workers.clear();
+    workerThreads.clear();
+}
+
+QTcpServer *QAbstractHttpServerPrivate::createTcpServer(QObject *parent)
+{
+#if QT_CONFIG(ssl)
+    if (sslEnabled) {
+        auto sslServer = new QSslServer(listenerSslConfiguration(), parent);
+        // One cache for the listeners of all the threads
+        sslServer->setSessionCache(sslSessionCache);
+        sslServer->setMaxConcurrentHandshakes(configuration.maxConcurrentSslHandshakes());
+        sslServer->setHandshakeTimeout(configuration.sslHandshakeTimeout());
+
+        QMutexLocker locker(&sslServersMutex);
+        sslServers.erase(std::remove_if(sslServers.begin(), sslServers.end(),
+                                        [](const QPointer<QSslServer> &server) {
+                                            return !server;
+                                        }),
+                         sslServers.end());
+        sslServers.emplace_back(sslServer);
+        return sslServer;
+    }
+#endif
+    return new QTcpServer(parent);
+}
+
+#if QT_CONFIG(ssl)
+QSslConfiguration QAbstractHttpServerPrivate::listenerSslConfiguration() const
+{
+    if (!configuration.http2Enabled())
+        return sslConfiguration;
+    // Clients pick HTTP/2 during the handshake
+    auto alpnConfiguration = sslConfiguration;
+    alpnConfiguration.setAllowedNextProtocols({ QSslConfiguration::ALPNProtocolHTTP2,
+                                                QSslConfiguration::NextProtocolHttp1_1 });
+    return alpnConfiguration;
+}
+
+/*!
+    \internal
+
+    Hands the current sslConfiguration to the listeners already created,
+    for their next handshakes.
+*/
+void QAbstractHttpServerPrivate::updateSslServers()
+{
+    const auto configuration = listenerSslConfiguration();
+    QMutexLocker locker(&sslServersMutex);
+    for (const auto &sslServer : sslServers) {
+        if (!sslServer)
+            continue;
+        // Listener shards live in the worker threads
+        QSslServer *server = sslServer.data();
+        QMetaObject::invokeMethod(server, [server, configuration]() {
+            server->setSslConfiguration(configuration);
+        });
+    }
+}
+
+/*!
+    \internal
+
+    Loads sslCertificateFile and sslPrivateKeyFile into sslConfiguration,
+    leaving it unchanged if either cannot be read.
+*/
+bool QAbstractHttpServerPrivate::loadSslFiles()
+{
+    const auto chain = QSslCertificate::fromPath(sslCertificateFile);
+    if (chain.isEmpty()) {
+        qCWarning(lcHttpServer) << "No certificate could be read from" << sslCertificateFile;
+        return false;
+    }
+
+    QFile file(sslPrivateKeyFile);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCWarning(lcHttpServer) << "Cannot open" << sslPrivateKeyFile << file.errorString();
+        return false;
+    }
+    const QByteArray pem = file.readAll();
+    QSslKey privateKey;
+    for (const auto algorithm : { QSsl::Rsa, QSsl::Ec, QSsl::Dsa }) {
+        privateKey = QSslKey(pem, algorithm);
+        if (!privateKey.isNull())
+            break;
+    }
+    if (privateKey.isNull()) {
+        qCWarning(lcHttpServer) << "No private key could be read from" << sslPrivateKeyFile;
+        return false;
+    }
+
+    auto conf = sslEnabled ? sslConfiguration : QSslConfiguration::defaultConfiguration();
+    conf.setLocalCertificateChain(chain);
+    conf.setPrivateKey(privateKey);
+    sslConfiguration = conf;
+    sslEnabled = true;
+    updateSslServers();
+    return true;
+}
+
+#if QT_CONFIG(filesystemwatcher)
+void QAbstractHttpServerPrivate::reloadSslFiles()
+{
+    // Files replaced by a rename are not watched anymore
+    const QStringList files = { sslCertificateFile, sslPrivateKeyFile };
+    for (const auto &file : files) {
+        if (!sslFileWatcher->files().contains(file) && QFile::exists(file))
+            sslFileWatcher->addPath(file);
+    }
+    if (loadSslFiles())
+        qCDebug(lcHttpServer) << "Reloaded" << sslCertificateFile << "and" << sslPrivateKeyFile;
+}
+#endif
+#endif
+
+#if defined(Q_OS_UNIX) && defined(SO_REUSEPORT)
+static qintptr reusePortSocket(const QHostAddress &address, quint16 port)
+{
+    sockaddr_storage storage;
+    std::memset(&storage, 0, sizeof(storage));
+    socklen_t length = 0;
+    const bool ipv4 = address.protocol() == QAbstractSocket::IPv4Protocol;
+    if (ipv4) {
+        auto sin = reinterpret_cast<sockaddr_in *>(&storage);
+        sin->sin_family = AF_INET;
+        sin->sin_port = htons(port);
+        sin->sin_addr.s_addr = htonl(address.toIPv4Address());
+        length = sizeof(sockaddr_in);
+    } else {
+        auto sin6 = reinterpret_cast<sockaddr_in6 *>(&storage);
+        sin6->sin6_family = AF_INET6;
+        sin6->sin6_port = htons(port);
+        const Q_IPV6ADDR ip6 = address.toIPv6Address();
+        std::memcpy(&sin6->sin6_addr, &ip6, sizeof(ip6));
+        sin6->sin6_scope_id = address.scopeId().toUInt();
+        length = sizeof(sockaddr_in6);
+    }
+
+    const int fd = ::socket(storage.ss_family, SOCK_STREAM, 0);
+    if (fd == -1)
+        return -1;
+    ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+    const int on = 1;
+    const int v6only = address.protocol() == QAbstractSocket::IPv6Protocol ? 1 : 0;
+    if (::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) == -1
+            || ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) == -1
+            || (!ipv4 && ::setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY,
+                                      &v6only, sizeof(v6only)) == -1)
+            || ::bind(fd, reinterpret_cast<sockaddr *>(&storage), length) == -1
+            || ::listen(fd, 50) == -1) {
+        const int error = errno;
+        ::close(fd);
+        errno = error;
+        return -1;
+    }
+    return fd;
+}
+#endif
+
+#if defined(Q_OS_UNIX)
+/*
+    Returns a listening Unix domain socket bound to \a path, or -1 with
+    errno set. A path starting with a null byte is a name in the abstract
+    namespace of Linux.
+*/
+static qintptr localSocket(const QByteArray &path)
+{
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    if (path.isEmpty() || size_t(path.size()) >= sizeof(address.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.constData(), size_t(path.size()));
+    const auto length = socklen_t(offsetof(sockaddr_un, sun_path) + size_t(path.size())
+                                  + (path.at(0) ? 1 : 0));
+
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1)
+        return -1;
+    ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+    if (::bind(fd, reinterpret_cast<sockaddr *>(&address), length) == -1
+            || ::listen(fd, 50) == -1) {
+        const int error = errno;
+        ::close(fd);
+        errno = error;
+        return -1;
+    }
+    return fd;
+}
+#endif
+
+/*!
+    \internal
+
+    Opens one SO_REUSEPORT listening socket per worker thread on
+    \a address and \a port, each owned by its worker. Returns the port
+    the shards listen to, or 0 on failure.
+*/
+quint16 QAbstractHttpServerPrivate::listenSharded(const QHostAddress &address, quint16 port,
+                                                  const QHttpServerListenerOptions &options)
+{
+#if defined(Q_OS_UNIX) && defined(SO_REUSEPORT)
+    std::vector<QTcpServer *> shards;
+    for (auto worker : workers) {
+        const qintptr socketDescriptor = reusePortSocket(address, port);
+        if (socketDescriptor == -1) {
+            qCCritical(lcHttpServer, "listen failed: %s", qPrintable(qt_error_string(errno)));
+            break;
+        }
+
+        setListenerSocketOptions(socketDescriptor, options);
+        QTcpServer *shard = nullptr;
+        QMetaObject::invokeMethod(worker, [&]() {
+            shard = worker->listen(socketDescriptor);
+        }, Qt::BlockingQueuedConnection);
+        if (!shard) {
+            ::close(int(socketDescriptor));
+            break;
+        }
+
+        // The remaining shards share the port picked for the first one
+        port = shard->serverPort();
+        setListenerOptions(shard, options);
+        shards.push_back(shard);
+    }
+
+    if (shards.size() != workers.size()) {
+        for (auto shard : shards)
+            shard->deleteLater();
+        return 0;
+    }
+
+    shardServers.insert(shardServers.end(), shards.cbegin(), shards.cend());
+    return port;
+#else
+    Q_UNUSED(address);
+    Q_UNUSED(port);
+    Q_UNUSED(options);
+    return 0;
+#endif
+}
+
+/*!
+    \internal
+
+    Applies the options of \a options that belong to the listening
+    socket \a socketDescriptor, which is already listening.
+*/
+void QAbstractHttpServerPrivate::setListenerSocketOptions(qintptr socketDescriptor,
+                                                         const QHttpServerListenerOptions &options)
+{
+#if defined(Q_OS_UNIX)
+    const int fd = int(socketDescriptor);
+    const auto setOption = [fd](int level, int option, int value, const char *name) {
+        if (::setsockopt(fd, level, option, &value, sizeof(value)) == -1) {
+            qCWarning(lcHttpServer, "Cannot set %s on the listening socket: %s",
+                      name, qPrintable(qt_error_string(errno)));
+        }
+    };
+
+    // Accepted sockets inherit the buffer sizes of the listening socket
+    if (options.receiveBufferSize())
+        setOption(SOL_SOCKET, SO_RCVBUF, options.receiveBufferSize(), "SO_RCVBUF");
+    if (options.sendBufferSize())
+        setOption(SOL_SOCKET, SO_SNDBUF, options.sendBufferSize(), "SO_SNDBUF");
+
+    if (options.deferAcceptTimeout()) {
+#if defined(TCP_DEFER_ACCEPT)
+        setOption(IPPROTO_TCP, TCP_DEFER_ACCEPT, options.deferAcceptTimeout(), "TCP_DEFER_ACCEPT");
+#else
+        qCWarning(lcHttpServer, "TCP_DEFER_ACCEPT is not supported on this platform");
+#endif
+    }
+
+    if (options.fastOpenQueueLength()) {
+#if defined(TCP_FASTOPEN)
+        setOption(IPPROTO_TCP, TCP_FASTOPEN, options.fastOpenQueueLength(), "TCP_FASTOPEN");
+#else
+        qCWarning(lcHttpServer, "TCP_FASTOPEN is not supported on this platform");
+#endif
+    }
+
+    // Listening again only resizes the queue of pending connections
+    if (options.backlog() && ::listen(fd, options.backlog()) == -1) {
+        qCWarning(lcHttpServer, "Cannot set the backlog of the listening socket: %s",
+                  qPrintable(qt_error_string(errno)));
+    }
+#else
+    Q_UNUSED(socketDescriptor);
+    if (options.backlog() || options.deferAcceptTimeout() || options.fastOpenQueueLength()
+            || options.receiveBufferSize() || options.sendBufferSize()) {
+        qCWarning(lcHttpServer, "Listening socket options are not supported on this platform");
+    }
+#endif
+}
+
+/*!
+    \internal
+
+    Remembers \a options for the connections \a tcpServer accepts. Only
+    listeners with options are tracked.
+*/
+void QAbstractHttpServerPrivate::setListenerOptions(QTcpServer *tcpServer,
+                                                   const QHttpServerListenerOptions &options)
+{
+    if (!options.noDelay() && !options.corkResponses() && !options.receiveBufferSize()
+            && !options.sendBufferSize() && !options.proxyProtocol()) {
+        return;
+    }
+#if QT_CONFIG(ssl)
+    if (options.proxyProtocol() && qobject_cast<QSslServer *>(tcpServer)) {
+        qCWarning(lcHttpServer, "The PROXY protocol is not supported on TLS listeners, "
+                                "the header would precede the handshake");
+    }
+#endif
+
+    QMutexLocker locker(&listenerOptionsMutex);
+    listenerOptions.insert(tcpServer, options);
+    locker.unlock();
+    QObject::connect(tcpServer, &QObject::destroyed, [this, tcpServer]() {
+        QMutexLocker locker(&listenerOptionsMutex);
+        listenerOptions.remove(tcpServer);
+    });
+}
+
+/*!
+    \internal
+
+    Returns the options of the connections accepted by \a tcpServer.
+    Called from the thread of \a tcpServer, whichever it is.
+*/
+QHttpServerListenerOptions QAbstractHttpServerPrivate::listenerOptionsOf(
+        const QTcpServer *tcpServer)
+{
+    QMutexLocker locker(&listenerOptionsMutex);
+    return listenerOptions.value(tcpServer);
+}
+
 void QAbstractHttpServerPrivate::handleNewConnections()
 {
     Q_Q(QAbstractHttpServer);
     auto tcpServer = qobject_cast<QTcpServer *>(q->sender());
     Q_ASSERT(tcpServer);
-    while (auto socket = tcpServer->nextPendingConnection()) {
-        auto request = new QHttpServerRequest(socket->peerAddress());  // TODO own tcp server could pre-allocate it
-        QObject::connect(socket, &QTcpSocket::readyRead, q_ptr,
-                         [this, request, socket] () {
-            handleReadyRead(socket, request);
-        });
+    acceptConnections(tcpServer);
+}
 
-        QObject::connect(socket, &QTcpSocket::disconnected, socket, [request, socket] () {
-            if (!request->d->handling)
-                socket->deleteLater();
-        });
+void QAbstractHttpServerPrivate::acceptConnections(QTcpServer *tcpServer)
+{
+    if (workers.empty()) {
+        if (!localWorker)
+            localWorker.reset(new QHttpServerWorker(this));
+        localWorker->acceptConnections(tcpServer);
+        return;
+    }
 
-        QObject::connect(socket, &QObject::destroyed, socket, [request] () {
-            delete request;
-        });
+    const auto options = listenerOptionsOf(tcpServer);
+    QHostAddress countedAddress;
+    while (auto socket = nextPendingConnection(tcpServer, configuration, &countedAddress))
+        dispatchConnection(socket, options, countedAddress);
+}
+
+/*!
+    \internal
+
+    Returns the next pending connection of \a tcpServer within the limits
+    of \a configuration, or \c nullptr if there is none. Connections over
+    the limits are rejected, or left pending while \a tcpServer pauses.
+    Sets \a countedAddress to the address the connection counts against,
+    or to a null address if it is not counted per address. Both are
+    handed back to releaseConnection().
+
+    Called from the thread of \a tcpServer, whichever it is.
+*/
+QTcpSocket *QAbstractHttpServerPrivate::nextPendingConnection(
+        QTcpServer *tcpServer, const QHttpServerConfiguration &configuration,
+        QHostAddress *countedAddress)
+{
+    const int maxConnections = configuration.maxConnections();
+    const int maxConnectionsPerAddress = configuration.maxConnectionsPerAddress();
+    const bool pause =
+            configuration.overloadPolicy() == QHttpServerConfiguration::OverloadPolicy::PauseAccepting;
+
+    while (tcpServer->hasPendingConnections()) {
+        if (maxConnections && pause && connectionCount.loadAcquire() >= maxConnections) {
+            QMutexLocker locker(&admissionMutex);
+            // releaseConnection() resumes paused servers under the lock
+            if (connectionCount.loadAcquire() < maxConnections)
+                continue;
+            tcpServer->pauseAccepting();
+            pausedServers.emplace_back(tcpServer);
+            return nullptr;
+        }
+
+        auto socket = tcpServer->nextPendingConnection();
+        if (connectionCount.fetchAndAddAcquire(1) >= maxConnections && maxConnections) {
+            connectionCount.deref();
+            rejectConnection(socket, configuration);
+            continue;
+        }
+
+        // Unix domain sockets have no peer address to tell their clients apart
+        if (maxConnectionsPerAddress && !socket->peerAddress().isNull()) {
+            QMutexLocker locker(&admissionMutex);
+            int &count = addressConnectionCount[socket->peerAddress()];
+            if (count >= maxConnectionsPerAddress) {
+                locker.unlock();
+                connectionCount.deref();
+                rejectConnection(socket, configuration);
+                continue;
+            }
+            ++count;
+            *countedAddress = socket->peerAddress();
+        } else {
+            countedAddress->clear();
+        }
+        return socket;
     }
+    return nullptr;
 }
 
-void QAbstractHttpServerPrivate::handleReadyRead(QTcpSocket *socket,
-                                                 QHttpServerRequest *request)
+/*!
+    \internal
+
+    Answers \a socket with \c {503 Service Unavailable} and closes it.
+*/
+void QAbstractHttpServerPrivate::rejectConnection(QTcpSocket *socket,
+                                                  const QHttpServerConfiguration &configuration)
 {
-    Q_Q(QAbstractHttpServer);
-    Q_ASSERT(socket);
-    Q_ASSERT(request);
+    static const QByteArray statusLine = QByteArrayLiteral("HTTP/1.1 503 Service Unavailable\r\n");
+    static const QByteArray headers = QByteArrayLiteral("Connection: close\r\n"
+                                                        "Content-Length: 0\r\n"
+                                                        "\r\n");
+    socket->write(statusLine);
+    if (configuration.retryAfter())
+        socket->write("Retry-After: " + QByteArray::number(configuration.retryAfter()) + "\r\n");
+    socket->write(headers);
+    QObject::connect(socket, &QAbstractSocket::disconnected, socket, &QObject::deleteLater);
+    socket->disconnectFromHost();
+    if (socket->state() == QAbstractSocket::UnconnectedState)
+        socket->deleteLater();
+}
 
-    if (!socket->isTransactionStarted())
-        socket->startTransaction();
+/*!
+    \internal
 
-    if (request->d->state == QHttpServerRequestPrivate::State::OnMessageComplete)
-        request->d->clear();
+    Called from any thread when a connection closed, which counted
+    against \a countedAddress unless it is null. The accounting follows
+    what nextPendingConnection() did, the configuration might have
+    changed since. Resumes the listening sockets paused by
+    nextPendingConnection().
+*/
+void QAbstractHttpServerPrivate::releaseConnection(const QHostAddress &countedAddress)
+{
+    connectionCount.deref();
 
-    if (!request->d->parse(socket)) {
-        socket->disconnect();
+    QMutexLocker locker(&admissionMutex);
+    if (!countedAddress.isNull()) {
+        const auto it = addressConnectionCount.find(countedAddress);
+        if (it != addressConnectionCount.end() && --it.value() <= 0)
+            addressConnectionCount.erase(it);
+    }
+    if (pausedServers.empty())
         return;
+
+    const auto paused = std::move(pausedServers);
+    pausedServers.clear();
+    locker.unlock();
+    for (const auto &tcpServer : paused) {
+        if (!tcpServer)
+            continue;
+        QMetaObject::invokeMethod(tcpServer, [this, tcpServer]() {
+            if (!tcpServer)
+                return;
+            tcpServer->resumeAccepting();
+            // The connections pending since the pause were not announced again
+            if (auto worker = qobject_cast<QHttpServerWorker *>(tcpServer->parent()))
+                worker->acceptConnections(tcpServer);
+            else
+                acceptConnections(tcpServer);
+        }, Qt::QueuedConnection);
     }
+}
+
+void QAbstractHttpServerPrivate::dispatchConnection(QTcpSocket *socket,
+                                                    const QHttpServerListenerOptions &options,
+                                                    const QHostAddress &countedAddress)
+{
+    auto worker = *std::min_element(workers.cbegin(), workers.cend(),
+                                    [](const QHttpServerWorker *a, const QHttpServerWorker *b) {
+        return a->connectionCount.loadRelaxed() < b->connectionCount.loadRelaxed();
+    });
+
+    worker->connectionCount.ref();
+    socket->setParent(nullptr);
+    socket->moveToThread(worker->thread());
+    QMetaObject::invokeMethod(worker, [worker, socket, options, countedAddress]() {
+        worker->handleConnection(socket, options, countedAddress);
+    }, Qt::QueuedConnection);
+}
 
-    if (!request->d->httpParser.upgrade &&
-            request->d->state != QHttpServerRequestPrivate::State::OnMessageComplete)
-        return; // Partial read
+void QAbstractHttpServerPrivate::handleReadyRead(QHttpServerConnection *connection)
+{
+    Q_Q(QAbstractHttpServer);
+    auto socket = connection->socket;
+    auto request = &connection->request;
+    Q_ASSERT(socket);
 
-    if (request->d->httpParser.upgrade &&
-        request->d->httpParser.method != HTTP_CONNECT) { // Upgrade
-        const auto &upgradeValue = request->value(QByteArrayLiteral("upgrade"));
+    // A response to the current request is still being written, or the
+    // handler spins an event loop. The next request of a pipeline waits,
+    // QHttpServerConnection::endResponse() calls back once it is done.
+    // Only the streamed body of the current request keeps flowing.
+    if (request->d->handling
+            || (connection->pendingResponses && !request->d->isStreamingBody())) {
+        return;
+    }
+
+    do {
+        // The client does not read its responses, it can wait with
+        // further requests until it caught up
+        if (connection->isWriteBufferFull()) {
+            connection->pauseReading();
+            return;
+        }
+
+        // The handler reads the streamed body too slowly, the device calls
+        // back once it caught up
+        if (request->d->bodyDevice && request->d->bodyDevice->isFull()) {
+            connection->updateTimeout();
+            return;
+        }
+
+        if (request->d->state == QHttpServerRequestPrivate::State::OnMessageComplete)
+            request->d->clear();
+
+        if (!request->d->parse(socket)) {
+            connection->reject(request->d->errorStatus);
+            return;
+        }
+
+        if (request->d->http2Preface) {
+            connection->startHttp2();
+            return;
+        }
+
+        connection->updateTimeout();
+
+        if (request->d->state == QHttpServerRequestPrivate::State::OnHeadersComplete
+                && !request->d->headersHandled) {
+            request->d->headersHandled = true;
+            const bool streamed = streamRequest(connection);
+            // The route refused the request, its body is not worth reading
+            if (request->d->admission != QHttpServerResponder::StatusCode::Continue) {
+                connection->reject(request->d->admission);
+                return;
+            }
+            if (streamed && socket->state() == QAbstractSocket::UnconnectedState) {
+                socket->deleteLater();
+                return;
+            }
+            request->d->sendContinue(socket);
+            continue;
+        }
+
+        if (request->d->bodyDevice) {
+            // The handler of a streamed request might read from the device
+            // right away, but must not see the next request
+            request->d->handling = true;
+            request->d->bodyDevice->notify();
+            request->d->handling = false;
+            if (request->d->state != QHttpServerRequestPrivate::State::OnMessageComplete)
+                continue;
+            socket->setReadBufferSize(0);
+        } else {
+            const bool upgrade = request->d->httpParser.upgrade
+                    && request->d->httpParser.method != HTTP_CONNECT;
+            const auto &upgradeValue = request->value(QByteArrayLiteral("upgrade"));
+            const bool h2c = upgrade
+                    && upgradeValue.compare(QByteArrayLiteral("h2c"), Qt::CaseInsensitive) == 0;
+            // A request with a body would have to be read before
+            // switching, such clients get HTTP/1.1. Over TLS, ALPN
+            // negotiates HTTP/2 instead.
+            const bool upgradesToHttp2 = h2c
+                    && connection->worker->configuration.http2Enabled()
+                    && !connection->isStream
+                    && request->url().scheme() == QStringLiteral("http")
+                    && !(request->d->httpParser.flags & F_CHUNKED)
+                    && request->value(QByteArrayLiteral("content-length")).toLongLong() == 0;
+            // An h2c upgrade which is not taken is ignored, see RFC 7230,
+            // section 6.7, the request is served once complete
+            const bool ignoresUpgrade = h2c && !upgradesToHttp2;
+            if ((!request->d->httpParser.upgrade || ignoresUpgrade) &&
+                    request->d->state != QHttpServerRequestPrivate::State::OnMessageComplete)
+                return; // Partial read
+            if (ignoresUpgrade)
+                request->d->httpParser.upgrade = 0; // The next message is HTTP/1.1 as well
+
+            if (upgrade && !ignoresUpgrade) {
+                if (upgradesToHttp2) {
+                    socket->write("HTTP/1.1 101 Switching Protocols\r\n"
+                                  "Connection: Upgrade\r\n"
+                                  "Upgrade: h2c\r\n"
+                                  "\r\n");
+                    const auto d = request->d.data();
+                    const QByteArray message = d->buffer.mid(d->messageOffset,
+                                                             d->bufferOffset - d->messageOffset);
+                    connection->startHttp2(QHttpServerHttp2Connection::upgradedRequest(message),
+                                           request->value(QByteArrayLiteral("http2-settings")));
+                    return;
+                }
 #if defined(QT_WEBSOCKETS_LIB)
-        if (upgradeValue.compare(QByteArrayLiteral("websocket"), Qt::CaseInsensitive) == 0) {
-            static const auto signal = QMetaMethod::fromSignal(
-                        &QAbstractHttpServer::newWebSocketConnection);
-            if (q->isSignalConnected(signal)) {
-                QObject::disconnect(socket, &QTcpSocket::readyRead, nullptr, nullptr);
-                socket->rollbackTransaction();
-                websocketServer.handleConnection(socket);
-                Q_EMIT socket->readyRead();
-            } else {
-                qWarning(lcHttpServer, "WebSocket received but no slots connected to "
-                                       "QWebSocketServer::newConnection");
+                if (upgradeValue.compare(QByteArrayLiteral("websocket"), Qt::CaseInsensitive) == 0) {
+                    static const auto signal = QMetaMethod::fromSignal(
+                                &QAbstractHttpServer::newWebSocketConnection);
+                    if (q->isSignalConnected(signal)) {
+                        // Taking the socket away releases the connection, together
+                        // with the request, so neither can be used past this point.
+                        QObject::disconnect(socket, nullptr, connection, nullptr);
+                        request->d->unreadMessage(socket);
+                        if (socket->thread() == q->thread()) {
+                            socket->setParent(q);
+                            websocketServer.handleConnection(socket);
+                            Q_EMIT socket->readyRead();
+                        } else {
+                            // The WebSocket server lives in the thread of the HTTP
+                            // server, hand the socket back from the worker thread.
+                            socket->setParent(nullptr);
+                            socket->moveToThread(q->thread());
+                            QMetaObject::invokeMethod(q, [this, q, socket]() {
+                                socket->setParent(q);
+                                websocketServer.handleConnection(socket);
+                                Q_EMIT socket->readyRead();
+                            }, Qt::QueuedConnection);
+                        }
+                    } else {
+                        qWarning(lcHttpServer, "WebSocket received but no slots connected to "
+                                               "QWebSocketServer::newConnection");
+                        socket->disconnectFromHost();
+                    }
+                    return;
+                }
+#endif
+                qCWarning(lcHttpServer, "Upgrade to %s not supported", upgradeValue.constData());
                 socket->disconnectFromHost();
+                return;
             }
+
+            connection->worker->handledRequests.ref();
+            request->d->handling = true;
+            if (!q->handleRequest(*request, socket))
+                Q_EMIT q->missingHandler(*request, socket);
+            request->d->handling = false;
+        }
+
+        connection->requestHandled();
+        if (socket->state() == QAbstractSocket::UnconnectedState) {
+            socket->deleteLater();
             return;
         }
-#endif
-        qCWarning(lcHttpServer, "Upgrade to %s not supported", upgradeValue.constData());
-        socket->disconnectFromHost();
-        return;
-    }
 
-    socket->commitTransaction();
+        // Further pipelined requests are parsed from what is left
+    } while (socket->state() == QAbstractSocket::ConnectedState
+             && (!connection->pendingResponses || request->d->isStreamingBody())
+             && (request->d->hasPendingData() || socket->bytesAvailable()));
+}
+
+/*!
+    \internal
+
+    Offers the request of \a connection, whose headers just arrived, to
+    QAbstractHttpServer::handleRequestHeaders(). Returns \c true if its
+    body is streamed from now on.
+*/
+bool QAbstractHttpServerPrivate::streamRequest(QHttpServerConnection *connection)
+{
+    Q_Q(QAbstractHttpServer);
+    auto socket = connection->socket;
+    auto request = &connection->request;
+
+    request->d->bodyDevice.reset(new QHttpServerBodyDevice);
     request->d->handling = true;
-    if (!q->handleRequest(*request, socket))
-        Q_EMIT q->missingHandler(*request, socket);
+    const bool streamed = q->handleRequestHeaders(*request, socket);
     request->d->handling = false;
-    if (socket->state() == QAbstractSocket::UnconnectedState)
-        socket->deleteLater();
+    if (!streamed) {
+        request->d->bodyDevice.reset();
+        return false;
+    }
+
+    connection->worker->handledRequests.ref();
+    request->d->bodyDevice->drained = [connection]() { connection->resume(); };
+    // Let the kernel hold the client back while the handler catches up
+    socket->setReadBufferSize(QHttpServerBodyDevice::HighWatermark);
+    return true;
 }
 
 QAbstractHttpServer::QAbstractHttpServer(QObject *parent)
@@ -144,23 +829,61 @@ QAbstractHttpServer::QAbstractHttpServer(QAbstractHttpServerPrivate &dd, QObject
 #endif
 }
 
+/*!
+    Destroys the HTTP server. Worker threads, if any, are stopped and
+    the connections they own are closed.
+*/
+QAbstractHttpServer::~QAbstractHttpServer()
+{
+    Q_D(QAbstractHttpServer);
+    d->stopWorkers();
+    d->localWorker.reset();
+}
+
 /*!
     Tries to bind a \c QTcpServer to \a address and \a port.
 
+    With QHttpServerConfiguration::listenerSharding() enabled, every
+    worker thread gets a listening socket of its own instead, all bound
+    to the same \a address and \a port.
+
     Returns the server port upon success, 0 otherwise.
 */
 quint16 QAbstractHttpServer::listen(const QHostAddress &address, quint16 port)
 {
-#if QT_CONFIG(ssl)
+    return listen(address, port, QHttpServerListenerOptions());
+}
+
+/*!
+    \overload
+
+    Tries to bind a \c QTcpServer to \a address and \a port, with the
+    socket options \a options applied to the listening socket and to
+    every connection it accepts.
+
+    \sa QHttpServerListenerOptions
+*/
+quint16 QAbstractHttpServer::listen(const QHostAddress &address, quint16 port,
+                                    const QHttpServerListenerOptions &options)
+{
     Q_D(QAbstractHttpServer);
-    QTcpServer *tcpServer = d->sslEnabled ? new QSslServer(d->sslConfiguration, this)
-                                          : new QTcpServer(this);
+    if (d->draining) {
+        qCWarning(lcHttpServer, "The server was drained, it cannot listen again");
+        return 0;
+    }
+    if (d->configuration.listenerSharding() && d->configuration.workerThreadCount() > 0) {
+        d->startWorkers();
+#if defined(Q_OS_UNIX) && defined(SO_REUSEPORT)
+        return d->listenSharded(address, port, options);
 #else
-    auto tcpServer = new QTcpServer(this);
+        qCWarning(lcHttpServer, "Listener sharding is not supported on this platform");
 #endif
+    }
+
+    auto tcpServer = d->createTcpServer(this);
     const auto listening = tcpServer->listen(address, port);
     if (listening) {
-        bind(tcpServer);
+        bind(tcpServer, options);
         return tcpServer->serverPort();
     } else {
         qCCritical(lcHttpServer, "listen failed: %s",
@@ -171,9 +894,95 @@ quint16 QAbstractHttpServer::listen(const QHostAddress &address, quint16 port)
     return 0;
 }
 
+/*!
+    Tries to listen to the Unix domain socket \a name, a file system path.
+    On Linux, a \a name starting with \c {@} is a name in the abstract
+    namespace instead, which needs no file and vanishes with the server.
+
+    A local reverse proxy reaches the server over this socket without the
+    TCP stack. The connections are handled like TCP connections: the
+    handlers get them as a QTcpSocket, whose peer address is null, and
+    QHttpServerRequest::remoteAddress() is null as well. The per-address
+    limit of QHttpServerConfiguration does not apply to them.
+
+    The socket file is removed when the listener is destroyed. A file left
+    over by a crashed process makes listening fail, it has to be removed
+    first.
+
+    Returns \c true on success.
+
+    \sa listen(), servers()
+*/
+bool QAbstractHttpServer::listenLocal(const QString &name)
+{
+    return listenLocal(name, QHttpServerListenerOptions());
+}
+
+/*!
+    \overload
+
+    Tries to listen to the Unix domain socket \a name, with \a options
+    applied to the listening socket and to every connection it accepts.
+    The TCP specific options do not apply to Unix domain sockets.
+
+    \sa QHttpServerListenerOptions
+*/
+bool QAbstractHttpServer::listenLocal(const QString &name,
+                                      const QHttpServerListenerOptions &options)
+{
+#if defined(Q_OS_UNIX)
+    Q_D(QAbstractHttpServer);
+    if (d->draining) {
+        qCWarning(lcHttpServer, "The server was drained, it cannot listen again");
+        return false;
+    }
+    QByteArray path = QFile::encodeName(name);
+#  if defined(Q_OS_LINUX)
+    const bool abstract = path.startsWith('@');
+    if (abstract)
+        path[0] = '\0';
+#  else
+    const bool abstract = false;
+#  endif
+
+    const qintptr socketDescriptor = localSocket(path);
+    if (socketDescriptor == -1) {
+        qCCritical(lcHttpServer, "listen on %s failed: %s", qPrintable(name),
+                   qPrintable(qt_error_string(errno)));
+        return false;
+    }
+
+    // QTcpServer accepts from any stream socket, so the connections take
+    // the same path as the TCP ones
+    auto tcpServer = d->createTcpServer(this);
+    if (!tcpServer->setSocketDescriptor(socketDescriptor)) {
+        qCCritical(lcHttpServer, "listen on %s failed: %s", qPrintable(name),
+                   qPrintable(tcpServer->errorString()));
+        delete tcpServer;
+        ::close(int(socketDescriptor));
+        if (!abstract)
+            ::unlink(path.constData());
+        return false;
+    }
+
+    if (!abstract) {
+        QObject::connect(tcpServer, &QObject::destroyed, [path]() {
+            ::unlink(path.constData());
+        });
+    }
+    bind(tcpServer, options);
+    return true;
+#else
+    Q_UNUSED(name);
+    Q_UNUSED(options);
+    qCCritical(lcHttpServer, "Unix domain sockets are not supported on this platform");
+    return false;
+#endif
+}
+
 /*!
     Returns the list of ports this instance of QAbstractHttpServer
-    is listening to.
+    is listening to. The listeners of listenLocal() have port 0.
 
     This function has the same guarantee as QObject::children,
     the latest server added is the last entry in the vector.
@@ -183,7 +992,7 @@ quint16 QAbstractHttpServer::listen(const QHostAddress &address, quint16 port)
 QVector<quint16> QAbstractHttpServer::serverPorts()
 {
     QVector<quint16> ports;
-    auto children = findChildren<QTcpServer *>();
+    const auto children = servers();
     ports.reserve(children.count());
     std::transform(children.cbegin(), children.cend(), std::back_inserter(ports),
                    [](const QTcpServer *server) { return server->serverPort(); });
@@ -212,8 +1021,31 @@ QVector<quint16> QAbstractHttpServer::serverPorts()
     \sa QTcpServer, QTcpServer::listen()
 */
 void QAbstractHttpServer::bind(QTcpServer *server)
+{
+    bind(server, QHttpServerListenerOptions());
+}
+
+/*!
+    \overload
+
+    Binds the HTTP server to the TCP \a server, with the socket options
+    \a options applied to \a server and to every connection it accepts.
+    The options of the listening socket need \a server to be listening
+    already.
+
+    \sa QHttpServerListenerOptions
+*/
+void QAbstractHttpServer::bind(QTcpServer *server, const QHttpServerListenerOptions &options)
 {
     Q_D(QAbstractHttpServer);
+    if (d->draining) {
+        qCWarning(lcHttpServer, "The server was drained, it cannot listen again");
+        if (server) {
+            server->setParent(this);
+            server->close();
+        }
+        return;
+    }
     if (!server) {
         server = new QTcpServer(this);
         if (!server->listen()) {
@@ -225,6 +1057,10 @@ void QAbstractHttpServer::bind(QTcpServer *server)
             qCWarning(lcHttpServer) << "The TCP server" << server << "is not listening.";
         server->setParent(this);
     }
+    if (server->isListening())
+        d->setListenerSocketOptions(server->socketDescriptor(), options);
+    d->setListenerOptions(server, options);
+    d->startWorkers();
     QObjectPrivate::connect(server, &QTcpServer::newConnection,
                             d, &QAbstractHttpServerPrivate::handleNewConnections,
                             Qt::UniqueConnection);
@@ -233,11 +1069,223 @@ void QAbstractHttpServer::bind(QTcpServer *server)
 /*!
     Returns list of child TCP servers of this HTTP server.
 
+    The listener shards created by listen() when
+    QHttpServerConfiguration::listenerSharding() is enabled come last.
+    They live in the worker threads, not in the thread of this server.
+
     \sa serverPorts()
  */
 QVector<QTcpServer *> QAbstractHttpServer::servers() const
 {
-    return findChildren<QTcpServer *>().toVector();
+    Q_D(const QAbstractHttpServer);
+    auto servers = findChildren<QTcpServer *>().toVector();
+    for (auto shard : d->shardServers)
+        servers.append(shard);
+    return servers;
+}
+
+/*!
+    \class QHttpServerWorkerStatistics
+    \brief The QHttpServerWorkerStatistics struct holds the counters of
+    one worker thread of a QAbstractHttpServer.
+
+    With QHttpServerConfiguration::listenerSharding() enabled, each worker
+    is one listener shard, so comparing the entries of
+    QAbstractHttpServer::workerStatistics() shows how evenly the kernel
+    balances the incoming connections.
+*/
+
+/*!
+    \variable QHttpServerWorkerStatistics::acceptedConnections
+    The number of connections the worker has taken over since it started.
+*/
+
+/*!
+    \variable QHttpServerWorkerStatistics::activeConnections
+    The number of connections the worker currently owns.
+*/
+
+/*!
+    \variable QHttpServerWorkerStatistics::handledRequests
+    The number of requests the worker has passed to
+    QAbstractHttpServer::handleRequest().
+*/
+
+/*!
+    \variable QHttpServerWorkerStatistics::readPauses
+    The number of times the worker stopped reading from a connection
+    because of QHttpServerConfiguration::writeBufferHighWatermark().
+*/
+
+/*!
+    \variable QHttpServerWorkerStatistics::pausedConnections
+    The number of connections the worker currently does not read from,
+    waiting for their client to read its responses.
+*/
+
+/*!
+    Returns a snapshot of the counters of every worker thread, in the
+    order the threads were started. The list is empty when the server
+    has no worker threads.
+
+    \sa QHttpServerConfiguration::setWorkerThreadCount()
+*/
+QVector<QHttpServerWorkerStatistics> QAbstractHttpServer::workerStatistics() const
+{
+    Q_D(const QAbstractHttpServer);
+    QVector<QHttpServerWorkerStatistics> statistics;
+    statistics.reserve(int(d->workers.size()));
+    for (const auto worker : d->workers) {
+        QHttpServerWorkerStatistics entry;
+        entry.acceptedConnections = worker->acceptedConnections.loadRelaxed();
+        entry.activeConnections = worker->connectionCount.loadRelaxed();
+        entry.handledRequests = worker->handledRequests.loadRelaxed();
+        entry.readPauses = worker->readPauses.loadRelaxed();
+        entry.pausedConnections = worker->pausedConnections.loadRelaxed();
+        statistics.append(entry);
+    }
+    return statistics;
+}
+
+/*!
+    Stops accepting connections and closes the open ones once they are
+    done, for a graceful shutdown or restart. drained() is emitted when
+    the last connection is closed.
+
+    All listening sockets are closed, including the shards of every
+    worker thread. Connections waiting for their next request are closed
+    right away. The others finish the request they are receiving or
+    handling, including responses still being produced, for example by
+    a QHttpServerFutureResponse, and are closed after it. Those responses
+    carry a \c {Connection: close} header, so keep-alive clients know to
+    reconnect, presumably to another instance.
+
+    Connections still open after \a msecs milliseconds are aborted,
+    dropping what they have not sent yet. A value of zero or less waits
+    for them without limit.
+
+    The server cannot listen again afterwards, listen(), listenLocal()
+    and bind() fail with a warning. The servers passed to bind() are
+    closed.
+
+    \sa isDraining(), drained()
+*/
+void QAbstractHttpServer::drain(int msecs)
+{
+    Q_D(QAbstractHttpServer);
+    if (d->draining)
+        return;
+    d->draining = true;
+
+    const auto tcpServers = findChildren<QTcpServer *>();
+    for (auto tcpServer : tcpServers)
+        tcpServer->close();
+    // The workers close the shards they own
+    d->shardServers.clear();
+
+    std::vector<QHttpServerWorker *> workers = d->workers;
+    if (d->localWorker)
+        workers.push_back(d->localWorker.get());
+    d->drainingWorkers = int(workers.size());
+    if (workers.empty()) {
+        QMetaObject::invokeMethod(this, &QAbstractHttpServer::drained, Qt::QueuedConnection);
+        return;
+    }
+
+    for (auto worker : workers)
+        QMetaObject::invokeMethod(worker, [worker]() { worker->drain(); }, Qt::QueuedConnection);
+
+    if (msecs > 0) {
+        d->drainTimer.setSingleShot(true);
+        QObjectPrivate::connect(&d->drainTimer, &QTimer::timeout,
+                                d, &QAbstractHttpServerPrivate::abortDrain);
+        d->drainTimer.start(msecs);
+    }
+}
+
+/*!
+    Returns \c true once drain() was called.
+
+    \sa drain()
+*/
+bool QAbstractHttpServer::isDraining() const
+{
+    Q_D(const QAbstractHttpServer);
+    return d->draining;
+}
+
+/*!
+    \fn void QAbstractHttpServer::drained()
+
+    This signal is emitted once all the connections are closed after
+    drain() was called.
+*/
+
+void QAbstractHttpServerPrivate::workerDrained()
+{
+    Q_Q(QAbstractHttpServer);
+    if (--drainingWorkers)
+        return;
+    drainTimer.stop();
+    Q_EMIT q->drained();
+}
+
+void QAbstractHttpServerPrivate::abortDrain()
+{
+    qCWarning(lcHttpServer, "Drain timed out, aborting the remaining connections");
+    for (auto worker : workers)
+        QMetaObject::invokeMethod(worker, [worker]() { worker->abortConnections(); });
+    if (localWorker)
+        localWorker->abortConnections();
+}
+
+/*!
+    Sets the configuration of this HTTP server to \a configuration.
+
+    \sa configuration(), QHttpServerConfiguration
+*/
+void QAbstractHttpServer::setConfiguration(const QHttpServerConfiguration &configuration)
+{
+    Q_D(QAbstractHttpServer);
+    if (!d->workers.empty()
+            && configuration.workerThreadCount() != d->configuration.workerThreadCount()) {
+        qCWarning(lcHttpServer, "The worker threads are already running, "
+                                "the new worker thread count is ignored");
+    }
+    d->configuration = configuration;
+#if QT_CONFIG(ssl)
+    d->sslSessionCache.setLifetime(configuration.sslSessionLifetime());
+    for (auto tcpServer : servers()) {
+        auto sslServer = qobject_cast<QSslServer *>(tcpServer);
+        if (!sslServer)
+            continue;
+        // Listener shards live in the worker threads
+        QMetaObject::invokeMethod(sslServer, [sslServer, configuration]() {
+            sslServer->setMaxConcurrentHandshakes(configuration.maxConcurrentSslHandshakes());
+            sslServer->setHandshakeTimeout(configuration.sslHandshakeTimeout());
+        });
+    }
+#endif
+
+    // Each worker has a copy of its own, for its thread to read
+    if (d->localWorker)
+        d->localWorker->configuration = configuration;
+    for (auto worker : d->workers) {
+        QMetaObject::invokeMethod(worker, [worker, configuration]() {
+            worker->configuration = configuration;
+        }, Qt::QueuedConnection);
+    }
+}
+
+/*!
+    Returns the configuration of this HTTP server.
+
+    \sa setConfiguration()
+*/
+QHttpServerConfiguration QAbstractHttpServer::configuration() const
+{
+    Q_D(const QAbstractHttpServer);
+    return d->configuration;
 }
 
 #if defined(QT_WEBSOCKETS_LIB)
@@ -281,6 +1329,30 @@ QWebSocket *QAbstractHttpServer::nextPendingWebSocketConnection()
 }
 #endif
 
+/*!
+    Called once the headers of a \a request with a body arrived on
+    \a socket, before any of the body is read.
+
+    Reimplement this function to handle requests whose body is streamed.
+    Return \c true after taking over the request, which then delivers its
+    body through QHttpServerRequest::bodyDevice(), and handleRequest() is
+    not called for it. Return \c false to have the body read completely
+    before handleRequest() is called.
+
+    Requests sent with \c {Expect: 100-continue} are answered with
+    \c {100 Continue} once this function returns, so their client starts
+    sending the body.
+
+    The default implementation returns \c false.
+*/
+bool QAbstractHttpServer::handleRequestHeaders(const QHttpServerRequest &request,
+                                               QTcpSocket *socket)
+{
+    Q_UNUSED(request);
+    Q_UNUSED(socket);
+    return false;
+}
+
 QHttpServerResponder QAbstractHttpServer::makeResponder(const QHttpServerRequest &request,
                                                         QTcpSocket *socket)
 {
@@ -299,11 +1371,100 @@ void QAbstractHttpServer::sslSetup(const QSslCertificate &certificate,
     sslSetup(conf);
 }
 
+/*!
+    Makes the server speak TLS with \a sslConfiguration.
+
+    The listeners created by listen() and bind() from then on use it. So
+    do the ones created before, for their next handshakes, which lets
+    certificates and keys be renewed without restarting the server. The
+    connections already established keep theirs.
+
+    \sa sslSetupFromFiles()
+*/
 void QAbstractHttpServer::sslSetup(const QSslConfiguration &sslConfiguration)
 {
     Q_D(QAbstractHttpServer);
     d->sslConfiguration = sslConfiguration;
     d->sslEnabled = true;
+    d->updateSslServers();
+}
+
+/*!
+    Makes the server speak TLS with the certificate chain read from
+    \a certificateFile and the private key read from \a privateKeyFile,
+    both in PEM format, keeping the rest of the configuration given to
+    sslSetup() before if any. Returns \c false, leaving the configuration
+    unchanged, if either cannot be read.
+
+    Like sslSetup(), this applies to the listeners already created as well.
+    If \a watch is \c true, the files are read again whenever they change,
+    a second after the last change so that both are written by then. A
+    renewed certificate is then used without restarting the server.
+
+    \sa sslSetup()
+*/
+bool QAbstractHttpServer::sslSetupFromFiles(const QString &certificateFile,
+                                            const QString &privateKeyFile, bool watch)
+{
+    Q_D(QAbstractHttpServer);
+    d->sslCertificateFile = certificateFile;
+    d->sslPrivateKeyFile = privateKeyFile;
+#if QT_CONFIG(filesystemwatcher)
+    d->sslFileWatcher.reset();
+    if (watch) {
+        d->sslFileWatcher.reset(new QFileSystemWatcher({ certificateFile, privateKeyFile }));
+        d->sslReloadTimer.setSingleShot(true);
+        d->sslReloadTimer.setInterval(1000);
+        QObjectPrivate::connect(&d->sslReloadTimer, &QTimer::timeout,
+                                d, &QAbstractHttpServerPrivate::reloadSslFiles,
+                                Qt::UniqueConnection);
+        connect(d->sslFileWatcher.get(), &QFileSystemWatcher::fileChanged,
+                &d->sslReloadTimer, QOverload<>::of(&QTimer::start));
+    }
+#else
+    if (watch)
+        qCWarning(lcHttpServer, "Files cannot be watched on this platform");
+#endif
+    return d->loadSslFiles();
+}
+
+/*!
+    Returns the TLS session cache shared by the listeners of this server,
+    to read its hit and miss counters.
+
+    \sa QHttpServerConfiguration::setSslSessionLifetime()
+*/
+QSslServerSessionCache QAbstractHttpServer::sslSessionCache() const
+{
+    Q_D(const QAbstractHttpServer);
+    return d->sslSessionCache;
+}
+
+/*!
+    Returns the TLS handshake counters of all the listeners of this
+    server, listener shards included, added up. The maximal latency is
+    the one of the slowest listener.
+
+    \sa QHttpServerConfiguration::setMaxConcurrentSslHandshakes(),
+        QHttpServerConfiguration::setSslHandshakeTimeout()
+*/
+QSslServerHandshakeStatistics QAbstractHttpServer::sslHandshakeStatistics() const
+{
+    QSslServerHandshakeStatistics total;
+    for (auto tcpServer : servers()) {
+        auto sslServer = qobject_cast<QSslServer *>(tcpServer);
+        if (!sslServer)
+            continue;
+        const auto statistics = sslServer->handshakeStatistics();
+        total.completed += statistics.completed;
+        total.failed += statistics.failed;
+        total.timedOut += statistics.timedOut;
+        total.inProgress += statistics.inProgress;
+        total.queued += statistics.queued;
+        total.totalLatency += statistics.totalLatency;
+        total.maxLatency = qMax(total.maxLatency, statistics.maxLatency);
+    }
+    return total;
 }
 #endif
 
@@ -44,12 +44,23 @@
 
 QT_BEGIN_NAMESPACE
 
+class QHttpServerConfiguration;
+class QHttpServerListenerOptions;
 class QHttpServerRequest;
 class QHttpServerResponder;
 class QTcpServer;
 class QTcpSocket;
 class QWebSocket;
 
+struct QHttpServerWorkerStatistics
+{
+    quint64 acceptedConnections = 0;
+    int activeConnections = 0;
+    quint64 handledRequests = 0;
+    quint64 readPauses = 0;
+    int pausedConnections = 0;
+};
+
 class QAbstractHttpServerPrivate;
 class Q_HTTPSERVER_EXPORT QAbstractHttpServer : public QObject
 {
@@ -57,21 +68,41 @@ class Q_HTTPSERVER_EXPORT QAbstractHttpServer : public QObject
 
 public:
     QAbstractHttpServer(QObject *parent = nullptr);
+    ~QAbstractHttpServer() override;
 
     quint16 listen(const QHostAddress &address = QHostAddress::Any, quint16 port = 0);
+    quint16 listen(const QHostAddress &address, quint16 port,
+                   const QHttpServerListenerOptions &options);
+    bool listenLocal(const QString &name);
+    bool listenLocal(const QString &name, const QHttpServerListenerOptions &options);
     QVector<quint16> serverPorts();
 
     void bind(QTcpServer *server = nullptr);
+    void bind(QTcpServer *server, const QHttpServerListenerOptions &options);
     QVector<QTcpServer *> servers() const;
 
+    void setConfiguration(const QHttpServerConfiguration &configuration);
+    QHttpServerConfiguration configuration() const;
+
+    QVector<QHttpServerWorkerStatistics> workerStatistics() const;
+
+    void drain(int msecs = 30000);
+    bool isDraining() const;
+
 #if QT_CONFIG(ssl)
     void sslSetup(const QSslCertificate &certificate, const QSslKey &privateKey,
                   QSsl::SslProtocol protocol = QSsl::SecureProtocols);
     void sslSetup(const QSslConfiguration &sslConfiguration);
+    bool sslSetupFromFiles(const QString &certificateFile, const QString &privateKeyFile,
+                           bool watch = false);
+
+    QSslServerSessionCache sslSessionCache() const;
+    QSslServerHandshakeStatistics sslHandshakeStatistics() const;
 #endif
 
 Q_SIGNALS:
     void missingHandler(const QHttpServerRequest &request, QTcpSocket *socket);
+    void drained();
 
 #if defined(QT_WEBSOCKETS_LIB)
     void newWebSocketConnection();
@@ -85,6 +116,7 @@ protected:
     QAbstractHttpServer(QAbstractHttpServerPrivate &dd, QObject *parent = nullptr);
 
     virtual bool handleRequest(const QHttpServerRequest &request, QTcpSocket *socket) = 0;
+    virtual bool handleRequestHeaders(const QHttpServerRequest &request, QTcpSocket *socket);
     static QHttpServerResponder makeResponder(const QHttpServerRequest &request,
                                               QTcpSocket *socket);
 
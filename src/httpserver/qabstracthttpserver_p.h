@@ -41,17 +41,34 @@
 // We mean it.
 
 #include <QtHttpServer/qabstracthttpserver.h>
+#include <QtHttpServer/qhttpserverconfiguration.h>
+#include <QtHttpServer/qhttpserverlisteneroptions.h>
 #include <QtHttpServer/qthttpserverglobal.h>
 
 #include <private/qobject_p.h>
 
+#if QT_CONFIG(filesystemwatcher)
+#include <QtCore/qfilesystemwatcher.h>
+#endif
+#include <QtCore/qhash.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qpointer.h>
+#include <QtCore/qthread.h>
+#include <QtCore/qtimer.h>
+#include <QtNetwork/qhostaddress.h>
+
 #if defined(QT_WEBSOCKETS_LIB)
 #include <QtWebSockets/qwebsocketserver.h>
 #endif // defined(QT_WEBSOCKETS_LIB)
 
+#include <memory>
+#include <vector>
+
 QT_BEGIN_NAMESPACE
 
-class QHttpServerRequest;
+class QHttpServerConnection;
+class QHttpServerWorker;
+class QTcpServer;
 
 class Q_HTTPSERVER_EXPORT QAbstractHttpServerPrivate: public QObjectPrivate
 {
@@ -59,6 +76,7 @@ class Q_HTTPSERVER_EXPORT QAbstractHttpServerPrivate: public QObjectPrivate
 
 public:
     QAbstractHttpServerPrivate();
+    ~QAbstractHttpServerPrivate() override;
 
 #if defined(QT_WEBSOCKETS_LIB)
     QWebSocketServer websocketServer {
@@ -67,13 +85,72 @@ public:
     };
 #endif // defined(QT_WEBSOCKETS_LIB)
 
+    QHttpServerConfiguration configuration;
+
+    std::unique_ptr<QHttpServerWorker> localWorker;
+    std::vector<std::unique_ptr<QThread>> workerThreads;
+    std::vector<QHttpServerWorker *> workers;
+    std::vector<QTcpServer *> shardServers;
+
+    bool draining = false;
+    int drainingWorkers = 0;
+    QTimer drainTimer;
+    void workerDrained();
+    void abortDrain();
+
+    void startWorkers();
+    void stopWorkers();
+
+    QTcpServer *createTcpServer(QObject *parent);
+    quint16 listenSharded(const QHostAddress &address, quint16 port,
+                          const QHttpServerListenerOptions &options);
+
+    // Listeners with options for the sockets they accept, from any thread
+    QMutex listenerOptionsMutex;
+    QHash<const QTcpServer *, QHttpServerListenerOptions> listenerOptions;
+    static void setListenerSocketOptions(qintptr socketDescriptor,
+                                         const QHttpServerListenerOptions &options);
+    void setListenerOptions(QTcpServer *tcpServer, const QHttpServerListenerOptions &options);
+    QHttpServerListenerOptions listenerOptionsOf(const QTcpServer *tcpServer);
+
+    // Connections of all the threads, see QHttpServerConfiguration::setMaxConnections()
+    QAtomicInt connectionCount;
+    QMutex admissionMutex;
+    QHash<QHostAddress, int> addressConnectionCount;
+    std::vector<QPointer<QTcpServer>> pausedServers;
+
+    QTcpSocket *nextPendingConnection(QTcpServer *tcpServer,
+                                      const QHttpServerConfiguration &configuration,
+                                      QHostAddress *countedAddress);
+    void rejectConnection(QTcpSocket *socket, const QHttpServerConfiguration &configuration);
+    void releaseConnection(const QHostAddress &countedAddress);
+
     void handleNewConnections();
-    void handleReadyRead(QTcpSocket *socket,
-                         QHttpServerRequest *request);
+    void acceptConnections(QTcpServer *tcpServer);
+    void dispatchConnection(QTcpSocket *socket, const QHttpServerListenerOptions &options,
+                            const QHostAddress &countedAddress);
+    void handleReadyRead(QHttpServerConnection *connection);
+    bool streamRequest(QHttpServerConnection *connection);
 
 #if QT_CONFIG(ssl)
     QSslConfiguration sslConfiguration;
+    QSslServerSessionCache sslSessionCache;
     bool sslEnabled = false;
+
+    // The listeners created for sslConfiguration, from any thread
+    QMutex sslServersMutex;
+    std::vector<QPointer<QSslServer>> sslServers;
+    QSslConfiguration listenerSslConfiguration() const;
+    void updateSslServers();
+
+    QString sslCertificateFile;
+    QString sslPrivateKeyFile;
+    bool loadSslFiles();
+#if QT_CONFIG(filesystemwatcher)
+    std::unique_ptr<QFileSystemWatcher> sslFileWatcher;
+    QTimer sslReloadTimer;
+    void reloadSslFiles();
+#endif
 #endif
 };
 
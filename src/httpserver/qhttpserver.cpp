@@ -63,11 +63,12 @@ Q_LOGGING_CATEGORY(lcHS, "qt.httpserver");
 QHttpServer::QHttpServer(QObject *parent)
     : QAbstractHttpServer(*new QHttpServerPrivate, parent)
 {
+    // Direct: missingHandler might be emitted from a worker thread
     connect(this, &QAbstractHttpServer::missingHandler, this,
             [=] (const QHttpServerRequest &request, QTcpSocket *socket) {
         qCDebug(lcHS) << tr("missing handler:") << request.url().path();
         sendResponse(QHttpServerResponder::StatusCode::NotFound, request, socket);
-    });
+    }, Qt::DirectConnection);
 }
 
 /*! \fn template<typename Rule = QHttpServerRouterRule, typename ... Args> bool route(Args && ... args)
@@ -180,4 +181,13 @@ bool QHttpServer::handleRequest(const QHttpServerRequest &request, QTcpSocket *s
     return d->router.handleRequest(request, socket);
 }
 
+/*!
+    \internal
+*/
+bool QHttpServer::handleRequestHeaders(const QHttpServerRequest &request, QTcpSocket *socket)
+{
+    Q_D(QHttpServer);
+    return d->router.handleRequestHeaders(request, socket);
+}
+
 QT_END_NAMESPACE
@@ -211,6 +211,8 @@ private:
     }
 
     bool handleRequest(const QHttpServerRequest &request, QTcpSocket *socket) override final;
+    bool handleRequestHeaders(const QHttpServerRequest &request,
+                              QTcpSocket *socket) override final;
 
     void sendResponse(QHttpServerResponse &&response,
                       const QHttpServerRequest &request,
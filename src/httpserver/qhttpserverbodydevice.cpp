@@ -0,0 +1,150 @@
+/****************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtHttpServer module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <private/qhttpserverbodydevice_p.h>
+
+#include <cstring>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \internal
+    \class QHttpServerBodyDevice
+
+    The sequential, read-only device QHttpServerRequest::bodyDevice()
+    returns for the body of a request which is streamed to its handler.
+
+    The parser appends the body as it arrives, and the server calls
+    notify() once it is done with a read from the socket, so that
+    readyRead() and readChannelFinished() are never emitted from within
+    the parser.
+*/
+
+QHttpServerBodyDevice::QHttpServerBodyDevice()
+{
+    open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+}
+
+QHttpServerBodyDevice::~QHttpServerBodyDevice()
+{
+}
+
+bool QHttpServerBodyDevice::isSequential() const
+{
+    return true;
+}
+
+qint64 QHttpServerBodyDevice::bytesAvailable() const
+{
+    return buffered() + QIODevice::bytesAvailable();
+}
+
+bool QHttpServerBodyDevice::atEnd() const
+{
+    return finished && bytesAvailable() == 0;
+}
+
+/*!
+    \internal
+
+    Appends \a size bytes of body from \a data.
+*/
+void QHttpServerBodyDevice::append(const char *data, qint64 size)
+{
+    if (!size)
+        return;
+    // A reader which never empties the buffer would let the consumed part
+    // grow with the whole body, so drop it once it is worth the move.
+    if (offset && (offset == buffer.size() || offset >= LowWatermark)) {
+        buffer.remove(0, offset);
+        offset = 0;
+    }
+    buffer.append(data, int(size));
+    readyReadPending = true;
+    blocked = blocked || isFull();
+}
+
+/*!
+    \internal
+
+    Marks the end of the body.
+*/
+void QHttpServerBodyDevice::finish()
+{
+    finished = true;
+    finishedPending = true;
+}
+
+/*!
+    \internal
+
+    Emits the signals for what was appended, or for the end of the body,
+    since the last call.
+*/
+void QHttpServerBodyDevice::notify()
+{
+    if (readyReadPending) {
+        readyReadPending = false;
+        Q_EMIT readyRead();
+    }
+    if (finishedPending) {
+        finishedPending = false;
+        Q_EMIT readChannelFinished();
+    }
+}
+
+qint64 QHttpServerBodyDevice::readData(char *data, qint64 maxSize)
+{
+    const qint64 size = qMin(maxSize, buffered());
+    if (!size)
+        return finished ? -1 : 0;
+
+    std::memcpy(data, buffer.constData() + offset, std::size_t(size));
+    offset += int(size);
+    if (offset == buffer.size()) {
+        buffer.resize(0);
+        offset = 0;
+    }
+
+    if (blocked && buffered() < LowWatermark) {
+        blocked = false;
+        if (drained)
+            drained();
+    }
+    return size;
+}
+
+qint64 QHttpServerBodyDevice::writeData(const char *data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,95 @@
+/****************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtHttpServer module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QHTTPSERVERBODYDEVICE_P_H
+#define QHTTPSERVERBODYDEVICE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists for the convenience
+// of QHttpServer. This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+
+#include <QtHttpServer/qthttpserverglobal.h>
+
+#include <QtCore/qbytearray.h>
+#include <QtCore/qiodevice.h>
+
+#include <functional>
+
+QT_BEGIN_NAMESPACE
+
+class Q_HTTPSERVER_EXPORT QHttpServerBodyDevice : public QIODevice
+{
+public:
+    // The parser stops feeding the device above the high watermark, and
+    // resumes once the reader brought it below the low one.
+    static constexpr qint64 HighWatermark = 64 * 1024;
+    static constexpr qint64 LowWatermark = HighWatermark / 2;
+
+    QHttpServerBodyDevice();
+    ~QHttpServerBodyDevice() override;
+
+    bool isSequential() const override;
+    qint64 bytesAvailable() const override;
+    bool atEnd() const override;
+
+    void append(const char *data, qint64 size);
+    void finish();
+    void notify();
+
+    bool isFull() const { return buffered() >= HighWatermark; }
+    bool isFinished() const { return finished; }
+    qint64 bufferSize() const { return buffer.size(); }
+
+    // Called once a full device was read below the low watermark
+    std::function<void()> drained;
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    qint64 buffered() const { return buffer.size() - offset; }
+
+    QByteArray buffer;
+    int offset = 0;
+    bool finished = false;
+    bool readyReadPending = false;
+    bool finishedPending = false;
+    bool blocked = false;
+};
+
+QT_END_NAMESPACE
+
+#endif // QHTTPSERVERBODYDEVICE_P_H
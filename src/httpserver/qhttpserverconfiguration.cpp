@@ -0,0 +1,745 @@
+/****************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtHttpServer module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtHttpServer/qhttpserverconfiguration.h>
+
+QT_BEGIN_NAMESPACE
+
+class QHttpServerConfigurationPrivate : public QSharedData
+{
+public:
+    int workerThreadCount = 0;
+    bool listenerSharding = false;
+    QHttpServerConfiguration::EventBackend eventBackend =
+            QHttpServerConfiguration::EventBackend::Default;
+    int keepAliveTimeout = 0;
+    int headerReadTimeout = 0;
+    int bodyReadTimeout = 0;
+    int maxRequestsPerConnection = 0;
+    qint64 bodyMemoryThreshold = 0;
+    int maxUrlLength = 8 * 1024;
+    int maxHeaderCount = 100;
+    int maxHeaderSize = 16 * 1024;
+    qint64 maxBodySize = 0;
+    qint64 writeBufferHighWatermark = 0;
+    qint64 writeBufferLowWatermark = 0;
+    int maxConnections = 0;
+    int maxConnectionsPerAddress = 0;
+    QHttpServerConfiguration::OverloadPolicy overloadPolicy =
+            QHttpServerConfiguration::OverloadPolicy::PauseAccepting;
+    int retryAfter = 1;
+    bool http2Enabled = false;
+    int http2MaxConcurrentStreams = 100;
+    int sslSessionLifetime = 0;
+    int maxConcurrentSslHandshakes = 0;
+    int sslHandshakeTimeout = 0;
+};
+
+/*!
+    \class QHttpServerConfiguration
+    \brief The QHttpServerConfiguration class holds the tunables of a QAbstractHttpServer.
+
+    QHttpServerConfiguration is a value class. Fill it in and pass it to
+    QAbstractHttpServer::setConfiguration().
+
+    \code
+
+    QHttpServerConfiguration configuration;
+    configuration.setWorkerThreadCount(QThread::idealThreadCount());
+
+    QHttpServer server;
+    server.setConfiguration(configuration);
+    server.listen();
+
+    \endcode
+
+    \sa QAbstractHttpServer::setConfiguration()
+*/
+
+/*!
+    \enum QHttpServerConfiguration::OverloadPolicy
+
+    This enum describes what the server does with new connections while
+    it holds maxConnections() of them.
+
+    \value PauseAccepting
+           The listening sockets stop accepting connections, which queue
+           up in the kernel, until a connection closes.
+    \value RejectConnections
+           New connections are accepted and answered with
+           \c {503 Service Unavailable}, with a \c Retry-After header
+           set to retryAfter(), then closed.
+*/
+
+/*!
+    \enum QHttpServerConfiguration::EventBackend
+
+    This enum describes how the worker threads wait for their sockets.
+
+    \value Default
+           The worker threads run the event dispatcher Qt creates for
+           any thread.
+    \value Epoll
+           The worker threads run an event dispatcher of their own,
+           built on epoll. Available on Linux only.
+*/
+
+/*!
+    Constructs a default configuration. All connections are handled in
+    the thread the server lives in.
+*/
+QHttpServerConfiguration::QHttpServerConfiguration()
+    : d(new QHttpServerConfigurationPrivate)
+{
+}
+
+/*!
+    Constructs a copy of \a other.
+*/
+QHttpServerConfiguration::QHttpServerConfiguration(const QHttpServerConfiguration &other) = default;
+
+/*!
+    Assigns \a other to this configuration.
+*/
+QHttpServerConfiguration &QHttpServerConfiguration::operator=(
+        const QHttpServerConfiguration &other) = default;
+
+/*!
+    Destroys the configuration.
+*/
+QHttpServerConfiguration::~QHttpServerConfiguration() = default;
+
+/*!
+    Returns the number of worker threads.
+
+    \sa setWorkerThreadCount()
+*/
+int QHttpServerConfiguration::workerThreadCount() const
+{
+    return d->workerThreadCount;
+}
+
+/*!
+    Sets the number of worker threads to \a count.
+
+    When \a count is greater than zero, the server starts \a count
+    threads, each running its own event loop, and every accepted
+    connection is handed over to the least loaded one. Parsing the
+    request, calling QAbstractHttpServer::handleRequest() and writing
+    the response then happen in that worker thread, and the socket
+    stays there until it is closed.
+
+    Handlers must therefore be safe to call from several threads at
+    once. QHttpServer gives each worker its own copy of the route
+    handlers, so state captured by value in a route lambda is never
+    shared between threads; state captured by reference or pointer is.
+
+    When \a count is zero (the default), connections are handled in
+    the thread the server lives in.
+
+    \note The worker threads are started the first time a TCP server
+    is bound, later changes have no effect on a running server.
+*/
+void QHttpServerConfiguration::setWorkerThreadCount(int count)
+{
+    d->workerThreadCount = qMax(0, count);
+}
+
+/*!
+    Returns \c true if QAbstractHttpServer::listen() opens one listening
+    socket per worker thread.
+
+    \sa setListenerSharding()
+*/
+bool QHttpServerConfiguration::listenerSharding() const
+{
+    return d->listenerSharding;
+}
+
+/*!
+    Enables or disables listener sharding, according to \a enabled.
+
+    By default, one QTcpServer in the thread of the server accepts every
+    connection and hands it to a worker thread. With sharding enabled,
+    QAbstractHttpServer::listen() opens one SO_REUSEPORT listening socket
+    per worker thread instead, and the kernel balances the incoming
+    connections between them. Each shard accepts, parses and answers in
+    its own thread, so there is no single accept bottleneck.
+
+    Sharding only takes effect with a non-zero workerThreadCount(), and
+    only on platforms providing SO_REUSEPORT, such as Linux and the BSDs.
+    Servers passed to QAbstractHttpServer::bind() are not sharded.
+
+    \sa QAbstractHttpServer::workerStatistics()
+*/
+void QHttpServerConfiguration::setListenerSharding(bool enabled)
+{
+    d->listenerSharding = enabled;
+}
+
+/*!
+    Returns the event backend of the worker threads.
+
+    \sa setEventBackend()
+*/
+QHttpServerConfiguration::EventBackend QHttpServerConfiguration::eventBackend() const
+{
+    return d->eventBackend;
+}
+
+/*!
+    Sets the event backend of the worker threads to \a backend. The
+    default is EventBackend::Default.
+
+    The default Qt event dispatcher hands all the sockets of a thread to
+    poll() on every iteration of its event loop, which gets costly with
+    thousands of keep-alive connections per worker. EventBackend::Epoll
+    keeps them registered with the kernel instead, so that waking up
+    only costs as much as the sockets that are ready. It also reports up
+    to 256 ready sockets per wake-up. The QTcpServer and QTcpSocket API
+    of handlers is unchanged.
+
+    The backend only applies to the worker threads, see
+    setWorkerThreadCount(), and should be combined with
+    setListenerSharding() for the accepting to happen there too.
+    On other platforms than Linux, EventBackend::Epoll falls back to the
+    default.
+
+    \note The worker threads are started the first time a TCP server
+    is bound, later changes have no effect on a running server.
+*/
+void QHttpServerConfiguration::setEventBackend(EventBackend backend)
+{
+    d->eventBackend = backend;
+}
+
+/*!
+    Returns the time, in milliseconds, an idle connection is kept open
+    waiting for its next request.
+
+    \sa setKeepAliveTimeout()
+*/
+int QHttpServerConfiguration::keepAliveTimeout() const
+{
+    return d->keepAliveTimeout;
+}
+
+/*!
+    Closes connections on which no new request starts within \a msecs
+    milliseconds after the previous response, or after the connection
+    was accepted when no headerReadTimeout() is set.
+
+    A value of zero (the default) keeps idle connections open until the
+    client closes them.
+
+    Timeouts are tracked with a coarse resolution of 100 milliseconds.
+*/
+void QHttpServerConfiguration::setKeepAliveTimeout(int msecs)
+{
+    d->keepAliveTimeout = qMax(0, msecs);
+}
+
+/*!
+    Returns the time, in milliseconds, a client is given to send the
+    request line and headers of a request.
+
+    \sa setHeaderReadTimeout()
+*/
+int QHttpServerConfiguration::headerReadTimeout() const
+{
+    return d->headerReadTimeout;
+}
+
+/*!
+    Answers with \c {408 Request Timeout} and closes the connection when
+    the request line and headers of a request are not complete within
+    \a msecs milliseconds. The clock starts when the connection is
+    accepted, or when the first byte of a follow-up request arrives, and
+    is not reset by further bytes, so a client trickling in its headers
+    cannot hold the connection open.
+
+    A value of zero (the default) disables this timeout.
+*/
+void QHttpServerConfiguration::setHeaderReadTimeout(int msecs)
+{
+    d->headerReadTimeout = qMax(0, msecs);
+}
+
+/*!
+    Returns the time, in milliseconds, the body of a request may stall.
+
+    \sa setBodyReadTimeout()
+*/
+int QHttpServerConfiguration::bodyReadTimeout() const
+{
+    return d->bodyReadTimeout;
+}
+
+/*!
+    Answers with \c {408 Request Timeout} and closes the connection when
+    no part of the body of a request arrives for \a msecs milliseconds.
+    Unlike headerReadTimeout(), the clock restarts whenever data arrives.
+
+    A value of zero (the default) disables this timeout.
+*/
+void QHttpServerConfiguration::setBodyReadTimeout(int msecs)
+{
+    d->bodyReadTimeout = qMax(0, msecs);
+}
+
+/*!
+    Returns the number of requests served on a connection before it is
+    closed.
+
+    \sa setMaxRequestsPerConnection()
+*/
+int QHttpServerConfiguration::maxRequestsPerConnection() const
+{
+    return d->maxRequestsPerConnection;
+}
+
+/*!
+    Closes connections once \a count requests have been handled on them.
+    The connection is closed after the pending response data is written.
+
+    A value of zero (the default) puts no limit on the number of
+    requests.
+*/
+void QHttpServerConfiguration::setMaxRequestsPerConnection(int count)
+{
+    d->maxRequestsPerConnection = qMax(0, count);
+}
+
+/*!
+    Returns the size, in bytes, up to which request bodies are kept in
+    memory.
+
+    \sa setBodyMemoryThreshold()
+*/
+qint64 QHttpServerConfiguration::bodyMemoryThreshold() const
+{
+    return d->bodyMemoryThreshold;
+}
+
+/*!
+    Buffers request bodies larger than \a size bytes in a temporary file
+    instead of memory, which caps the memory a request takes while it is
+    received. QHttpServerRequest::bodyDevice() then returns the file, and
+    QHttpServerRequest::body() reads it back.
+
+    A value of zero (the default) keeps all bodies in memory.
+
+    This does not apply to bodies streamed to their handler, see
+    QHttpServerRouterRule::setBodyStreaming().
+*/
+void QHttpServerConfiguration::setBodyMemoryThreshold(qint64 size)
+{
+    d->bodyMemoryThreshold = qMax(qint64(0), size);
+}
+
+/*!
+    Returns the maximum length, in bytes, of the target of a request.
+
+    \sa setMaxUrlLength()
+*/
+int QHttpServerConfiguration::maxUrlLength() const
+{
+    return d->maxUrlLength;
+}
+
+/*!
+    Answers with \c {414 URI Too Long} and closes the connection when the
+    target of a request line is longer than \a length bytes. The request
+    is rejected while it is parsed, the rest of it is never buffered.
+
+    The default is 8 KiB. A value of zero puts no limit on the length.
+*/
+void QHttpServerConfiguration::setMaxUrlLength(int length)
+{
+    d->maxUrlLength = qMax(0, length);
+}
+
+/*!
+    Returns the maximum number of header fields of a request.
+
+    \sa setMaxHeaderCount()
+*/
+int QHttpServerConfiguration::maxHeaderCount() const
+{
+    return d->maxHeaderCount;
+}
+
+/*!
+    Answers with \c {431 Request Header Fields Too Large} and closes the
+    connection when a request has more than \a count header fields.
+
+    The default is 100. A value of zero puts no limit on the count.
+*/
+void QHttpServerConfiguration::setMaxHeaderCount(int count)
+{
+    d->maxHeaderCount = qMax(0, count);
+}
+
+/*!
+    Returns the maximum size, in bytes, of the header fields of a request.
+
+    \sa setMaxHeaderSize()
+*/
+int QHttpServerConfiguration::maxHeaderSize() const
+{
+    return d->maxHeaderSize;
+}
+
+/*!
+    Answers with \c {431 Request Header Fields Too Large} and closes the
+    connection when the names and values of the header fields of a
+    request add up to more than \a size bytes.
+
+    The default is 16 KiB. A value of zero puts no limit on the size.
+*/
+void QHttpServerConfiguration::setMaxHeaderSize(int size)
+{
+    d->maxHeaderSize = qMax(0, size);
+}
+
+/*!
+    Returns the maximum size, in bytes, of the body of a request.
+
+    \sa setMaxBodySize()
+*/
+qint64 QHttpServerConfiguration::maxBodySize() const
+{
+    return d->maxBodySize;
+}
+
+/*!
+    Answers with \c {413 Payload Too Large} and closes the connection
+    when the body of a request is larger than \a size bytes. Requests
+    announcing a larger \c Content-Length are rejected before any of
+    their body is read, chunked ones as soon as they exceed the limit.
+
+    A value of zero (the default) puts no limit on the size. Routes can
+    override it, see QHttpServerRouterRule::setMaxBodySize().
+*/
+void QHttpServerConfiguration::setMaxBodySize(qint64 size)
+{
+    d->maxBodySize = qMax(qint64(0), size);
+}
+
+/*!
+    Returns the number of response bytes waiting to be sent on a
+    connection above which the server stops reading from it.
+
+    \sa setWriteBufferHighWatermark(), writeBufferLowWatermark()
+*/
+qint64 QHttpServerConfiguration::writeBufferHighWatermark() const
+{
+    return d->writeBufferHighWatermark;
+}
+
+/*!
+    Stops reading from connections on which more than \a size bytes of
+    responses wait to be sent, because their client does not read them
+    as fast as it sends requests. Neither further requests are parsed,
+    nor more of a response body is pulled from the QIODevice passed to
+    QHttpServerResponder::write(), until the client caught up with
+    writeBufferLowWatermark(). Meanwhile, the kernel holds the client
+    back.
+
+    A value of zero (the default) never stops reading.
+
+    \sa QAbstractHttpServer::workerStatistics()
+*/
+void QHttpServerConfiguration::setWriteBufferHighWatermark(qint64 size)
+{
+    d->writeBufferHighWatermark = qMax(qint64(0), size);
+}
+
+/*!
+    Returns the number of response bytes waiting to be sent on a
+    connection below which the server reads from it again.
+
+    \sa setWriteBufferLowWatermark(), writeBufferHighWatermark()
+*/
+qint64 QHttpServerConfiguration::writeBufferLowWatermark() const
+{
+    return d->writeBufferLowWatermark;
+}
+
+/*!
+    Resumes reading from a connection stopped by
+    writeBufferHighWatermark() once no more than \a size bytes of
+    responses wait to be sent on it. Keeping it well below the high
+    watermark avoids toggling for every few bytes sent.
+
+    The default is zero, reading resumes once everything was sent.
+*/
+void QHttpServerConfiguration::setWriteBufferLowWatermark(qint64 size)
+{
+    d->writeBufferLowWatermark = qMax(qint64(0), size);
+}
+
+/*!
+    Returns the maximum number of connections the server holds at once.
+
+    \sa setMaxConnections()
+*/
+int QHttpServerConfiguration::maxConnections() const
+{
+    return d->maxConnections;
+}
+
+/*!
+    Limits the connections the server holds at once, across all its
+    listening sockets and worker threads, to \a count. What happens to
+    further connections depends on overloadPolicy().
+
+    Connections handed over to QWebSocketServer no longer count.
+
+    A value of zero (the default) puts no limit on the number of
+    connections.
+*/
+void QHttpServerConfiguration::setMaxConnections(int count)
+{
+    d->maxConnections = qMax(0, count);
+}
+
+/*!
+    Returns the maximum number of connections the server holds at once
+    from a single remote address.
+
+    \sa setMaxConnectionsPerAddress()
+*/
+int QHttpServerConfiguration::maxConnectionsPerAddress() const
+{
+    return d->maxConnectionsPerAddress;
+}
+
+/*!
+    Limits the connections the server holds at once from a single remote
+    address to \a count. Further connections from that address are
+    answered with \c {503 Service Unavailable} and closed, whatever the
+    overloadPolicy(), as pausing would hold back all the other clients
+    too.
+
+    A value of zero (the default) puts no limit on the number of
+    connections per address.
+*/
+void QHttpServerConfiguration::setMaxConnectionsPerAddress(int count)
+{
+    d->maxConnectionsPerAddress = qMax(0, count);
+}
+
+/*!
+    Returns what the server does with new connections while it holds
+    maxConnections() of them.
+
+    \sa setOverloadPolicy()
+*/
+QHttpServerConfiguration::OverloadPolicy QHttpServerConfiguration::overloadPolicy() const
+{
+    return d->overloadPolicy;
+}
+
+/*!
+    Sets what the server does with new connections while it holds
+    maxConnections() of them to \a policy. The default is
+    OverloadPolicy::PauseAccepting.
+*/
+void QHttpServerConfiguration::setOverloadPolicy(OverloadPolicy policy)
+{
+    d->overloadPolicy = policy;
+}
+
+/*!
+    Returns the number of seconds rejected clients are asked to wait
+    before they try again.
+
+    \sa setRetryAfter()
+*/
+int QHttpServerConfiguration::retryAfter() const
+{
+    return d->retryAfter;
+}
+
+/*!
+    Sets the \c Retry-After header of the \c {503 Service Unavailable}
+    answer to connections over the limits to \a seconds. The default is
+    one second, zero leaves the header out.
+
+    \sa setMaxConnections(), setMaxConnectionsPerAddress()
+*/
+void QHttpServerConfiguration::setRetryAfter(int seconds)
+{
+    d->retryAfter = qMax(0, seconds);
+}
+
+/*!
+    Returns \c true if clients may speak HTTP/2.
+
+    \sa setHttp2Enabled()
+*/
+bool QHttpServerConfiguration::http2Enabled() const
+{
+    return d->http2Enabled;
+}
+
+/*!
+    Lets clients speak HTTP/2 if \a enabled is \c true, multiplexing
+    their requests over a single connection. The default is \c false.
+
+    Clients get to HTTP/2 in three ways:
+    \list
+    \li Over TLS, by negotiating \c h2 with ALPN during the handshake.
+    \li Without TLS, by upgrading an HTTP/1.1 request carrying
+        \c {Upgrade: h2c}, which is answered over HTTP/2.
+    \li Without TLS, by starting the connection with the HTTP/2
+        connection preface right away, with prior knowledge.
+    \endlist
+
+    Each stream is handed to QAbstractHttpServer::handleRequest() like a
+    connection of its own carrying one HTTP/1.1 request, so routes and
+    QHttpServerResponder work unchanged and the limits, timeouts and
+    watermarks of this configuration apply per stream. The socket they
+    get is a stand-in for the stream, with no descriptor. The streams of a
+    connection share its QHttpServerRequest::connectionContext() objects
+    and QHttpServerRequest::proxyProtocolTlv() fields.
+    WebSocket upgrades and server push are not available over HTTP/2.
+
+    \note ALPN is configured when the TLS servers are created, set this
+    before QAbstractHttpServer::listen().
+
+    \sa setHttp2MaxConcurrentStreams()
+*/
+void QHttpServerConfiguration::setHttp2Enabled(bool enabled)
+{
+    d->http2Enabled = enabled;
+}
+
+/*!
+    Returns how many streams an HTTP/2 client may have open at once.
+
+    \sa setHttp2MaxConcurrentStreams()
+*/
+int QHttpServerConfiguration::http2MaxConcurrentStreams() const
+{
+    return d->http2MaxConcurrentStreams;
+}
+
+/*!
+    Limits the streams an HTTP/2 client may have open at once to
+    \a count, announced with \c SETTINGS_MAX_CONCURRENT_STREAMS. Streams
+    over the limit are refused. The default is 100.
+
+    \sa setHttp2Enabled()
+*/
+void QHttpServerConfiguration::setHttp2MaxConcurrentStreams(int count)
+{
+    d->http2MaxConcurrentStreams = qMax(1, count);
+}
+
+/*!
+    Returns the number of seconds returning TLS clients may resume their
+    session.
+
+    \sa setSslSessionLifetime()
+*/
+int QHttpServerConfiguration::sslSessionLifetime() const
+{
+    return d->sslSessionLifetime;
+}
+
+/*!
+    Lets TLS clients coming back within \a seconds resume their session,
+    sparing them and the server a full handshake. The TLS context, with
+    its session cache and session ticket key, is shared by the listeners
+    of all the worker threads and replaced every \a seconds, retiring the
+    sessions established with it.
+
+    A value of zero (the default) disables session resumption.
+
+    \sa QAbstractHttpServer::sslSessionCache(), QSslServerSessionCache
+*/
+void QHttpServerConfiguration::setSslSessionLifetime(int seconds)
+{
+    d->sslSessionLifetime = qMax(0, seconds);
+}
+
+/*!
+    Returns how many TLS handshakes each listener runs at once.
+
+    \sa setMaxConcurrentSslHandshakes()
+*/
+int QHttpServerConfiguration::maxConcurrentSslHandshakes() const
+{
+    return d->maxConcurrentSslHandshakes;
+}
+
+/*!
+    Limits the TLS handshakes each listener runs at once to \a count, so
+    that a storm of new connections does not starve the established ones.
+    Connections over the limit wait for a handshake to finish.
+
+    With a limit, the handshakes run in the thread of the listener before
+    its connections are handed over to a worker thread. Enable
+    listenerSharding() to spread them over the worker threads, each shard
+    having a limit of its own.
+
+    A value of zero (the default) puts no limit.
+
+    \sa setSslHandshakeTimeout(), QSslServer::setMaxConcurrentHandshakes()
+*/
+void QHttpServerConfiguration::setMaxConcurrentSslHandshakes(int count)
+{
+    d->maxConcurrentSslHandshakes = qMax(0, count);
+}
+
+/*!
+    Returns the time TLS handshakes are given, in milliseconds.
+
+    \sa setSslHandshakeTimeout()
+*/
+int QHttpServerConfiguration::sslHandshakeTimeout() const
+{
+    return d->sslHandshakeTimeout;
+}
+
+/*!
+    Aborts connections whose TLS handshake is not done within \a msecs of
+    being accepted, waiting for maxConcurrentSslHandshakes() included.
+    A value of zero (the default) disables the timeout.
+
+    \sa QAbstractHttpServer::sslHandshakeStatistics()
+*/
+void QHttpServerConfiguration::setSslHandshakeTimeout(int msecs)
+{
+    d->sslHandshakeTimeout = qMax(0, msecs);
+}
+
+QT_END_NAMESPACE
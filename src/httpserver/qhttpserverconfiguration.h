@@ -0,0 +1,140 @@
+/****************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtHttpServer module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QHTTPSERVERCONFIGURATION_H
+#define QHTTPSERVERCONFIGURATION_H
+
+#include <QtHttpServer/qthttpserverglobal.h>
+
+#include <QtCore/qshareddata.h>
+
+QT_BEGIN_NAMESPACE
+
+class QHttpServerConfigurationPrivate;
+class Q_HTTPSERVER_EXPORT QHttpServerConfiguration
+{
+public:
+    enum class OverloadPolicy {
+        PauseAccepting,
+        RejectConnections
+    };
+
+    enum class EventBackend {
+        Default,
+        Epoll
+    };
+
+    QHttpServerConfiguration();
+    QHttpServerConfiguration(const QHttpServerConfiguration &other);
+    QHttpServerConfiguration(QHttpServerConfiguration &&other) noexcept = default;
+    QHttpServerConfiguration &operator=(const QHttpServerConfiguration &other);
+    QHttpServerConfiguration &operator=(QHttpServerConfiguration &&other) noexcept
+    { swap(other); return *this; }
+    ~QHttpServerConfiguration();
+
+    void swap(QHttpServerConfiguration &other) noexcept { d.swap(other.d); }
+
+    int workerThreadCount() const;
+    void setWorkerThreadCount(int count);
+
+    bool listenerSharding() const;
+    void setListenerSharding(bool enabled);
+
+    EventBackend eventBackend() const;
+    void setEventBackend(EventBackend backend);
+
+    int keepAliveTimeout() const;
+    void setKeepAliveTimeout(int msecs);
+
+    int headerReadTimeout() const;
+    void setHeaderReadTimeout(int msecs);
+
+    int bodyReadTimeout() const;
+    void setBodyReadTimeout(int msecs);
+
+    int maxRequestsPerConnection() const;
+    void setMaxRequestsPerConnection(int count);
+
+    qint64 bodyMemoryThreshold() const;
+    void setBodyMemoryThreshold(qint64 size);
+
+    int maxUrlLength() const;
+    void setMaxUrlLength(int length);
+
+    int maxHeaderCount() const;
+    void setMaxHeaderCount(int count);
+
+    int maxHeaderSize() const;
+    void setMaxHeaderSize(int size);
+
+    qint64 maxBodySize() const;
+    void setMaxBodySize(qint64 size);
+
+    qint64 writeBufferHighWatermark() const;
+    void setWriteBufferHighWatermark(qint64 size);
+
+    qint64 writeBufferLowWatermark() const;
+    void setWriteBufferLowWatermark(qint64 size);
+
+    int maxConnections() const;
+    void setMaxConnections(int count);
+
+    int maxConnectionsPerAddress() const;
+    void setMaxConnectionsPerAddress(int count);
+
+    OverloadPolicy overloadPolicy() const;
+    void setOverloadPolicy(OverloadPolicy policy);
+
+    int retryAfter() const;
+    void setRetryAfter(int seconds);
+
+    bool http2Enabled() const;
+    void setHttp2Enabled(bool enabled);
+
+    int http2MaxConcurrentStreams() const;
+    void setHttp2MaxConcurrentStreams(int count);
+
+    int sslSessionLifetime() const;
+    void setSslSessionLifetime(int seconds);
+
+    int maxConcurrentSslHandshakes() const;
+    void setMaxConcurrentSslHandshakes(int count);
+
+    int sslHandshakeTimeout() const;
+    void setSslHandshakeTimeout(int msecs);
+
+private:
+    QSharedDataPointer<QHttpServerConfigurationPrivate> d;
+};
+
+Q_DECLARE_SHARED(QHttpServerConfiguration)
+
+QT_END_NAMESPACE
+
+#endif // QHTTPSERVERCONFIGURATION_H
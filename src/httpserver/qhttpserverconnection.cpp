@@ -0,0 +1,570 @@
+/****************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtHttpServer module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <private/qhttpserverconnection_p.h>
+
+#include <private/qabstracthttpserver_p.h>
+#include <private/qhttpserverhttp2connection_p.h>
+#include <private/qhttpserverrequest_p.h>
+#include <private/qhttpserverworker_p.h>
+
+#include <QtCore/qcoreevent.h>
+#include <QtNetwork/qtcpsocket.h>
+
+#include <map>
+#include <utility>
+
+#if defined(Q_OS_UNIX)
+#  include <netinet/in.h>
+#  include <netinet/tcp.h>
+#  include <sys/socket.h>
+#endif
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \internal
+    \class QHttpServerConnection
+
+    Holds the per-connection state of a QAbstractHttpServer: the socket
+    and the request being parsed from it.
+
+    Connections are owned by a QHttpServerWorker, which recycles them
+    once their socket is gone, so that neither accepting a connection nor
+    answering another request on a keep-alive connection allocates new
+    request and parser state. The socket is a child of its connection,
+    which notices in childEvent() when the socket is deleted or handed
+    over to someone else.
+
+    The connection also enforces the timeouts and the request limit of
+    QHttpServerConfiguration. It moves through the phases of serving a
+    request, each with its own timeout in the timer wheel of the worker.
+
+    Pipelined requests are handled one at a time, in order. As long as a
+    response to a request is being written, see QHttpServerResponseGuard,
+    the next request is left unparsed, so responses cannot overtake
+    each other.
+
+    Clients that send requests faster than they read the responses are
+    held back: past QHttpServerConfiguration::writeBufferHighWatermark()
+    the connection stops reading, until the write buffer drained to the
+    low watermark.
+
+    A connection switched to HTTP/2 hands its socket to a
+    QHttpServerHttp2Connection, and each stream of it is served by
+    another connection of the worker, see
+    QHttpServerWorker::handleStream().
+*/
+
+// Answers to requests no handler gets to see, sent before closing the connection
+static const std::map<QHttpServerResponder::StatusCode, QByteArray> errorResponses {
+#define XX(num, name, string) \
+    { static_cast<QHttpServerResponder::StatusCode>(num), \
+      QByteArrayLiteral("HTTP/1.1 " #num " " #string "\r\n" \
+                        "Connection: close\r\n" \
+                        "Content-Length: 0\r\n" \
+                        "\r\n") },
+    HTTP_STATUS_MAP(XX)
+#undef XX
+};
+
+QHttpServerConnection::QHttpServerConnection(QHttpServerWorker *worker)
+    : QObject(worker), worker(worker), request(QHostAddress())
+{
+}
+
+QHttpServerConnection::~QHttpServerConnection()
+{
+}
+
+/*!
+    \internal
+
+    Starts serving \a socket, which lives in the thread of this connection.
+*/
+void QHttpServerConnection::setSocket(QTcpSocket *socket,
+                                      const QHttpServerListenerOptions &options)
+{
+    Q_ASSERT(!this->socket);
+    this->socket = socket;
+    request.d->reset(socket->peerAddress(), socket->peerPort());
+    request.d->expectsProxyHeader = options.proxyProtocol();
+    const auto &configuration = worker->configuration;
+    request.d->acceptsHttp2Preface = !isStream && configuration.http2Enabled();
+    request.d->bodyMemoryThreshold = configuration.bodyMemoryThreshold();
+    request.d->maxUrlLength = configuration.maxUrlLength();
+    request.d->maxHeaderCount = configuration.maxHeaderCount();
+    request.d->maxHeaderSize = configuration.maxHeaderSize();
+    request.d->maxBodySize = configuration.maxBodySize();
+    writeBufferHighWatermark = configuration.writeBufferHighWatermark();
+    writeBufferLowWatermark = configuration.writeBufferLowWatermark();
+    handledRequests = 0;
+    pendingResponses = 0;
+    closing = false;
+    corkResponses = options.corkResponses();
+    if (options.noDelay())
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    if (options.receiveBufferSize())
+        socket->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption,
+                                options.receiveBufferSize());
+    if (options.sendBufferSize())
+        socket->setSocketOption(QAbstractSocket::SendBufferSizeSocketOption,
+                                options.sendBufferSize());
+    ++serial;
+    socket->setParent(this);
+    connect(socket, &QTcpSocket::readyRead, this, &QHttpServerConnection::handleReadyRead);
+    connect(socket, &QTcpSocket::disconnected, this, &QHttpServerConnection::handleDisconnected);
+
+    // Waiting for the first request is covered by the header timeout,
+    // unless only the keep-alive timeout is set.
+    if (configuration.headerReadTimeout())
+        setPhase(Phase::Headers, configuration.headerReadTimeout());
+    else
+        setPhase(Phase::Idle, configuration.keepAliveTimeout());
+}
+
+/*!
+    \internal
+
+    Forgets the socket and gives this connection back to its worker.
+*/
+void QHttpServerConnection::release()
+{
+    http2.reset();
+    socket = nullptr;
+    if (readPaused) {
+        readPaused = false;
+        worker->pausedConnections.deref();
+    }
+    const QHostAddress address = countedAddress;
+    countedAddress.clear();
+    request.d->reset(QHostAddress(), 0);
+    worker->timerWheel.cancel(this);
+    // Streams are not counted as connections
+    if (std::exchange(isStream, false)) {
+        worker->recycleConnection(this);
+        return;
+    }
+    worker->server->releaseConnection(address);
+    worker->releaseConnection(this);
+}
+
+/*!
+    \internal
+
+    Serves HTTP/2 on the socket from now on, with what was read of it but
+    not parsed yet. A connection upgraded from HTTP/1.1 answers the
+    \a upgradeRequest on stream 1, the client sent its settings in
+    \a upgradeSettings.
+*/
+void QHttpServerConnection::startHttp2(const QByteArray &upgradeRequest,
+                                       const QByteArray &upgradeSettings)
+{
+    QObject::disconnect(socket, &QTcpSocket::readyRead,
+                        this, &QHttpServerConnection::handleReadyRead);
+    http2.reset(new QHttpServerHttp2Connection(this));
+    http2->start(request.d->takeUnparsed(), upgradeRequest, upgradeSettings);
+}
+
+/*!
+    \internal
+
+    Moves to the phase matching what was parsed of the request so far.
+*/
+void QHttpServerConnection::updateTimeout()
+{
+    const auto &configuration = worker->configuration;
+    switch (request.d->state) {
+    case QHttpServerRequestPrivate::State::NotStarted:
+        break;
+    case QHttpServerRequestPrivate::State::OnMessageBegin:
+    case QHttpServerRequestPrivate::State::OnUrl:
+    case QHttpServerRequestPrivate::State::OnStatus:
+    case QHttpServerRequestPrivate::State::OnHeaders:
+        // The deadline covers all the headers, trickling bytes do not move it
+        if (phase != Phase::Headers)
+            setPhase(Phase::Headers, configuration.headerReadTimeout());
+        break;
+    case QHttpServerRequestPrivate::State::OnHeadersComplete:
+    case QHttpServerRequestPrivate::State::OnBody:
+    case QHttpServerRequestPrivate::State::OnChunkHeader:
+    case QHttpServerRequestPrivate::State::OnChunkComplete:
+        // The client is not to blame while the handler lags behind
+        if (request.d->bodyDevice && request.d->bodyDevice->isFull())
+            setPhase(Phase::Handling, 0);
+        else
+            setPhase(Phase::Body, configuration.bodyReadTimeout());
+        break;
+    case QHttpServerRequestPrivate::State::OnMessageComplete:
+        setPhase(Phase::Handling, 0);
+        break;
+    }
+}
+
+/*!
+    \internal
+
+    Called once a request was passed to the server. Closes the connection
+    if it reached QHttpServerConfiguration::maxRequestsPerConnection(), or
+    if the server is draining.
+*/
+void QHttpServerConnection::requestHandled()
+{
+    const int maxRequests = worker->configuration.maxRequestsPerConnection();
+    ++handledRequests;
+    // A stream carries a single request
+    if (isStream || worker->draining || (maxRequests && handledRequests >= maxRequests)) {
+        closeAfterResponses();
+        return;
+    }
+    setPhase(Phase::Idle, worker->configuration.keepAliveTimeout());
+}
+
+/*!
+    \internal
+
+    Returns \c true if the connection is closed after the request whose
+    responses are being written, which then announce it with
+    \c {Connection: close}.
+*/
+bool QHttpServerConnection::isLastRequest() const
+{
+    if (closing || worker->draining)
+        return true;
+    // Until requestHandled(), the request being handled is not counted
+    const int maxRequests = worker->configuration.maxRequestsPerConnection();
+    return request.d->handling && maxRequests && handledRequests + 1 >= maxRequests;
+}
+
+/*!
+    \internal
+
+    Closes the connection once the responses to the current request are
+    written, without reading further requests.
+*/
+void QHttpServerConnection::closeAfterResponses()
+{
+    setPhase(Phase::Handling, 0);
+    closing = true;
+    if (!pendingResponses) // Otherwise endResponse() takes care of it
+        socket->disconnectFromHost();
+}
+
+/*!
+    \internal
+
+    Called when the worker starts draining. Connections waiting for their
+    next request are closed right away, the others after their current
+    request, see isLastRequest().
+*/
+void QHttpServerConnection::drain()
+{
+    if (http2) {
+        http2->drain();
+        return;
+    }
+    // Streams are closed after their request anyway
+    if (isStream)
+        return;
+    const auto state = request.d->state;
+    if (request.d->handling || pendingResponses || request.d->hasPendingData()
+            || socket->bytesAvailable()
+            || (state != QHttpServerRequestPrivate::State::NotStarted
+                && state != QHttpServerRequestPrivate::State::OnMessageComplete)) {
+        return;
+    }
+    setPhase(Phase::Handling, 0);
+    socket->disconnectFromHost();
+}
+
+/*!
+    \internal
+
+    Called when a response to the current request starts.
+*/
+void QHttpServerConnection::beginResponse()
+{
+    ++pendingResponses;
+}
+
+/*!
+    \internal
+
+    Called when a response to the current request is completely written
+    to the socket. Resumes the pipeline if this was the last one, or
+    closes the connection if it was the last request.
+*/
+void QHttpServerConnection::endResponse()
+{
+    Q_ASSERT(pendingResponses > 0);
+    if (--pendingResponses || request.d->handling || !socket)
+        return;
+
+    if (closing || worker->draining)
+        socket->disconnectFromHost();
+    else if (request.d->hasPendingData() || socket->bytesAvailable())
+        resume();
+}
+
+/*!
+    \internal
+
+    Answers the current request with \a status, without passing it to the
+    server, and closes the connection. Whatever is left of the request is
+    not read.
+*/
+void QHttpServerConnection::reject(QHttpServerResponder::StatusCode status)
+{
+    auto response = errorResponses.find(status);
+    if (response == errorResponses.end())
+        response = errorResponses.find(QHttpServerResponder::StatusCode::InternalServerError);
+    setPhase(Phase::Handling, 0);
+    // The socket must not call back with the rest of the request
+    QObject::disconnect(socket, &QTcpSocket::readyRead,
+                        this, &QHttpServerConnection::handleReadyRead);
+    socket->write(response->second);
+    socket->disconnectFromHost();
+}
+
+/*!
+    \internal
+
+    Continues reading the socket from the event loop, after it was left
+    alone for a while.
+*/
+void QHttpServerConnection::resume()
+{
+    QMetaObject::invokeMethod(this, [this]() {
+        if (socket)
+            handleReadyRead();
+    }, Qt::QueuedConnection);
+}
+
+/*!
+    \internal
+
+    Returns \c true if the client lags so far behind reading its responses
+    that this connection should stop reading from it.
+*/
+bool QHttpServerConnection::isWriteBufferFull() const
+{
+    return writeBufferHighWatermark && socket
+            && socket->bytesToWrite() > writeBufferHighWatermark;
+}
+
+/*!
+    \internal
+
+    Returns \c true if the client caught up enough with reading its
+    responses for this connection to read from it again.
+*/
+bool QHttpServerConnection::isWriteBufferDrained() const
+{
+    return !socket || socket->bytesToWrite() <= writeBufferLowWatermark;
+}
+
+/*!
+    \internal
+
+    Stops reading from the socket until its write buffer is drained.
+*/
+void QHttpServerConnection::pauseReading()
+{
+    if (readPaused)
+        return;
+    readPaused = true;
+    worker->readPauses.ref();
+    worker->pausedConnections.ref();
+    // Leave what the client sends in the kernel, TCP holds it back
+    socket->setReadBufferSize(1);
+    connect(socket, &QTcpSocket::bytesWritten, this, &QHttpServerConnection::handleBytesWritten);
+}
+
+void QHttpServerConnection::handleBytesWritten()
+{
+    if (!isWriteBufferDrained())
+        return;
+    readPaused = false;
+    worker->pausedConnections.deref();
+    disconnect(socket, &QTcpSocket::bytesWritten, this, &QHttpServerConnection::handleBytesWritten);
+    socket->setReadBufferSize(request.d->isStreamingBody() ? QHttpServerBodyDevice::HighWatermark
+                                                           : 0);
+    if (request.d->hasPendingData() || socket->bytesAvailable())
+        resume();
+}
+
+void QHttpServerConnection::setPhase(Phase phase, int timeout)
+{
+    this->phase = phase;
+    if (timeout)
+        worker->scheduleTimeout(this, timeout);
+    else
+        worker->timerWheel.cancel(this);
+}
+
+void QHttpServerConnection::expire()
+{
+    // Only waiting for streams times out
+    if (http2) {
+        http2->close();
+        return;
+    }
+    switch (phase) {
+    case Phase::Idle:
+        // Neither a response still being produced, nor a client reading a
+        // large response slowly, make the connection idle
+        if (pendingResponses || socket->bytesToWrite()) {
+            setPhase(Phase::Idle, worker->configuration.keepAliveTimeout());
+            return;
+        }
+        setPhase(Phase::Handling, 0);
+        socket->disconnectFromHost();
+        break;
+    case Phase::Headers:
+    case Phase::Body:
+        reject(QHttpServerResponder::StatusCode::RequestTimeout);
+        break;
+    case Phase::Handling:
+        break;
+    }
+}
+
+void QHttpServerConnection::childEvent(QChildEvent *event)
+{
+    // The socket is either being deleted, or it was disconnected from us
+    // and handed over, e.g. to the WebSocket server, before reparenting.
+    if (event->removed() && event->child() == socket)
+        release();
+}
+
+void QHttpServerConnection::handleReadyRead()
+{
+    worker->server->handleReadyRead(this);
+}
+
+void QHttpServerConnection::handleDisconnected()
+{
+    if (!request.d->handling)
+        socket->deleteLater();
+}
+
+/*!
+    \internal
+    \class QHttpServerResponseGuard
+
+    Marks a response to the current request of the connection owning
+    \a socket as pending for as long as the guard lives.
+
+    Responders and the transfers writing response bodies each carry one,
+    the guard outliving its connection or socket is harmless.
+*/
+QHttpServerResponseGuard::QHttpServerResponseGuard(QIODevice *socket)
+    : connection(qobject_cast<QHttpServerConnection *>(socket ? socket->parent() : nullptr))
+{
+    if (connection) {
+        serial = connection->serial;
+        connection->beginResponse();
+    }
+}
+
+QHttpServerResponseGuard::~QHttpServerResponseGuard()
+{
+    if (connection && connection->serial == serial)
+        connection->endResponse();
+}
+
+/*!
+    \internal
+
+    Returns \c true if the response should not be written further, as
+    its client lags behind reading, see
+    QHttpServerConnection::isWriteBufferFull().
+*/
+bool QHttpServerResponseGuard::isWriteBufferFull() const
+{
+    return connection && connection->serial == serial && connection->isWriteBufferFull();
+}
+
+/*!
+    \internal
+
+    Returns \c true once a response held back by isWriteBufferFull() can
+    be written further.
+*/
+bool QHttpServerResponseGuard::isWriteBufferDrained() const
+{
+    return !connection || connection->serial != serial || connection->isWriteBufferDrained();
+}
+
+/*!
+    \internal
+
+    Returns \c true if the connection is closed after this response.
+*/
+bool QHttpServerResponseGuard::isLastResponse() const
+{
+    return connection && connection->serial == serial && connection->isLastRequest();
+}
+
+/*!
+    \internal
+
+    Returns \c true while the connection still serves the client the
+    response was started for.
+*/
+bool QHttpServerResponseGuard::isCurrent() const
+{
+    return connection && connection->serial == serial;
+}
+
+/*!
+    \internal
+
+    Corks or uncorks the socket according to \a corked, if the listener
+    of the connection asks for it, see
+    QHttpServerListenerOptions::setCorkResponses().
+*/
+void QHttpServerResponseGuard::setCorked(bool corked) const
+{
+    if (!isCurrent() || !connection->corkResponses || !connection->socket)
+        return;
+#if defined(TCP_CORK) || defined(TCP_NOPUSH)
+    const int fd = int(connection->socket->socketDescriptor());
+    const int value = corked ? 1 : 0;
+#  if defined(TCP_CORK)
+    ::setsockopt(fd, IPPROTO_TCP, TCP_CORK, &value, sizeof(value));
+#  else
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NOPUSH, &value, sizeof(value));
+#  endif
+#else
+    Q_UNUSED(corked);
+#endif
+}
+
+QT_END_NAMESPACE
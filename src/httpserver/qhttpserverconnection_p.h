@@ -0,0 +1,148 @@
+/****************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtHttpServer module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QHTTPSERVERCONNECTION_P_H
+#define QHTTPSERVERCONNECTION_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists for the convenience
+// of QHttpServer. This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+
+#include <QtHttpServer/qhttpserverlisteneroptions.h>
+#include <QtHttpServer/qhttpserverrequest.h>
+#include <QtHttpServer/qhttpserverresponder.h>
+#include <private/qhttpservertimerwheel_p.h>
+
+#include <QtCore/qobject.h>
+#include <QtCore/qpointer.h>
+
+#include <memory>
+
+QT_BEGIN_NAMESPACE
+
+class QHttpServerHttp2Connection;
+class QHttpServerWorker;
+class QIODevice;
+class QTcpSocket;
+
+class QHttpServerConnection : public QObject, public QHttpServerTimerWheel::Entry
+{
+    Q_OBJECT
+
+public:
+    explicit QHttpServerConnection(QHttpServerWorker *worker);
+    ~QHttpServerConnection() override;
+
+    void setSocket(QTcpSocket *socket, const QHttpServerListenerOptions &options);
+    void release();
+    void startHttp2(const QByteArray &upgradeRequest = QByteArray(),
+                    const QByteArray &upgradeSettings = QByteArray());
+
+    void updateTimeout();
+    void requestHandled();
+    bool isLastRequest() const;
+    void closeAfterResponses();
+    void drain();
+    void reject(QHttpServerResponder::StatusCode status);
+
+    void beginResponse();
+    void endResponse();
+    void resume();
+
+    bool isWriteBufferFull() const;
+    bool isWriteBufferDrained() const;
+    void pauseReading();
+
+    enum class Phase {
+        Idle,
+        Headers,
+        Body,
+        Handling
+    };
+
+    QHttpServerWorker *const worker;
+    QTcpSocket *socket = nullptr;
+    // The address QAbstractHttpServerPrivate::nextPendingConnection()
+    // counted this connection against, if any
+    QHostAddress countedAddress;
+    QHttpServerRequest request;
+    Phase phase = Phase::Idle;
+    int handledRequests = 0;
+    int pendingResponses = 0;
+    quint64 serial = 0;
+    qint64 writeBufferHighWatermark = 0;
+    qint64 writeBufferLowWatermark = 0;
+    bool readPaused = false;
+    bool closing = false;
+    bool corkResponses = false;
+    // Set for the connections serving a stream of an HTTP/2 connection
+    bool isStream = false;
+    std::unique_ptr<QHttpServerHttp2Connection> http2;
+
+protected:
+    void childEvent(QChildEvent *event) override;
+    void expire() override;
+
+private:
+    friend class QHttpServerHttp2Connection;
+
+    void handleReadyRead();
+    void handleDisconnected();
+    void handleBytesWritten();
+    void setPhase(Phase phase, int timeout);
+};
+
+class QHttpServerResponseGuard
+{
+public:
+    explicit QHttpServerResponseGuard(QIODevice *socket);
+    ~QHttpServerResponseGuard();
+
+    bool isWriteBufferFull() const;
+    bool isWriteBufferDrained() const;
+    bool isLastResponse() const;
+    bool isCurrent() const;
+    void setCorked(bool corked) const;
+
+private:
+    Q_DISABLE_COPY(QHttpServerResponseGuard)
+
+    QPointer<QHttpServerConnection> connection;
+    quint64 serial = 0;
+};
+
+QT_END_NAMESPACE
+
+#endif // QHTTPSERVERCONNECTION_P_H
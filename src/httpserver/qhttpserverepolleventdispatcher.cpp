@@ -0,0 +1,322 @@
+/****************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtHttpServer module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <private/qhttpserverepolleventdispatcher_p.h>
+
+#include <QtCore/qcoreapplication.h>
+#include <QtCore/qcoreevent.h>
+#include <QtCore/qloggingcategory.h>
+#include <QtCore/qsocketnotifier.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+QT_BEGIN_NAMESPACE
+
+Q_DECLARE_LOGGING_CATEGORY(lcHttpServer)
+
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+Q_CORE_EXPORT uint qGlobalPostedEventsCount();
+#endif
+
+/*!
+    \internal
+    \class QHttpServerEpollEventDispatcher
+
+    Event dispatcher of the worker threads on Linux, see
+    QHttpServerConfiguration::EventBackend.
+
+    Socket notifiers stay registered in an epoll set for as long as they
+    are enabled, instead of being handed to poll() on every iteration of
+    the event loop, and one epoll_wait() reports up to MaxEvents ready
+    sockets. Timers are kept in a QTimerInfoList, like in the default
+    dispatcher, and wakeUp() writes to an eventfd.
+
+    The epoll set is level-triggered. QAbstractSocket does not always
+    read a socket dry, for instance once its read buffer is full, and
+    QSocketNotifier promises to keep reporting such a socket.
+*/
+
+QHttpServerEpollEventDispatcher::QHttpServerEpollEventDispatcher(QObject *parent)
+    : QAbstractEventDispatcher(parent),
+      epollFd(epoll_create1(EPOLL_CLOEXEC)),
+      wakeUpFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+{
+    if (epollFd < 0 || wakeUpFd < 0) {
+        qCCritical(lcHttpServer, "Cannot set up epoll: %s", std::strerror(errno));
+        return;
+    }
+
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = wakeUpFd;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeUpFd, &event) < 0)
+        qCCritical(lcHttpServer, "Cannot watch the wake-up eventfd: %s", std::strerror(errno));
+}
+
+QHttpServerEpollEventDispatcher::~QHttpServerEpollEventDispatcher()
+{
+    qDeleteAll(timers);
+    if (wakeUpFd >= 0)
+        ::close(wakeUpFd);
+    if (epollFd >= 0)
+        ::close(epollFd);
+}
+
+/*!
+    \internal
+
+    Returns \c false if the epoll set could not be created, the thread
+    should then keep the default dispatcher.
+*/
+bool QHttpServerEpollEventDispatcher::isValid() const
+{
+    return epollFd >= 0 && wakeUpFd >= 0;
+}
+
+bool QHttpServerEpollEventDispatcher::processEvents(QEventLoop::ProcessEventsFlags flags)
+{
+    interrupted.storeRelaxed(0);
+    emit awake();
+    QCoreApplication::sendPostedEvents();
+
+    const bool includeTimers = !(flags & QEventLoop::X11ExcludeTimers);
+    const bool includeNotifiers = !(flags & QEventLoop::ExcludeSocketNotifiers);
+    const bool canWait = (flags & QEventLoop::WaitForMoreEvents) && !interrupted.loadRelaxed();
+
+    if (canWait)
+        emit aboutToBlock();
+    if (interrupted.loadRelaxed())
+        return false;
+
+    // Posted events arriving from now on write to the eventfd
+    int timeout = canWait ? -1 : 0;
+    timespec wait = {};
+    if (canWait && includeTimers && timers.timerWait(wait))
+        timeout = int(wait.tv_sec * 1000 + (wait.tv_nsec + 999999) / 1000000);
+
+    epoll_event events[MaxEvents];
+    int count = epoll_wait(epollFd, events, MaxEvents, timeout);
+    if (count < 0) {
+        if (errno != EINTR)
+            qCWarning(lcHttpServer, "epoll_wait() failed: %s", std::strerror(errno));
+        count = 0;
+    }
+
+    int activated = 0;
+    for (int i = 0; i < count; ++i) {
+        const int fd = events[i].data.fd;
+        if (fd == wakeUpFd) {
+            eventfd_t value;
+            eventfd_read(wakeUpFd, &value);
+            wakeUps.storeRelease(0);
+            ++activated;
+            continue;
+        }
+        // Level-triggered, skipped sockets are reported again next time
+        if (!includeNotifiers)
+            continue;
+        const auto it = socketNotifiers.constFind(fd);
+        if (it == socketNotifiers.cend())
+            continue;
+        const quint32 ready = events[i].events;
+        if (it->read && (ready & (EPOLLIN | EPOLLHUP | EPOLLERR)))
+            pendingNotifiers.push_back(it->read);
+        if (it->write && (ready & (EPOLLOUT | EPOLLHUP | EPOLLERR)))
+            pendingNotifiers.push_back(it->write);
+        if (it->exception && (ready & EPOLLPRI))
+            pendingNotifiers.push_back(it->exception);
+    }
+
+    activated += activateSocketNotifiers();
+    if (includeTimers)
+        activated += timers.activateTimers();
+    return activated > 0;
+}
+
+int QHttpServerEpollEventDispatcher::activateSocketNotifiers()
+{
+    // A nested event loop delivers, and then clears, what is left here.
+    // Undelivered notifiers are still ready, epoll reports them again.
+    int activated = 0;
+    QEvent event(QEvent::SockAct);
+    for (std::size_t i = 0; i < pendingNotifiers.size(); ++i) {
+        if (QSocketNotifier *notifier = pendingNotifiers[i]) {
+            pendingNotifiers[i] = nullptr;
+            QCoreApplication::sendEvent(notifier, &event);
+            ++activated;
+        }
+    }
+    pendingNotifiers.clear();
+    return activated;
+}
+
+quint32 QHttpServerEpollEventDispatcher::Notifiers::events() const
+{
+    quint32 events = 0;
+    if (read)
+        events |= EPOLLIN;
+    if (write)
+        events |= EPOLLOUT;
+    if (exception)
+        events |= EPOLLPRI;
+    return events;
+}
+
+void QHttpServerEpollEventDispatcher::updateNotifiers(int fd, bool added)
+{
+    const auto it = socketNotifiers.find(fd);
+    Q_ASSERT(it != socketNotifiers.end());
+    epoll_event event = {};
+    event.events = it->events();
+    event.data.fd = fd;
+    int result = epoll_ctl(epollFd, added ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, fd, &event);
+    // The kernel dropped a closed descriptor from the set, while notifiers
+    // outliving it kept its entry, and a new socket got the same number
+    if (result < 0 && errno == ENOENT && !added)
+        result = epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+    if (result == 0)
+        return;
+
+    const int error = errno;
+    qCWarning(lcHttpServer, "Cannot watch socket %d: %s", fd, std::strerror(error));
+    // Nothing is watched for the descriptor, do not pretend otherwise
+    if (error == EBADF || error == ENOENT)
+        socketNotifiers.erase(it);
+}
+
+void QHttpServerEpollEventDispatcher::registerSocketNotifier(QSocketNotifier *notifier)
+{
+    Q_ASSERT(notifier);
+    const int fd = int(notifier->socket());
+    auto it = socketNotifiers.find(fd);
+    const bool added = it == socketNotifiers.end();
+    if (added)
+        it = socketNotifiers.insert(fd, Notifiers());
+
+    QSocketNotifier **slot = &it->read;
+    if (notifier->type() == QSocketNotifier::Write)
+        slot = &it->write;
+    else if (notifier->type() == QSocketNotifier::Exception)
+        slot = &it->exception;
+    if (*slot)
+        qCWarning(lcHttpServer, "Multiple socket notifiers for socket %d and type %d",
+                  fd, int(notifier->type()));
+    *slot = notifier;
+    updateNotifiers(fd, added);
+}
+
+void QHttpServerEpollEventDispatcher::unregisterSocketNotifier(QSocketNotifier *notifier)
+{
+    Q_ASSERT(notifier);
+    const int fd = int(notifier->socket());
+    const auto it = socketNotifiers.find(fd);
+    if (it == socketNotifiers.end())
+        return;
+
+    if (it->read == notifier)
+        it->read = nullptr;
+    else if (it->write == notifier)
+        it->write = nullptr;
+    else if (it->exception == notifier)
+        it->exception = nullptr;
+    std::replace(pendingNotifiers.begin(), pendingNotifiers.end(), notifier,
+                 static_cast<QSocketNotifier *>(nullptr));
+
+    if (it->events()) {
+        updateNotifiers(fd, false);
+    } else {
+        // The socket may be closed already, which removed it from the set
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        socketNotifiers.erase(it);
+    }
+}
+
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+bool QHttpServerEpollEventDispatcher::hasPendingEvents()
+{
+    return qGlobalPostedEventsCount();
+}
+
+void QHttpServerEpollEventDispatcher::registerTimer(int timerId, int interval,
+                                                     Qt::TimerType timerType, QObject *object)
+#else
+void QHttpServerEpollEventDispatcher::registerTimer(int timerId, qint64 interval,
+                                                     Qt::TimerType timerType, QObject *object)
+#endif
+{
+    Q_ASSERT(timerId > 0 && interval >= 0 && object);
+    timers.registerTimer(timerId, interval, timerType, object);
+}
+
+bool QHttpServerEpollEventDispatcher::unregisterTimer(int timerId)
+{
+    return timers.unregisterTimer(timerId);
+}
+
+bool QHttpServerEpollEventDispatcher::unregisterTimers(QObject *object)
+{
+    return timers.unregisterTimers(object);
+}
+
+QList<QAbstractEventDispatcher::TimerInfo>
+QHttpServerEpollEventDispatcher::registeredTimers(QObject *object) const
+{
+    return timers.registeredTimerInfo(object);
+}
+
+int QHttpServerEpollEventDispatcher::remainingTime(int timerId)
+{
+    return timers.timerRemainingTime(timerId);
+}
+
+void QHttpServerEpollEventDispatcher::wakeUp()
+{
+    if (wakeUps.testAndSetAcquire(0, 1))
+        eventfd_write(wakeUpFd, 1);
+}
+
+void QHttpServerEpollEventDispatcher::interrupt()
+{
+    interrupted.storeRelaxed(1);
+    wakeUp();
+}
+
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+void QHttpServerEpollEventDispatcher::flush()
+{
+}
+#endif
+
+QT_END_NAMESPACE
@@ -0,0 +1,118 @@
+/****************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtHttpServer module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QHTTPSERVEREPOLLEVENTDISPATCHER_P_H
+#define QHTTPSERVEREPOLLEVENTDISPATCHER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists for the convenience
+// of QHttpServer. This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+
+#include <QtHttpServer/qthttpserverglobal.h>
+
+#include <QtCore/qabstracteventdispatcher.h>
+#include <QtCore/qatomic.h>
+#include <QtCore/qhash.h>
+#include <QtCore/private/qtimerinfo_unix_p.h>
+
+#include <vector>
+
+QT_BEGIN_NAMESPACE
+
+class QSocketNotifier;
+
+class QHttpServerEpollEventDispatcher : public QAbstractEventDispatcher
+{
+    Q_OBJECT
+
+public:
+    explicit QHttpServerEpollEventDispatcher(QObject *parent = nullptr);
+    ~QHttpServerEpollEventDispatcher() override;
+
+    bool isValid() const;
+
+    bool processEvents(QEventLoop::ProcessEventsFlags flags) override;
+
+    void registerSocketNotifier(QSocketNotifier *notifier) override;
+    void unregisterSocketNotifier(QSocketNotifier *notifier) override;
+
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+    bool hasPendingEvents() override;
+    void registerTimer(int timerId, int interval, Qt::TimerType timerType,
+                       QObject *object) override;
+#else
+    void registerTimer(int timerId, qint64 interval, Qt::TimerType timerType,
+                       QObject *object) override;
+#endif
+    bool unregisterTimer(int timerId) override;
+    bool unregisterTimers(QObject *object) override;
+    QList<TimerInfo> registeredTimers(QObject *object) const override;
+    int remainingTime(int timerId) override;
+
+    void wakeUp() override;
+    void interrupt() override;
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+    void flush() override;
+#endif
+
+    // Ready sockets reported by one wake-up
+    static constexpr int MaxEvents = 256;
+
+private:
+    struct Notifiers
+    {
+        QSocketNotifier *read = nullptr;
+        QSocketNotifier *write = nullptr;
+        QSocketNotifier *exception = nullptr;
+
+        quint32 events() const;
+    };
+
+    void updateNotifiers(int fd, bool added);
+    int activateSocketNotifiers();
+
+    int epollFd = -1;
+    int wakeUpFd = -1;
+    QAtomicInt wakeUps;
+    QAtomicInt interrupted;
+    QHash<int, Notifiers> socketNotifiers;
+    // Notifiers ready in the current wake-up, unregistering clears them
+    std::vector<QSocketNotifier *> pendingNotifiers;
+    QTimerInfoList timers;
+};
+
+QT_END_NAMESPACE
+
+#endif // QHTTPSERVEREPOLLEVENTDISPATCHER_P_H
@@ -0,0 +1,423 @@
+/****************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtHttpServer module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <private/qhttpserverhpack_p.h>
+
+#include <algorithm>
+#include <array>
+
+QT_BEGIN_NAMESPACE
+
+namespace QHttpServerHpack {
+
+/*!
+    \internal
+    \namespace QHttpServerHpack
+
+    Header compression of HTTP/2, as specified in RFC 7541.
+
+    The Decoder keeps the dynamic table the client fills, it has to see
+    every header block of a connection in order. Responses are encoded
+    without touching the dynamic table of the client, with the static
+    table and plain literals only, so that they can be encoded in any
+    order and the encoder keeps no state.
+*/
+
+// RFC 7541, Appendix A
+static const std::array<std::pair<const char *, const char *>, 61> staticTable {{
+    { ":authority", "" },
+    { ":method", "GET" },
+    { ":method", "POST" },
+    { ":path", "/" },
+    { ":path", "/index.html" },
+    { ":scheme", "http" },
+    { ":scheme", "https" },
+    { ":status", "200" },
+    { ":status", "204" },
+    { ":status", "206" },
+    { ":status", "304" },
+    { ":status", "400" },
+    { ":status", "404" },
+    { ":status", "500" },
+    { "accept-charset", "" },
+    { "accept-encoding", "gzip, deflate" },
+    { "accept-language", "" },
+    { "accept-ranges", "" },
+    { "accept", "" },
+    { "access-control-allow-origin", "" },
+    { "age", "" },
+    { "allow", "" },
+    { "authorization", "" },
+    { "cache-control", "" },
+    { "content-disposition", "" },
+    { "content-encoding", "" },
+    { "content-language", "" },
+    { "content-length", "" },
+    { "content-location", "" },
+    { "content-range", "" },
+    { "content-type", "" },
+    { "cookie", "" },
+    { "date", "" },
+    { "etag", "" },
+    { "expect", "" },
+    { "expires", "" },
+    { "from", "" },
+    { "host", "" },
+    { "if-match", "" },
+    { "if-modified-since", "" },
+    { "if-none-match", "" },
+    { "if-range", "" },
+    { "if-unmodified-since", "" },
+    { "last-modified", "" },
+    { "link", "" },
+    { "location", "" },
+    { "max-forwards", "" },
+    { "proxy-authenticate", "" },
+    { "proxy-authorization", "" },
+    { "range", "" },
+    { "referer", "" },
+    { "refresh", "" },
+    { "retry-after", "" },
+    { "server", "" },
+    { "set-cookie", "" },
+    { "strict-transport-security", "" },
+    { "transfer-encoding", "" },
+    { "user-agent", "" },
+    { "vary", "" },
+    { "via", "" },
+    { "www-authenticate", "" }
+}};
+
+// RFC 7541, Appendix B. The code is canonical, the lengths are enough to
+// rebuild it: codes of the same length are consecutive, by symbol.
+static const uchar huffmanCodeLengths[257] = {
+    13, 23, 28, 28, 28, 28, 28, 28, 28, 24, 30, 28, 28, 30, 28, 28,
+    28, 28, 28, 28, 28, 28, 30, 28, 28, 28, 28, 28, 28, 28, 28, 28,
+    6, 10, 10, 12, 13, 6, 8, 11, 10, 10, 8, 11, 8, 6, 6, 6,
+    5, 5, 5, 6, 6, 6, 6, 6, 6, 6, 7, 8, 15, 6, 12, 10,
+    13, 6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 8, 7, 8, 13, 19, 13, 14, 6,
+    15, 5, 6, 5, 6, 5, 6, 6, 6, 5, 7, 7, 6, 6, 6, 5,
+    6, 7, 6, 5, 5, 6, 7, 7, 7, 7, 7, 15, 11, 14, 13, 28,
+    20, 22, 20, 20, 22, 22, 22, 23, 22, 23, 23, 23, 23, 23, 24, 23,
+    24, 24, 22, 23, 24, 23, 23, 23, 23, 21, 22, 23, 22, 23, 23, 24,
+    22, 21, 20, 22, 22, 23, 23, 21, 23, 22, 22, 24, 21, 22, 23, 23,
+    21, 21, 22, 21, 23, 22, 23, 23, 20, 22, 22, 22, 23, 22, 22, 23,
+    26, 26, 20, 19, 22, 23, 22, 25, 26, 26, 26, 27, 27, 26, 24, 25,
+    19, 21, 26, 27, 27, 26, 27, 24, 21, 21, 26, 26, 28, 27, 27, 27,
+    20, 24, 20, 21, 22, 21, 21, 23, 22, 22, 25, 25, 24, 24, 26, 23,
+    26, 27, 26, 26, 27, 27, 27, 27, 27, 28, 27, 27, 27, 27, 27, 26,
+    30
+};
+
+static constexpr int EndOfString = 256;
+static constexpr int MaxCodeLength = 30;
+
+struct HuffmanTable
+{
+    // Per code length, the first code and the position of its symbol
+    std::array<quint32, MaxCodeLength + 1> firstCode {};
+    std::array<int, MaxCodeLength + 1> firstSymbol {};
+    std::array<int, MaxCodeLength + 1> count {};
+    // Sorted by code
+    std::array<quint16, 257> symbols {};
+
+    HuffmanTable()
+    {
+        for (quint16 symbol = 0; symbol < symbols.size(); ++symbol)
+            symbols[symbol] = symbol;
+        std::stable_sort(symbols.begin(), symbols.end(), [](quint16 a, quint16 b) {
+            return huffmanCodeLengths[a] < huffmanCodeLengths[b];
+        });
+
+        quint32 code = 0;
+        int length = 0;
+        for (int i = 0; i < int(symbols.size()); ++i) {
+            const int symbolLength = huffmanCodeLengths[symbols[i]];
+            if (symbolLength != length) {
+                code <<= symbolLength - length;
+                length = symbolLength;
+                firstCode[length] = code;
+                firstSymbol[length] = i;
+            }
+            ++count[length];
+            ++code;
+        }
+    }
+};
+
+static bool huffmanDecode(const uchar *data, int size, QByteArray *string)
+{
+    static const HuffmanTable table;
+    string->clear();
+    string->reserve(size * 8 / 5);
+
+    quint32 code = 0;
+    int length = 0;
+    for (int i = 0; i < size; ++i) {
+        for (int bit = 7; bit >= 0; --bit) {
+            code = (code << 1) | ((data[i] >> bit) & 1);
+            ++length;
+            // Codes shorter than the length are prefixes of longer ones
+            // below firstCode, as the code is canonical
+            const quint32 offset = code - table.firstCode[length];
+            if (offset < quint32(table.count[length])) {
+                const int symbol = table.symbols[table.firstSymbol[length] + int(offset)];
+                if (symbol == EndOfString)
+                    return false;
+                string->append(char(symbol));
+                code = 0;
+                length = 0;
+            } else if (length == MaxCodeLength) {
+                return false;
+            }
+        }
+    }
+
+    // Padded up to the byte with the most significant bits of EOS
+    return length < 8 && code == (1u << length) - 1;
+}
+
+static void encodeInteger(QByteArray *block, uchar flags, int prefix, quint32 value)
+{
+    const quint32 mask = (1u << prefix) - 1;
+    if (value < mask) {
+        block->append(char(flags | value));
+        return;
+    }
+    block->append(char(flags | mask));
+    value -= mask;
+    while (value >= 0x80) {
+        block->append(char((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    block->append(char(value));
+}
+
+static void encodeString(QByteArray *block, const QByteArray &string)
+{
+    encodeInteger(block, 0x00, 7, quint32(string.size()));
+    block->append(string);
+}
+
+/*!
+    \internal
+
+    Appends \a headers to \a block. Their names must be in lower case,
+    as HTTP/2 wants them. Fields of the static table are indexed, the others
+    are literals that do not enter the dynamic table.
+*/
+void encode(const HeaderList &headers, QByteArray *block)
+{
+    for (const auto &header : headers) {
+        quint32 nameIndex = 0;
+        quint32 index = 0;
+        for (quint32 i = 0; i < staticTable.size() && !index; ++i) {
+            if (header.first != staticTable[i].first)
+                continue;
+            if (!nameIndex)
+                nameIndex = i + 1;
+            if (header.second == staticTable[i].second)
+                index = i + 1;
+        }
+
+        if (index) {
+            encodeInteger(block, 0x80, 7, index);
+            continue;
+        }
+        encodeInteger(block, 0x00, 4, nameIndex);
+        if (!nameIndex)
+            encodeString(block, header.first);
+        encodeString(block, header.second);
+    }
+}
+
+/*!
+    \internal
+    \class QHttpServerHpack::Decoder
+
+    Decodes the header blocks of one connection, with a dynamic table of
+    at most \a maxTableSize bytes, the size announced to the client.
+*/
+Decoder::Decoder(quint32 maxTableSize)
+    : maxTableSize(maxTableSize), tableSizeLimit(maxTableSize)
+{
+}
+
+/*!
+    \internal
+
+    Decodes the header block of \a size bytes at \a data into
+    \a headers. Returns Result::Error if the block is malformed, the
+    connection cannot go on then. Past \a maxListSize bytes, as HTTP/2
+    counts them, the rest of the block is decoded to keep the dynamic
+    table in sync but not kept, and Result::TooLarge is returned.
+*/
+Decoder::Result Decoder::decode(const uchar *data, int size, int maxListSize,
+                                HeaderList *headers)
+{
+    const uchar *pos = data;
+    const uchar *const end = data + size;
+    qint64 listSize = 0;
+    bool fieldSeen = false;
+    while (pos != end) {
+        const uchar first = *pos;
+        Header header;
+        if (first & 0x80) {
+            // Indexed field
+            quint32 index = 0;
+            if (!decodeInteger(pos, end, 7, &index) || !lookup(index, &header))
+                return Result::Error;
+        } else if (first & 0x40) {
+            // Literal entering the dynamic table
+            if (!decodeLiteral(pos, end, 6, &header))
+                return Result::Error;
+            insert(header);
+        } else if (first & 0x20) {
+            // Only allowed at the start of a block
+            quint32 size = 0;
+            if (fieldSeen || !decodeInteger(pos, end, 5, &size) || size > tableSizeLimit)
+                return Result::Error;
+            maxTableSize = size;
+            evict(0);
+            continue;
+        } else {
+            // Literal without indexing, or never indexed
+            if (!decodeLiteral(pos, end, 4, &header))
+                return Result::Error;
+        }
+
+        fieldSeen = true;
+        listSize += header.first.size() + header.second.size() + 32;
+        if (maxListSize && listSize > maxListSize)
+            headers->clear();
+        else
+            headers->append(header);
+    }
+    return maxListSize && listSize > maxListSize ? Result::TooLarge : Result::Ok;
+}
+
+bool Decoder::decodeInteger(const uchar *&pos, const uchar *end, int prefix,
+                            quint32 *value) const
+{
+    if (pos == end)
+        return false;
+    const quint32 mask = (1u << prefix) - 1;
+    quint64 result = *pos++ & mask;
+    if (result < mask) {
+        *value = quint32(result);
+        return true;
+    }
+
+    for (int shift = 0; pos != end && shift <= 28; shift += 7) {
+        const uchar byte = *pos++;
+        result += quint64(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            if (result > 0xffffffffu)
+                return false;
+            *value = quint32(result);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Decoder::decodeString(const uchar *&pos, const uchar *end, QByteArray *string) const
+{
+    if (pos == end)
+        return false;
+    const bool huffman = *pos & 0x80;
+    quint32 length = 0;
+    if (!decodeInteger(pos, end, 7, &length) || length > quint32(end - pos))
+        return false;
+    if (huffman) {
+        if (!huffmanDecode(pos, int(length), string))
+            return false;
+    } else {
+        *string = QByteArray(reinterpret_cast<const char *>(pos), int(length));
+    }
+    pos += length;
+    return true;
+}
+
+bool Decoder::decodeLiteral(const uchar *&pos, const uchar *end, int prefix,
+                            Header *header) const
+{
+    quint32 nameIndex = 0;
+    if (!decodeInteger(pos, end, prefix, &nameIndex))
+        return false;
+    if (nameIndex) {
+        if (!lookup(nameIndex, header))
+            return false;
+    } else if (!decodeString(pos, end, &header->first)) {
+        return false;
+    }
+    return decodeString(pos, end, &header->second);
+}
+
+bool Decoder::lookup(quint32 index, Header *header) const
+{
+    if (!index)
+        return false;
+    if (index <= staticTable.size()) {
+        const auto &entry = staticTable[index - 1];
+        *header = qMakePair(QByteArray(entry.first), QByteArray(entry.second));
+        return true;
+    }
+    index -= quint32(staticTable.size()) + 1;
+    if (index >= table.size())
+        return false;
+    *header = table[index];
+    return true;
+}
+
+void Decoder::insert(const Header &header)
+{
+    const quint32 size = quint32(header.first.size() + header.second.size()) + 32;
+    // An entry larger than the table empties it, and is not kept either
+    evict(qMin(size, maxTableSize + 1));
+    if (size > maxTableSize)
+        return;
+    table.push_front(header);
+    tableSize += size;
+}
+
+// Makes room for an entry of size bytes
+void Decoder::evict(quint32 size)
+{
+    while (!table.empty() && tableSize + size > maxTableSize) {
+        const auto &header = table.back();
+        tableSize -= quint32(header.first.size() + header.second.size()) + 32;
+        table.pop_back();
+    }
+}
+
+} // namespace QHttpServerHpack
+
+QT_END_NAMESPACE
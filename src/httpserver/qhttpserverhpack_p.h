@@ -0,0 +1,91 @@
+/****************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtHttpServer module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QHTTPSERVERHPACK_P_H
+#define QHTTPSERVERHPACK_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists for the convenience
+// of QHttpServer. This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+
+#include <QtHttpServer/qthttpserverglobal.h>
+
+#include <QtCore/qbytearray.h>
+#include <QtCore/qpair.h>
+#include <QtCore/qvector.h>
+
+#include <deque>
+
+QT_BEGIN_NAMESPACE
+
+namespace QHttpServerHpack {
+
+using Header = QPair<QByteArray, QByteArray>;
+using HeaderList = QVector<Header>;
+
+class Q_HTTPSERVER_EXPORT Decoder
+{
+public:
+    explicit Decoder(quint32 maxTableSize = 4096);
+
+    enum class Result {
+        Ok,
+        TooLarge,
+        Error
+    };
+    Result decode(const uchar *data, int size, int maxListSize, HeaderList *headers);
+
+private:
+    bool decodeInteger(const uchar *&pos, const uchar *end, int prefix, quint32 *value) const;
+    bool decodeString(const uchar *&pos, const uchar *end, QByteArray *string) const;
+    bool decodeLiteral(const uchar *&pos, const uchar *end, int prefix, Header *header) const;
+    bool lookup(quint32 index, Header *header) const;
+    void insert(const Header &header);
+    void evict(quint32 size);
+
+    // Newest entry first, as indexed
+    std::deque<Header> table;
+    quint32 tableSize = 0;
+    quint32 maxTableSize;
+    const quint32 tableSizeLimit;
+};
+
+Q_HTTPSERVER_EXPORT void encode(const HeaderList &headers, QByteArray *block);
+
+} // namespace QHttpServerHpack
+
+QT_END_NAMESPACE
+
+#endif // QHTTPSERVERHPACK_P_H
@@ -0,0 +1,1273 @@
+/****************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtHttpServer module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <private/qhttpserverhttp2connection_p.h>
+
+#include <private/qhttpserverconnection_p.h>
+#include <private/qhttpserverworker_p.h>
+
+#include <QtCore/qendian.h>
+#include <QtCore/qloggingcategory.h>
+#include <QtCore/qmetaobject.h>
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+QT_BEGIN_NAMESPACE
+
+Q_LOGGING_CATEGORY(lcHttp2, "qt.httpserver.http2")
+
+namespace {
+
+// RFC 7540, section 6
+enum FrameType : uchar {
+    DataFrame = 0x0,
+    HeadersFrame = 0x1,
+    PriorityFrame = 0x2,
+    RstStreamFrame = 0x3,
+    SettingsFrame = 0x4,
+    PushPromiseFrame = 0x5,
+    PingFrame = 0x6,
+    GoAwayFrame = 0x7,
+    WindowUpdateFrame = 0x8,
+    ContinuationFrame = 0x9
+};
+
+enum FrameFlag : uchar {
+    EndStreamFlag = 0x1,
+    AckFlag = 0x1,
+    EndHeadersFlag = 0x4,
+    PaddedFlag = 0x8,
+    PriorityFlag = 0x20
+};
+
+// RFC 7540, section 7
+enum ErrorCode : quint32 {
+    NoError = 0x0,
+    ProtocolError = 0x1,
+    InternalError = 0x2,
+    FlowControlError = 0x3,
+    StreamClosedError = 0x5,
+    FrameSizeError = 0x6,
+    RefusedStreamError = 0x7,
+    CompressionError = 0x9,
+    EnhanceYourCalmError = 0xb
+};
+
+// RFC 7540, section 6.5.2
+enum Setting : quint16 {
+    EnablePushSetting = 0x2,
+    MaxConcurrentStreamsSetting = 0x3,
+    InitialWindowSizeSetting = 0x4,
+    MaxFrameSizeSetting = 0x5,
+    MaxHeaderListSizeSetting = 0x6
+};
+
+const char preface[] = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+constexpr int prefaceSize = sizeof(preface) - 1;
+constexpr int frameHeaderSize = 9;
+constexpr quint32 defaultMaxFrameSize = 16384;
+constexpr quint32 largestMaxFrameSize = 16777215;
+constexpr qint64 defaultWindowSize = 65535;
+constexpr qint64 maxWindowSize = 0x7fffffff;
+// Header blocks split into CONTINUATION frames are collected up to this size
+constexpr int maxHeaderBlockSize = 256 * 1024;
+// Limit of header lists the client is not told about, if the
+// configuration has no limits
+constexpr int defaultMaxHeaderListSize = 1024 * 1024;
+// DATA frames are written while the socket buffers less than this
+constexpr qint64 maxBufferedOutput = 256 * 1024;
+
+bool isConnectionSpecific(const QByteArray &name)
+{
+    return name == "connection" || name == "keep-alive" || name == "proxy-connection"
+            || name == "transfer-encoding" || name == "upgrade";
+}
+
+bool isValidField(const QByteArray &field)
+{
+    return std::none_of(field.cbegin(), field.cend(), [](char c) {
+        return c == '\r' || c == '\n' || c == '\0';
+    });
+}
+
+} // namespace
+
+/*!
+    \internal
+    \class QHttpServerHttp2Stream
+
+    Stands in for the socket of a QHttpServerConnection serving a single
+    HTTP/2 stream, see QHttpServerConfiguration::setHttp2Enabled().
+
+    The request arrives as HTTP/1.1, synthesized by the
+    QHttpServerHttp2Connection from the HEADERS and DATA frames of the
+    stream, so that the request parser, the routes and the responders
+    work as they do for HTTP/1.1 clients. What the responders write is
+    HTTP/1.1 again, its head is turned into a HEADERS frame and its body
+    into DATA frames.
+
+    Closing the stream ends it, or resets it if no response was started.
+    The stream has no socket descriptor, and no TLS of its own.
+*/
+QHttpServerHttp2Stream::QHttpServerHttp2Stream(QHttpServerHttp2Connection *connection,
+                                               quint32 id, const QHostAddress &peerAddress,
+                                               quint16 peerPort,
+                                               const ConnectionState &connectionState,
+                                               bool headRequest)
+    : QTcpSocket(connection), connection(connection), id(id), state(connectionState),
+      headRequest(headRequest)
+{
+    setPeerAddress(peerAddress);
+    setPeerPort(peerPort);
+    setSocketState(QAbstractSocket::ConnectedState);
+    setOpenMode(QIODevice::ReadWrite | QIODevice::Unbuffered);
+}
+
+QHttpServerHttp2Stream::~QHttpServerHttp2Stream()
+{
+    if (connection)
+        connection->finishStream(id);
+}
+
+qint64 QHttpServerHttp2Stream::bytesAvailable() const
+{
+    return request.size() - requestOffset;
+}
+
+qint64 QHttpServerHttp2Stream::bytesToWrite() const
+{
+    return connection ? connection->pendingBytes(id) : 0;
+}
+
+/*!
+    \internal
+
+    Ends the response once the DATA frames queued so far are sent.
+*/
+void QHttpServerHttp2Stream::disconnectFromHost()
+{
+    if (state() == QAbstractSocket::UnconnectedState)
+        return;
+    if (connection) {
+        connection->finishStream(id);
+        connection.clear();
+    }
+    QIODevice::close();
+    setSocketState(QAbstractSocket::UnconnectedState);
+    Q_EMIT disconnected();
+}
+
+/*!
+    \internal
+
+    Appends \a data to the request, and tells the reader of the stream.
+*/
+void QHttpServerHttp2Stream::appendRequest(const QByteArray &data)
+{
+    request.append(data);
+    if (readyReadPending)
+        return;
+    readyReadPending = true;
+    QMetaObject::invokeMethod(this, [this]() {
+        readyReadPending = false;
+        if (state() != QAbstractSocket::UnconnectedState && bytesAvailable())
+            Q_EMIT readyRead();
+    }, Qt::QueuedConnection);
+}
+
+/*!
+    \internal
+
+    Called once the response is sent, whatever is written to the stream
+    past this point is dropped.
+*/
+void QHttpServerHttp2Stream::detach()
+{
+    connection.clear();
+}
+
+/*!
+    \internal
+
+    Called once the stream is gone, reset by the client or with its
+    connection. Nothing written to the stream is sent past this point.
+*/
+void QHttpServerHttp2Stream::resetByPeer()
+{
+    connection.clear();
+    if (state() == QAbstractSocket::UnconnectedState)
+        return;
+    setSocketState(QAbstractSocket::UnconnectedState);
+    setSocketError(QAbstractSocket::RemoteHostClosedError);
+    QMetaObject::invokeMethod(this, [this]() {
+        QIODevice::close();
+        Q_EMIT disconnected();
+    }, Qt::QueuedConnection);
+}
+
+qint64 QHttpServerHttp2Stream::readData(char *data, qint64 maxSize)
+{
+    const qint64 size = qMin(maxSize, bytesAvailable());
+    if (size <= 0)
+        return state() == QAbstractSocket::UnconnectedState ? -1 : 0;
+    std::memcpy(data, request.constData() + requestOffset, size_t(size));
+    requestOffset += int(size);
+    if (requestOffset == request.size()) {
+        request.resize(0);
+        requestOffset = 0;
+    }
+    if (connection)
+        connection->consumed(id, size);
+    return size;
+}
+
+qint64 QHttpServerHttp2Stream::writeData(const char *data, qint64 size)
+{
+    const char *pos = data;
+    qint64 left = size;
+    while (left > 0 && !ended && connection) {
+        if (!headSent) {
+            const int searchFrom = qMax(0, responseHead.size() - 3);
+            responseHead.append(pos, int(left));
+            const int end = responseHead.indexOf("\r\n\r\n", searchFrom);
+            if (end < 0)
+                return size;
+            const int consumed = int(left) - (responseHead.size() - end - 4);
+            responseHead.truncate(end + 4);
+            pos += consumed;
+            left -= consumed;
+            writeResponseHead();
+            continue;
+        }
+
+        // Past the announced length there is nothing HTTP/2 could do with
+        // the bytes, they are dropped
+        const qint64 chunk = remainingBody < 0 ? left : qMin(left, remainingBody);
+        if (remainingBody >= 0)
+            remainingBody -= chunk;
+        ended = remainingBody == 0;
+        connection->sendData(id, pos, chunk, ended);
+        pos += chunk;
+        left -= chunk;
+    }
+    return size;
+}
+
+/*!
+    \internal
+
+    Sends the HTTP/1.1 response head collected in responseHead as a
+    HEADERS frame, without the fields HTTP/2 forbids.
+*/
+void QHttpServerHttp2Stream::writeResponseHead()
+{
+    const QByteArray head = std::exchange(responseHead, QByteArray());
+    const int statusLineEnd = head.indexOf("\r\n");
+    const QByteArray status = head.mid(9, 3);
+    if (!head.startsWith("HTTP/1.") || status.size() != 3) {
+        qCWarning(lcHttp2, "Invalid response on stream %u", id);
+        ended = true;
+        connection->finishStream(id);
+        return;
+    }
+
+    QHttpServerHpack::HeaderList headers;
+    headers.append(qMakePair(QByteArrayLiteral(":status"), status));
+    qint64 contentLength = -1;
+    int lineStart = statusLineEnd + 2;
+    for (int lineEnd; (lineEnd = head.indexOf("\r\n", lineStart)) > lineStart;
+         lineStart = lineEnd + 2) {
+        const QByteArray line = head.mid(lineStart, lineEnd - lineStart);
+        const int colon = line.indexOf(':');
+        if (colon <= 0)
+            continue;
+        const QByteArray name = line.left(colon).trimmed().toLower();
+        const QByteArray value = line.mid(colon + 1).trimmed();
+        if (isConnectionSpecific(name))
+            continue;
+        if (name == "content-length") {
+            bool ok = false;
+            contentLength = value.toLongLong(&ok);
+            if (!ok)
+                contentLength = -1;
+        }
+        headers.append(qMakePair(name, value));
+    }
+
+    const int statusCode = status.toInt();
+    if (statusCode < 200) {
+        // Informational, the final response head follows
+        connection->sendHeaders(id, headers, false);
+        return;
+    }
+
+    headSent = true;
+    remainingBody = headRequest || statusCode == 204 || statusCode == 304 ? 0 : contentLength;
+    ended = remainingBody == 0;
+    connection->sendHeaders(id, headers, ended);
+}
+
+/*!
+    \internal
+    \class QHttpServerHttp2Connection
+
+    Serves HTTP/2, as specified in RFC 7540, on the socket of a
+    QHttpServerConnection.
+
+    Every stream gets a QHttpServerConnection of its own from the worker,
+    whose socket is a QHttpServerHttp2Stream. The streams are independent
+    of each other, their responses are interleaved in DATA frames as the
+    flow control windows of the client allow.
+
+    The client is given back flow control credit for the data of a
+    stream as the stream reads it, so that a handler reading a streamed
+    body slowly holds back that stream only. The window of the
+    connection is credited as data arrives.
+
+    Server push is not supported, neither are CONNECT requests.
+*/
+QHttpServerHttp2Connection::QHttpServerHttp2Connection(QHttpServerConnection *connection)
+    : connection(connection),
+      socket(connection->socket),
+      maxFrameSize(defaultMaxFrameSize),
+      initialWindowSize(defaultWindowSize),
+      sendWindow(defaultWindowSize),
+      receiveWindow(defaultWindowSize)
+{
+    const auto &configuration = connection->worker->configuration;
+    maxConcurrentStreams = configuration.http2MaxConcurrentStreams();
+    // HTTP/2 counts 32 bytes per field on top of its name and value, and
+    // the request line comes as fields too. The request parser enforces
+    // the limits of the configuration on the request it gets.
+    if (configuration.maxHeaderSize()) {
+        maxHeaderListSize = configuration.maxHeaderSize()
+                + 32 * (configuration.maxHeaderCount() + 4)
+                + configuration.maxUrlLength();
+    }
+}
+
+QHttpServerHttp2Connection::~QHttpServerHttp2Connection()
+{
+    for (auto &stream : streams) {
+        if (stream.second.socket)
+            stream.second.socket->resetByPeer();
+    }
+}
+
+/*!
+    \internal
+
+    Returns the HTTP/1.1 \a message which asked for an upgrade to h2c,
+    without the fields of the upgrade, to be served as stream 1.
+*/
+QByteArray QHttpServerHttp2Connection::upgradedRequest(const QByteArray &message)
+{
+    QByteArray request;
+    request.reserve(message.size());
+    int lineStart = 0;
+    for (int lineEnd; (lineEnd = message.indexOf("\r\n", lineStart)) >= 0;
+         lineStart = lineEnd + 2) {
+        const QByteArray line = message.mid(lineStart, lineEnd + 2 - lineStart);
+        const QByteArray name = line.left(line.indexOf(':')).trimmed().toLower();
+        if (name == "connection" || name == "upgrade" || name == "http2-settings")
+            continue;
+        request.append(line);
+    }
+    return request;
+}
+
+/*!
+    \internal
+
+    Takes over the socket of the connection, with the bytes already
+    \a received from it. For a connection upgraded from HTTP/1.1, the
+    \a upgradeRequest is served as stream 1, and \a upgradeSettings is
+    the value of its \c HTTP2-Settings field.
+*/
+void QHttpServerHttp2Connection::start(const QByteArray &received,
+                                       const QByteArray &upgradeRequest,
+                                       const QByteArray &upgradeSettings)
+{
+    // Streams carry the address the request had, which might be the one
+    // of a PROXY protocol header, and share the connection contexts
+    peerAddress = connection->request.remoteAddress();
+    peerPort = connection->request.remotePort();
+    connectionState = connection->request.d->sharedConnectionState();
+    connection->setPhase(QHttpServerConnection::Phase::Handling, 0);
+    connect(socket, &QTcpSocket::readyRead, this, &QHttpServerHttp2Connection::handleReadyRead);
+    connect(socket, &QTcpSocket::bytesWritten, this, &QHttpServerHttp2Connection::flush);
+
+    char settings[12];
+    qToBigEndian<quint16>(MaxConcurrentStreamsSetting, settings);
+    qToBigEndian<quint32>(quint32(maxConcurrentStreams), settings + 2);
+    qToBigEndian<quint16>(MaxHeaderListSizeSetting, settings + 6);
+    qToBigEndian<quint32>(quint32(maxHeaderListSize), settings + 8);
+    writeFrame(SettingsFrame, 0, 0, settings, maxHeaderListSize ? 12 : 6);
+    if (!maxHeaderListSize)
+        maxHeaderListSize = defaultMaxHeaderListSize;
+
+    if (!upgradeRequest.isEmpty()) {
+        const QByteArray payload = QByteArray::fromBase64(upgradeSettings,
+                                                          QByteArray::Base64UrlEncoding);
+        if (applySettings(reinterpret_cast<const uchar *>(payload.constData()),
+                          quint32(payload.size())) != NoError) {
+            connectionError(ProtocolError);
+            return;
+        }
+        // The request was complete, the client waits for the response
+        lastStreamId = 1;
+        Stream &stream = streams[1];
+        stream.sendWindow = initialWindowSize;
+        stream.receiveWindow = defaultWindowSize;
+        stream.remoteClosed = true;
+        startStream(1, upgradeRequest, upgradeRequest.startsWith("HEAD "));
+    }
+
+    input = received;
+    inputOffset = 0;
+    updatePhase();
+    processFrames();
+    flush();
+}
+
+/*!
+    \internal
+
+    Tells the client not to open further streams, and closes the
+    connection once the open ones are done.
+*/
+void QHttpServerHttp2Connection::drain()
+{
+    if (closed || goingAway)
+        return;
+    goingAway = true;
+    writeGoAway(NoError);
+    updatePhase();
+}
+
+/*!
+    \internal
+
+    Closes the connection, which was idle for too long.
+*/
+void QHttpServerHttp2Connection::close()
+{
+    if (closed)
+        return;
+    if (!goingAway)
+        writeGoAway(NoError);
+    closed = true;
+    socket->disconnectFromHost();
+}
+
+/*!
+    \internal
+
+    Sends \a headers as the response head of stream \a streamId, or as
+    an informational one, ending the stream if \a endStream is set.
+*/
+void QHttpServerHttp2Connection::sendHeaders(quint32 streamId,
+                                             const QHttpServerHpack::HeaderList &headers,
+                                             bool endStream)
+{
+    const auto it = streams.find(streamId);
+    if (closed || it == streams.end())
+        return;
+    QByteArray block;
+    QHttpServerHpack::encode(headers, &block);
+    writeHeaderBlock(streamId, block, endStream);
+    // An informational head, 100 Continue, is not the response yet
+    const bool informational = !headers.isEmpty() && headers.first().first == ":status"
+            && headers.first().second.startsWith('1');
+    if (!informational)
+        it->second.headersSent = true;
+    if (endStream) {
+        streamSent(it);
+        updatePhase();
+    }
+}
+
+/*!
+    \internal
+
+    Queues \a size bytes at \a data as the body of stream \a streamId,
+    ending the stream after them if \a endStream is set.
+*/
+void QHttpServerHttp2Connection::sendData(quint32 streamId, const char *data, qint64 size,
+                                          bool endStream)
+{
+    const auto it = streams.find(streamId);
+    if (closed || it == streams.end())
+        return;
+    it->second.output.append(data, int(size));
+    it->second.endQueued = it->second.endQueued || endStream;
+    flush();
+}
+
+/*!
+    \internal
+
+    Ends stream \a streamId once its queued data is sent, or resets it if
+    no final response head was sent.
+*/
+void QHttpServerHttp2Connection::finishStream(quint32 streamId)
+{
+    const auto it = streams.find(streamId);
+    if (closed || it == streams.end())
+        return;
+    Stream &stream = it->second;
+    stream.socket.clear();
+    if (!stream.headersSent) {
+        resetStream(streamId, InternalError);
+        return;
+    }
+    if (!stream.endQueued) {
+        stream.endQueued = true;
+        flush();
+    }
+}
+
+/*!
+    \internal
+
+    Called when stream \a streamId read \a size bytes of its request.
+*/
+void QHttpServerHttp2Connection::consumed(quint32 streamId, qint64 size)
+{
+    const auto it = streams.find(streamId);
+    if (closed || it == streams.end())
+        return;
+    // Only the body counts, the head synthesized for the stream does not
+    const qint64 credit = qMin(size, it->second.buffered);
+    if (credit <= 0)
+        return;
+    it->second.buffered -= credit;
+    creditStream(streamId, it->second, credit);
+}
+
+/*!
+    \internal
+
+    Returns the bytes of stream \a streamId waiting for the flow control
+    windows.
+*/
+qint64 QHttpServerHttp2Connection::pendingBytes(quint32 streamId) const
+{
+    const auto it = streams.find(streamId);
+    if (it == streams.end())
+        return 0;
+    return it->second.output.size() - it->second.outputOffset;
+}
+
+void QHttpServerHttp2Connection::handleReadyRead()
+{
+    if (closed) {
+        socket->readAll();
+        return;
+    }
+    if (inputOffset) {
+        input.remove(0, inputOffset);
+        inputOffset = 0;
+    }
+    input.append(socket->readAll());
+    processFrames();
+    flush();
+}
+
+void QHttpServerHttp2Connection::processFrames()
+{
+    while (!closed) {
+        const int available = input.size() - inputOffset;
+        const uchar *data = reinterpret_cast<const uchar *>(input.constData()) + inputOffset;
+        if (expectsPreface) {
+            const int size = qMin(available, prefaceSize);
+            if (std::memcmp(data, preface, size_t(size)) != 0) {
+                qCDebug(lcHttp2, "Invalid connection preface");
+                connectionError(ProtocolError);
+                return;
+            }
+            if (size < prefaceSize)
+                return;
+            inputOffset += prefaceSize;
+            expectsPreface = false;
+            continue;
+        }
+
+        if (available < frameHeaderSize)
+            return;
+        const quint32 length = quint32(data[0]) << 16 | quint32(data[1]) << 8 | data[2];
+        const uchar type = data[3];
+        const uchar flags = data[4];
+        const quint32 streamId = qFromBigEndian<quint32>(data + 5) & 0x7fffffff;
+        // The client was not told of any other size
+        if (length > defaultMaxFrameSize) {
+            connectionError(FrameSizeError);
+            return;
+        }
+        if (quint32(available - frameHeaderSize) < length)
+            return;
+        inputOffset += frameHeaderSize + int(length);
+
+        if (!settingsReceived && type != SettingsFrame) {
+            connectionError(ProtocolError);
+            return;
+        }
+        if ((headerBlockStream && (type != ContinuationFrame || streamId != headerBlockStream))
+                || (!headerBlockStream && type == ContinuationFrame)) {
+            connectionError(ProtocolError);
+            return;
+        }
+        handleFrame(type, flags, streamId, data + frameHeaderSize, length);
+    }
+}
+
+void QHttpServerHttp2Connection::handleFrame(uchar type, uchar flags, quint32 streamId,
+                                             const uchar *payload, quint32 length)
+{
+    switch (type) {
+    case DataFrame:
+        handleData(flags, streamId, payload, length);
+        break;
+    case HeadersFrame:
+        handleHeaders(flags, streamId, payload, length);
+        break;
+    case PriorityFrame:
+        // Streams are served in the order they come
+        if (!streamId)
+            connectionError(ProtocolError);
+        else if (length != 5)
+            resetStream(streamId, FrameSizeError);
+        break;
+    case RstStreamFrame: {
+        if (!streamId || streamId > lastStreamId) {
+            connectionError(ProtocolError);
+            break;
+        }
+        if (length != 4) {
+            connectionError(FrameSizeError);
+            break;
+        }
+        const auto it = streams.find(streamId);
+        if (it == streams.end())
+            break;
+        if (it->second.socket)
+            it->second.socket->resetByPeer();
+        streams.erase(it);
+        updatePhase();
+        break;
+    }
+    case SettingsFrame:
+        handleSettings(flags, streamId, payload, length);
+        break;
+    case PushPromiseFrame:
+        // Only servers push
+        connectionError(ProtocolError);
+        break;
+    case PingFrame:
+        if (streamId)
+            connectionError(ProtocolError);
+        else if (length != 8)
+            connectionError(FrameSizeError);
+        else if (!(flags & AckFlag))
+            writeFrame(PingFrame, AckFlag, 0, reinterpret_cast<const char *>(payload), 8);
+        break;
+    case GoAwayFrame:
+        if (streamId) {
+            connectionError(ProtocolError);
+            break;
+        }
+        // The streams the client opened so far are still served
+        goingAway = true;
+        updatePhase();
+        break;
+    case WindowUpdateFrame:
+        handleWindowUpdate(streamId, payload, length);
+        break;
+    case ContinuationFrame:
+        headerBlock.append(reinterpret_cast<const char *>(payload), int(length));
+        if (headerBlock.size() > maxHeaderBlockSize) {
+            connectionError(EnhanceYourCalmError);
+            break;
+        }
+        if (flags & EndHeadersFlag) {
+            headerBlockStream = 0;
+            handleHeaderBlock(streamId);
+        }
+        break;
+    default:
+        // Unknown frames are ignored
+        break;
+    }
+}
+
+void QHttpServerHttp2Connection::handleData(uchar flags, quint32 streamId, const uchar *payload,
+                                            quint32 length)
+{
+    if (!streamId) {
+        connectionError(ProtocolError);
+        return;
+    }
+    quint32 offset = 0;
+    quint32 padding = 0;
+    if (flags & PaddedFlag) {
+        if (!length) {
+            connectionError(FrameSizeError);
+            return;
+        }
+        offset = 1;
+        padding = payload[0];
+        if (offset + padding > length) {
+            connectionError(ProtocolError);
+            return;
+        }
+    }
+
+    // The whole frame counts against the windows, padding included
+    receiveWindow -= length;
+    if (receiveWindow < 0) {
+        connectionError(FlowControlError);
+        return;
+    }
+    unacknowledged += length;
+    if (unacknowledged >= defaultWindowSize / 2) {
+        writeWindowUpdate(0, quint32(unacknowledged));
+        receiveWindow += unacknowledged;
+        unacknowledged = 0;
+    }
+
+    const auto it = streams.find(streamId);
+    if (it == streams.end() || it->second.remoteClosed) {
+        if (streamId > lastStreamId)
+            connectionError(ProtocolError);
+        else if (it != streams.end())
+            resetStream(streamId, StreamClosedError);
+        // Otherwise the stream was reset or answered before the client
+        // knew, its data is dropped
+        return;
+    }
+
+    Stream &stream = it->second;
+    stream.receiveWindow -= length;
+    if (stream.receiveWindow < 0) {
+        resetStream(streamId, FlowControlError);
+        return;
+    }
+    const qint64 size = length - offset - padding;
+    if (stream.socket && size) {
+        QByteArray data;
+        if (stream.chunked)
+            data = QByteArray::number(size, 16) + "\r\n";
+        data.append(reinterpret_cast<const char *>(payload) + offset, int(size));
+        if (stream.chunked)
+            data.append("\r\n");
+        stream.buffered += size;
+        stream.socket->appendRequest(data);
+        creditStream(streamId, stream, length - size);
+    } else {
+        creditStream(streamId, stream, length);
+    }
+
+    if (flags & EndStreamFlag)
+        endRequest(stream);
+}
+
+void QHttpServerHttp2Connection::handleHeaders(uchar flags, quint32 streamId,
+                                               const uchar *payload, quint32 length)
+{
+    if (!streamId || !(streamId & 1)) {
+        connectionError(ProtocolError);
+        return;
+    }
+    quint32 offset = 0;
+    quint32 padding = 0;
+    if (flags & PaddedFlag) {
+        if (!length) {
+            connectionError(FrameSizeError);
+            return;
+        }
+        offset = 1;
+        padding = payload[0];
+    }
+    if (flags & PriorityFlag)
+        offset += 5;
+    if (offset + padding > length) {
+        connectionError(ProtocolError);
+        return;
+    }
+
+    headerBlock = QByteArray(reinterpret_cast<const char *>(payload) + offset,
+                             int(length - offset - padding));
+    headerBlockFlags = flags;
+    if (flags & EndHeadersFlag)
+        handleHeaderBlock(streamId);
+    else
+        headerBlockStream = streamId;
+}
+
+void QHttpServerHttp2Connection::handleHeaderBlock(quint32 streamId)
+{
+    QHttpServerHpack::HeaderList headers;
+    const auto result = decoder.decode(reinterpret_cast<const uchar *>(headerBlock.constData()),
+                                       headerBlock.size(), maxHeaderListSize, &headers);
+    headerBlock.clear();
+    if (result == QHttpServerHpack::Decoder::Result::Error) {
+        connectionError(CompressionError);
+        return;
+    }
+    const bool endStream = headerBlockFlags & EndStreamFlag;
+
+    if (streamId <= lastStreamId) {
+        // Trailers, which are not passed on
+        const auto it = streams.find(streamId);
+        if (it == streams.end())
+            return;
+        if (it->second.remoteClosed)
+            resetStream(streamId, StreamClosedError);
+        else if (!endStream)
+            resetStream(streamId, ProtocolError);
+        else
+            endRequest(it->second);
+        return;
+    }
+
+    lastStreamId = streamId;
+    if (goingAway)
+        return;
+    if (streams.size() >= std::size_t(maxConcurrentStreams)) {
+        resetStream(streamId, RefusedStreamError);
+        return;
+    }
+    if (result == QHttpServerHpack::Decoder::Result::TooLarge) {
+        QByteArray block;
+        QHttpServerHpack::encode({ qMakePair(QByteArrayLiteral(":status"),
+                                             QByteArrayLiteral("431")) }, &block);
+        writeHeaderBlock(streamId, block, true);
+        if (!endStream)
+            writeFrame(RstStreamFrame, 0, streamId, "\0\0\0\0", 4);
+        return;
+    }
+
+    bool chunked = false;
+    bool headRequest = false;
+    const QByteArray request = requestHead(headers, endStream, &chunked, &headRequest);
+    if (request.isEmpty()) {
+        qCDebug(lcHttp2, "Malformed request on stream %u", streamId);
+        resetStream(streamId, ProtocolError);
+        return;
+    }
+
+    Stream &stream = streams[streamId];
+    stream.sendWindow = initialWindowSize;
+    stream.receiveWindow = defaultWindowSize;
+    stream.chunked = chunked;
+    stream.remoteClosed = endStream;
+    startStream(streamId, request, headRequest);
+}
+
+void QHttpServerHttp2Connection::handleSettings(uchar flags, quint32 streamId,
+                                                const uchar *payload, quint32 length)
+{
+    if (streamId) {
+        connectionError(ProtocolError);
+        return;
+    }
+    if (flags & AckFlag) {
+        if (length)
+            connectionError(FrameSizeError);
+        return;
+    }
+    if (length % 6) {
+        connectionError(FrameSizeError);
+        return;
+    }
+    const quint32 error = applySettings(payload, length);
+    if (error != NoError) {
+        connectionError(error);
+        return;
+    }
+    settingsReceived = true;
+    writeFrame(SettingsFrame, AckFlag, 0);
+}
+
+void QHttpServerHttp2Connection::handleWindowUpdate(quint32 streamId, const uchar *payload,
+                                                    quint32 length)
+{
+    if (length != 4) {
+        connectionError(FrameSizeError);
+        return;
+    }
+    const qint64 increment = qFromBigEndian<quint32>(payload) & 0x7fffffff;
+    if (!streamId) {
+        sendWindow += increment;
+        if (!increment)
+            connectionError(ProtocolError);
+        else if (sendWindow > maxWindowSize)
+            connectionError(FlowControlError);
+        return;
+    }
+
+    const auto it = streams.find(streamId);
+    if (it == streams.end())
+        return;
+    it->second.sendWindow += increment;
+    if (!increment)
+        resetStream(streamId, ProtocolError);
+    else if (it->second.sendWindow > maxWindowSize)
+        resetStream(streamId, FlowControlError);
+}
+
+/*!
+    \internal
+
+    Applies the settings of the client in the \a length bytes at
+    \a payload. Returns the error code of the connection error they
+    cause, if any.
+*/
+quint32 QHttpServerHttp2Connection::applySettings(const uchar *payload, quint32 length)
+{
+    for (quint32 i = 0; i + 6 <= length; i += 6) {
+        const quint16 id = qFromBigEndian<quint16>(payload + i);
+        const quint32 value = qFromBigEndian<quint32>(payload + i + 2);
+        switch (id) {
+        case EnablePushSetting:
+            if (value > 1)
+                return ProtocolError;
+            break;
+        case InitialWindowSizeSetting: {
+            if (value > maxWindowSize)
+                return FlowControlError;
+            // Applies to the windows of the open streams too
+            const qint64 delta = qint64(value) - initialWindowSize;
+            for (auto &stream : streams) {
+                stream.second.sendWindow += delta;
+                if (stream.second.sendWindow > maxWindowSize)
+                    return FlowControlError;
+            }
+            initialWindowSize = value;
+            break;
+        }
+        case MaxFrameSizeSetting:
+            if (value < defaultMaxFrameSize || value > largestMaxFrameSize)
+                return ProtocolError;
+            maxFrameSize = value;
+            break;
+        default:
+            // The table size of the client concerns an encoder which
+            // does not use its dynamic table
+            break;
+        }
+    }
+    return NoError;
+}
+
+/*!
+    \internal
+
+    Returns the HTTP/1.1 head of the request in \a headers, or an empty
+    array if it is malformed. Sets \a chunked if the body comes without
+    a length, and \a headRequest if it is a HEAD request.
+*/
+QByteArray QHttpServerHttp2Connection::requestHead(const QHttpServerHpack::HeaderList &headers,
+                                                   bool endStream, bool *chunked,
+                                                   bool *headRequest) const
+{
+    QByteArray method;
+    QByteArray scheme;
+    QByteArray authority;
+    QByteArray path;
+    QByteArray fields;
+    QByteArray cookie;
+    bool regularSeen = false;
+    bool contentLength = false;
+    for (const auto &header : headers) {
+        const QByteArray &name = header.first;
+        const QByteArray &value = header.second;
+        if (name.isEmpty() || !isValidField(name) || !isValidField(value)
+                || name.contains(' ') || name.toLower() != name) {
+            return QByteArray();
+        }
+
+        if (name.startsWith(':')) {
+            QByteArray *pseudoHeader = nullptr;
+            if (name == ":method")
+                pseudoHeader = &method;
+            else if (name == ":scheme")
+                pseudoHeader = &scheme;
+            else if (name == ":authority")
+                pseudoHeader = &authority;
+            else if (name == ":path")
+                pseudoHeader = &path;
+            if (regularSeen || !pseudoHeader || !pseudoHeader->isEmpty() || value.isEmpty())
+                return QByteArray();
+            *pseudoHeader = value;
+            continue;
+        }
+
+        regularSeen = true;
+        if (isConnectionSpecific(name) || (name == "te" && value != "trailers"))
+            return QByteArray();
+        if (name == "cookie") {
+            // Split into several fields for better compression
+            if (!cookie.isEmpty())
+                cookie.append("; ");
+            cookie.append(value);
+            continue;
+        }
+        if (name == "host" && !authority.isEmpty())
+            continue;
+        contentLength = contentLength || name == "content-length";
+        fields.append(name + ": " + value + "\r\n");
+    }
+    if (method.isEmpty() || scheme.isEmpty() || path.isEmpty() || method.contains(' ')
+            || path.contains(' ')) {
+        return QByteArray();
+    }
+
+    *headRequest = method == "HEAD";
+    *chunked = !endStream && !contentLength;
+    QByteArray head = method + ' ';
+    if (authority.isEmpty())
+        head += path;
+    else
+        head += scheme + "://" + authority + path;
+    head += " HTTP/1.1\r\n";
+    if (!authority.isEmpty())
+        head += "host: " + authority + "\r\n";
+    head += fields;
+    if (!cookie.isEmpty())
+        head += "cookie: " + cookie + "\r\n";
+    if (*chunked)
+        head += "transfer-encoding: chunked\r\n";
+    head += "\r\n";
+    return head;
+}
+
+void QHttpServerHttp2Connection::startStream(quint32 streamId, const QByteArray &request,
+                                             bool headRequest)
+{
+    auto stream = new QHttpServerHttp2Stream(this, streamId, peerAddress, peerPort,
+                                             connectionState, headRequest);
+    streams[streamId].socket = stream;
+    stream->appendRequest(request);
+    updatePhase();
+
+    // The stream is served after the frames read so far, as their data
+    // might belong to it
+    auto worker = connection->worker;
+    QMetaObject::invokeMethod(stream, [worker, stream]() {
+        worker->handleStream(stream);
+    }, Qt::QueuedConnection);
+}
+
+void QHttpServerHttp2Connection::endRequest(Stream &stream)
+{
+    stream.remoteClosed = true;
+    if (stream.chunked && stream.socket)
+        stream.socket->appendRequest(QByteArrayLiteral("0\r\n\r\n"));
+}
+
+void QHttpServerHttp2Connection::creditStream(quint32 streamId, Stream &stream, qint64 size)
+{
+    stream.unacknowledged += size;
+    if (stream.remoteClosed || stream.unacknowledged < defaultWindowSize / 2)
+        return;
+    writeWindowUpdate(streamId, quint32(stream.unacknowledged));
+    stream.receiveWindow += stream.unacknowledged;
+    stream.unacknowledged = 0;
+}
+
+/*!
+    \internal
+
+    Writes the queued data of the streams, as far as the flow control
+    windows allow, taking turns between the streams. Streams whose
+    response is complete are removed.
+*/
+void QHttpServerHttp2Connection::flush()
+{
+    bool progress = true;
+    while (progress && !closed) {
+        progress = false;
+        for (auto it = streams.begin(); it != streams.end(); ) {
+            Stream &stream = it->second;
+            const qint64 pending = stream.output.size() - stream.outputOffset;
+            if (!stream.endQueued && !pending) {
+                ++it;
+                continue;
+            }
+            if (socket->bytesToWrite() >= maxBufferedOutput)
+                return; // Resumed once the socket wrote
+            // The end of the stream goes out in an empty frame if need be
+            const qint64 size = pending ? std::min({ pending, stream.sendWindow, sendWindow,
+                                                     qint64(maxFrameSize) })
+                                        : 0;
+            if (pending && size <= 0) {
+                ++it;
+                continue;
+            }
+
+            const bool end = stream.endQueued && size == pending;
+            writeFrame(DataFrame, end ? EndStreamFlag : 0, it->first,
+                       stream.output.constData() + stream.outputOffset, int(size));
+            sendWindow -= size;
+            stream.sendWindow -= size;
+            stream.outputOffset += int(size);
+            if (stream.outputOffset == stream.output.size()) {
+                stream.output.resize(0);
+                stream.outputOffset = 0;
+            }
+            if (size && stream.socket) {
+                const QPointer<QHttpServerHttp2Stream> target = stream.socket;
+                QMetaObject::invokeMethod(target.data(), [target, size]() {
+                    Q_EMIT target->bytesWritten(size);
+                }, Qt::QueuedConnection);
+            }
+            progress = true;
+            it = end ? streamSent(it) : std::next(it);
+        }
+    }
+    updatePhase();
+}
+
+/*!
+    \internal
+
+    Removes the stream at \a it, whose response is complete, telling the
+    client to stop sending its request if it did not finish yet.
+*/
+QHttpServerHttp2Connection::Streams::iterator
+QHttpServerHttp2Connection::streamSent(Streams::iterator it)
+{
+    if (it->second.remoteClosed) {
+        // The stream reads the rest of its request as it likes
+        if (it->second.socket)
+            it->second.socket->detach();
+    } else {
+        writeFrame(RstStreamFrame, 0, it->first, "\0\0\0\0", 4);
+        if (it->second.socket)
+            it->second.socket->resetByPeer();
+    }
+    return streams.erase(it);
+}
+
+void QHttpServerHttp2Connection::updatePhase()
+{
+    if (closed)
+        return;
+    if (!streams.empty()) {
+        if (idle)
+            connection->setPhase(QHttpServerConnection::Phase::Handling, 0);
+        idle = false;
+        return;
+    }
+    if (goingAway) {
+        closed = true;
+        socket->disconnectFromHost();
+        return;
+    }
+    if (!idle)
+        connection->setPhase(QHttpServerConnection::Phase::Idle,
+                             connection->worker->configuration.keepAliveTimeout());
+    idle = true;
+}
+
+void QHttpServerHttp2Connection::writeFrame(uchar type, uchar flags, quint32 streamId,
+                                            const char *payload, int size)
+{
+    char header[frameHeaderSize];
+    header[0] = char(size >> 16);
+    header[1] = char(size >> 8);
+    header[2] = char(size);
+    header[3] = char(type);
+    header[4] = char(flags);
+    qToBigEndian<quint32>(streamId, header + 5);
+    socket->write(header, frameHeaderSize);
+    if (size)
+        socket->write(payload, size);
+}
+
+void QHttpServerHttp2Connection::writeHeaderBlock(quint32 streamId, const QByteArray &block,
+                                                  bool endStream)
+{
+    int offset = 0;
+    uchar type = HeadersFrame;
+    uchar flags = endStream ? EndStreamFlag : 0;
+    do {
+        const int size = qMin(block.size() - offset, int(maxFrameSize));
+        if (offset + size == block.size())
+            flags |= EndHeadersFlag;
+        writeFrame(type, flags, streamId, block.constData() + offset, size);
+        offset += size;
+        type = ContinuationFrame;
+        flags = 0;
+    } while (offset < block.size());
+}
+
+void QHttpServerHttp2Connection::writeWindowUpdate(quint32 streamId, quint32 increment)
+{
+    char payload[4];
+    qToBigEndian<quint32>(increment, payload);
+    writeFrame(WindowUpdateFrame, 0, streamId, payload, 4);
+}
+
+void QHttpServerHttp2Connection::writeGoAway(quint32 error)
+{
+    char payload[8];
+    qToBigEndian<quint32>(lastStreamId, payload);
+    qToBigEndian<quint32>(error, payload + 4);
+    writeFrame(GoAwayFrame, 0, 0, payload, 8);
+}
+
+void QHttpServerHttp2Connection::resetStream(quint32 streamId, quint32 error)
+{
+    char payload[4];
+    qToBigEndian<quint32>(error, payload);
+    writeFrame(RstStreamFrame, 0, streamId, payload, 4);
+    const auto it = streams.find(streamId);
+    if (it == streams.end())
+        return;
+    if (it->second.socket)
+        it->second.socket->resetByPeer();
+    streams.erase(it);
+    updatePhase();
+}
+
+void QHttpServerHttp2Connection::connectionError(quint32 error)
+{
+    if (closed)
+        return;
+    qCDebug(lcHttp2, "Connection error %u", error);
+    writeGoAway(error);
+    closed = true;
+    socket->disconnectFromHost();
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,213 @@
+/****************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtHttpServer module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QHTTPSERVERHTTP2CONNECTION_P_H
+#define QHTTPSERVERHTTP2CONNECTION_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists for the convenience
+// of QHttpServer. This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+
+#include <QtHttpServer/qthttpserverglobal.h>
+#include <private/qhttpserverhpack_p.h>
+#include <private/qhttpserverrequest_p.h>
+
+#include <QtCore/qbytearray.h>
+#include <QtCore/qobject.h>
+#include <QtCore/qpointer.h>
+#include <QtNetwork/qhostaddress.h>
+#include <QtNetwork/qtcpsocket.h>
+
+#include <map>
+
+QT_BEGIN_NAMESPACE
+
+class QHttpServerConnection;
+class QHttpServerHttp2Connection;
+
+class QHttpServerHttp2Stream : public QTcpSocket
+{
+    Q_OBJECT
+
+public:
+    using ConnectionState = std::shared_ptr<QHttpServerRequestPrivate::ConnectionState>;
+
+    QHttpServerHttp2Stream(QHttpServerHttp2Connection *connection, quint32 id,
+                           const QHostAddress &peerAddress, quint16 peerPort,
+                           const ConnectionState &connectionState, bool headRequest);
+    ~QHttpServerHttp2Stream() override;
+
+    // Of the connection carrying the stream, for the request of the stream
+    const ConnectionState &connectionState() const { return state; }
+
+    qint64 bytesAvailable() const override;
+    qint64 bytesToWrite() const override;
+    void disconnectFromHost() override;
+
+    void appendRequest(const QByteArray &data);
+    void detach();
+    void resetByPeer();
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 size) override;
+
+private:
+    void writeResponseHead();
+
+    QPointer<QHttpServerHttp2Connection> connection;
+    const quint32 id;
+    const ConnectionState state;
+    const bool headRequest;
+    // The request as HTTP/1.1, read by the QHttpServerConnection of the stream
+    QByteArray request;
+    int requestOffset = 0;
+    bool readyReadPending = false;
+    // The response as HTTP/1.1, up to the end of its head
+    QByteArray responseHead;
+    bool headSent = false;
+    bool ended = false;
+    qint64 remainingBody = -1;
+};
+
+class QHttpServerHttp2Connection : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit QHttpServerHttp2Connection(QHttpServerConnection *connection);
+    ~QHttpServerHttp2Connection() override;
+
+    static QByteArray upgradedRequest(const QByteArray &message);
+
+    void start(const QByteArray &received, const QByteArray &upgradeRequest,
+               const QByteArray &upgradeSettings);
+    void drain();
+    void close();
+
+    // Called by the streams
+    void sendHeaders(quint32 streamId, const QHttpServerHpack::HeaderList &headers,
+                     bool endStream);
+    void sendData(quint32 streamId, const char *data, qint64 size, bool endStream);
+    void finishStream(quint32 streamId);
+    void consumed(quint32 streamId, qint64 size);
+    qint64 pendingBytes(quint32 streamId) const;
+
+private:
+    struct Stream
+    {
+        QPointer<QHttpServerHttp2Stream> socket;
+        // DATA waiting for the flow control windows
+        QByteArray output;
+        int outputOffset = 0;
+        qint64 sendWindow = 0;
+        qint64 receiveWindow = 0;
+        // Request bytes read by the stream, not yet given back to the client
+        qint64 unacknowledged = 0;
+        // Request bytes received, not yet read by the stream
+        qint64 buffered = 0;
+        bool chunked = false;
+        bool remoteClosed = false;
+        // The final response head, not an informational one
+        bool headersSent = false;
+        bool endQueued = false;
+    };
+    using Streams = std::map<quint32, Stream>;
+
+    void handleReadyRead();
+    void processFrames();
+    void handleFrame(uchar type, uchar flags, quint32 streamId, const uchar *payload,
+                     quint32 length);
+    void handleData(uchar flags, quint32 streamId, const uchar *payload, quint32 length);
+    void handleHeaders(uchar flags, quint32 streamId, const uchar *payload, quint32 length);
+    void handleHeaderBlock(quint32 streamId);
+    void handleSettings(uchar flags, quint32 streamId, const uchar *payload, quint32 length);
+    void handleWindowUpdate(quint32 streamId, const uchar *payload, quint32 length);
+    quint32 applySettings(const uchar *payload, quint32 length);
+
+    QByteArray requestHead(const QHttpServerHpack::HeaderList &headers, bool endStream,
+                           bool *chunked, bool *headRequest) const;
+    void startStream(quint32 streamId, const QByteArray &request, bool headRequest);
+    void endRequest(Stream &stream);
+    void creditStream(quint32 streamId, Stream &stream, qint64 size);
+    void flush();
+    Streams::iterator streamSent(Streams::iterator it);
+    void updatePhase();
+
+    void writeFrame(uchar type, uchar flags, quint32 streamId, const char *payload = nullptr,
+                    int size = 0);
+    void writeHeaderBlock(quint32 streamId, const QByteArray &block, bool endStream);
+    void writeWindowUpdate(quint32 streamId, quint32 increment);
+    void writeGoAway(quint32 error);
+    void resetStream(quint32 streamId, quint32 error);
+    void connectionError(quint32 error);
+
+    QHttpServerConnection *const connection;
+    QTcpSocket *const socket;
+    QHostAddress peerAddress;
+    quint16 peerPort = 0;
+    QHttpServerHttp2Stream::ConnectionState connectionState;
+    QHttpServerHpack::Decoder decoder;
+    int maxConcurrentStreams = 0;
+    int maxHeaderListSize = 0;
+
+    QByteArray input;
+    int inputOffset = 0;
+    bool expectsPreface = true;
+    bool settingsReceived = false;
+    bool goingAway = false;
+    bool closed = false;
+    bool idle = false;
+    quint32 lastStreamId = 0;
+
+    // Settings of the client
+    quint32 maxFrameSize = 0;
+    qint64 initialWindowSize = 0;
+
+    qint64 sendWindow = 0;
+    qint64 receiveWindow = 0;
+    qint64 unacknowledged = 0;
+
+    // A header block continued in CONTINUATION frames
+    quint32 headerBlockStream = 0;
+    uchar headerBlockFlags = 0;
+    QByteArray headerBlock;
+
+    Streams streams;
+};
+
+QT_END_NAMESPACE
+
+#endif // QHTTPSERVERHTTP2CONNECTION_P_H
@@ -0,0 +1,303 @@
+/****************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtHttpServer module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtHttpServer/qhttpserverlisteneroptions.h>
+
+QT_BEGIN_NAMESPACE
+
+class QHttpServerListenerOptionsPrivate : public QSharedData
+{
+public:
+    int backlog = 0;
+    int deferAcceptTimeout = 0;
+    int fastOpenQueueLength = 0;
+    int receiveBufferSize = 0;
+    int sendBufferSize = 0;
+    bool noDelay = false;
+    bool corkResponses = false;
+    bool proxyProtocol = false;
+};
+
+/*!
+    \class QHttpServerListenerOptions
+    \brief The QHttpServerListenerOptions class holds the socket options of
+    one listener of a QAbstractHttpServer.
+
+    QHttpServerListenerOptions is a value class. Fill it in and pass it to
+    QAbstractHttpServer::listen() or QAbstractHttpServer::bind(). Some
+    options apply to the listening socket, the others to every
+    connection it accepts.
+
+    \code
+
+    QHttpServerListenerOptions options;
+    options.setNoDelay(true);
+    options.setDeferAcceptTimeout(5);
+    options.setBacklog(1024);
+
+    QHttpServer server;
+    server.listen(QHostAddress::Any, 8080, options);
+
+    \endcode
+
+    Options the platform does not provide are ignored with a warning.
+    Every option defaults to what the operating system and Qt do without
+    it.
+
+    \sa QAbstractHttpServer::listen()
+*/
+
+/*!
+    Constructs default options, which leave the sockets untouched.
+*/
+QHttpServerListenerOptions::QHttpServerListenerOptions()
+    : d(new QHttpServerListenerOptionsPrivate)
+{
+}
+
+/*!
+    Constructs a copy of \a other.
+*/
+QHttpServerListenerOptions::QHttpServerListenerOptions(
+        const QHttpServerListenerOptions &other) = default;
+
+/*!
+    Assigns \a other to these options.
+*/
+QHttpServerListenerOptions &QHttpServerListenerOptions::operator=(
+        const QHttpServerListenerOptions &other) = default;
+
+/*!
+    Destroys the options.
+*/
+QHttpServerListenerOptions::~QHttpServerListenerOptions() = default;
+
+/*!
+    Returns the length of the queue of connections waiting to be
+    accepted.
+
+    \sa setBacklog()
+*/
+int QHttpServerListenerOptions::backlog() const
+{
+    return d->backlog;
+}
+
+/*!
+    Sets the length of the queue of connections the kernel completes
+    while the server is busy to \a size. Longer queues absorb bursts of
+    new connections instead of dropping them. The kernel caps it, on
+    Linux to \c net.core.somaxconn.
+
+    Zero (the default) keeps the backlog of QTcpServer.
+*/
+void QHttpServerListenerOptions::setBacklog(int size)
+{
+    d->backlog = qMax(0, size);
+}
+
+/*!
+    Returns how many seconds the kernel holds back connections that have
+    not sent any data yet.
+
+    \sa setDeferAcceptTimeout()
+*/
+int QHttpServerListenerOptions::deferAcceptTimeout() const
+{
+    return d->deferAcceptTimeout;
+}
+
+/*!
+    Makes the kernel hand over connections only once their first data
+    arrives, or after \a seconds, with \c TCP_DEFER_ACCEPT. The server
+    then never wakes up for a connection that has nothing to read yet,
+    and the request usually comes with the connection.
+
+    Zero (the default) disables the option. It is only available on
+    Linux.
+*/
+void QHttpServerListenerOptions::setDeferAcceptTimeout(int seconds)
+{
+    d->deferAcceptTimeout = qMax(0, seconds);
+}
+
+/*!
+    Returns the length of the TCP Fast Open queue.
+
+    \sa setFastOpenQueueLength()
+*/
+int QHttpServerListenerOptions::fastOpenQueueLength() const
+{
+    return d->fastOpenQueueLength;
+}
+
+/*!
+    Enables TCP Fast Open, with at most \a length connections waiting
+    for their handshake to complete. Returning clients then send their
+    request with the \c SYN, saving a round trip.
+
+    Zero (the default) disables the option. It is available where the
+    platform provides \c TCP_FASTOPEN, and on Linux it also needs the
+    server side bit of \c net.ipv4.tcp_fastopen.
+*/
+void QHttpServerListenerOptions::setFastOpenQueueLength(int length)
+{
+    d->fastOpenQueueLength = qMax(0, length);
+}
+
+/*!
+    Returns the size of the kernel receive buffer of the sockets.
+
+    \sa setReceiveBufferSize()
+*/
+int QHttpServerListenerOptions::receiveBufferSize() const
+{
+    return d->receiveBufferSize;
+}
+
+/*!
+    Sets the size of the kernel receive buffer of the listening socket
+    and of every accepted socket to \a size bytes, with \c SO_RCVBUF.
+
+    Zero (the default) keeps the size picked by the kernel, which tunes
+    it automatically on Linux.
+*/
+void QHttpServerListenerOptions::setReceiveBufferSize(int size)
+{
+    d->receiveBufferSize = qMax(0, size);
+}
+
+/*!
+    Returns the size of the kernel send buffer of the sockets.
+
+    \sa setSendBufferSize()
+*/
+int QHttpServerListenerOptions::sendBufferSize() const
+{
+    return d->sendBufferSize;
+}
+
+/*!
+    Sets the size of the kernel send buffer of the listening socket and
+    of every accepted socket to \a size bytes, with \c SO_SNDBUF.
+
+    Zero (the default) keeps the size picked by the kernel.
+*/
+void QHttpServerListenerOptions::setSendBufferSize(int size)
+{
+    d->sendBufferSize = qMax(0, size);
+}
+
+/*!
+    Returns \c true if Nagle's algorithm is disabled on the accepted
+    sockets.
+
+    \sa setNoDelay()
+*/
+bool QHttpServerListenerOptions::noDelay() const
+{
+    return d->noDelay;
+}
+
+/*!
+    Disables Nagle's algorithm on every accepted socket if \a enabled is
+    \c true, with \c TCP_NODELAY, so that the last segment of a response
+    leaves without waiting for the acknowledgement of the previous one.
+
+    QHttpServerResponder writes the headers of a response together with
+    small bodies, so this does not fragment them. The default is
+    \c false.
+
+    \sa setCorkResponses()
+*/
+void QHttpServerListenerOptions::setNoDelay(bool enabled)
+{
+    d->noDelay = enabled;
+}
+
+/*!
+    Returns \c true if the responses streamed from a device are corked.
+
+    \sa setCorkResponses()
+*/
+bool QHttpServerListenerOptions::corkResponses() const
+{
+    return d->corkResponses;
+}
+
+/*!
+    Corks the socket, with \c TCP_CORK on Linux or \c TCP_NOPUSH on the
+    BSDs, while a body is sent from a QIODevice or a file if \a enabled
+    is \c true. The headers then share their segment with the start of
+    the body, and only full segments leave until the body is complete.
+
+    This mostly matters together with setNoDelay(). The default is
+    \c false.
+*/
+void QHttpServerListenerOptions::setCorkResponses(bool enabled)
+{
+    d->corkResponses = enabled;
+}
+
+/*!
+    Returns \c true if the accepted connections start with a PROXY
+    protocol header.
+
+    \sa setProxyProtocol()
+*/
+bool QHttpServerListenerOptions::proxyProtocol() const
+{
+    return d->proxyProtocol;
+}
+
+/*!
+    Expects every accepted connection to start with a header of the PROXY
+    protocol, version 1 or 2, if \a enabled is \c true. Load balancers
+    working at the TCP level send it to pass on the address of their
+    client.
+
+    The header is read before the first request, along with it.
+    QHttpServerRequest::remoteAddress() and
+    QHttpServerRequest::remotePort() then return the address of the
+    client instead of the one of the balancer, and
+    QHttpServerRequest::proxyProtocolTlv() the additional fields of a
+    version 2 header. Connections without a valid header are closed.
+
+    Only enable this for listeners reachable by the balancers alone, any
+    peer could claim any address otherwise. The limits per address of
+    QHttpServerConfiguration still count the balancers. The header has to
+    come before the TLS handshake, so this does not work with TLS
+    listeners. The default is \c false.
+*/
+void QHttpServerListenerOptions::setProxyProtocol(bool enabled)
+{
+    d->proxyProtocol = enabled;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,85 @@
+/****************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtHttpServer module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QHTTPSERVERLISTENEROPTIONS_H
+#define QHTTPSERVERLISTENEROPTIONS_H
+
+#include <QtHttpServer/qthttpserverglobal.h>
+
+#include <QtCore/qshareddata.h>
+
+QT_BEGIN_NAMESPACE
+
+class QHttpServerListenerOptionsPrivate;
+class Q_HTTPSERVER_EXPORT QHttpServerListenerOptions
+{
+public:
+    QHttpServerListenerOptions();
+    QHttpServerListenerOptions(const QHttpServerListenerOptions &other);
+    QHttpServerListenerOptions(QHttpServerListenerOptions &&other) noexcept = default;
+    QHttpServerListenerOptions &operator=(const QHttpServerListenerOptions &other);
+    QHttpServerListenerOptions &operator=(QHttpServerListenerOptions &&other) noexcept
+    { swap(other); return *this; }
+    ~QHttpServerListenerOptions();
+
+    void swap(QHttpServerListenerOptions &other) noexcept { d.swap(other.d); }
+
+    int backlog() const;
+    void setBacklog(int size);
+
+    int deferAcceptTimeout() const;
+    void setDeferAcceptTimeout(int seconds);
+
+    int fastOpenQueueLength() const;
+    void setFastOpenQueueLength(int length);
+
+    int receiveBufferSize() const;
+    void setReceiveBufferSize(int size);
+
+    int sendBufferSize() const;
+    void setSendBufferSize(int size);
+
+    bool noDelay() const;
+    void setNoDelay(bool enabled);
+
+    bool corkResponses() const;
+    void setCorkResponses(bool enabled);
+
+    bool proxyProtocol() const;
+    void setProxyProtocol(bool enabled);
+
+private:
+    QSharedDataPointer<QHttpServerListenerOptionsPrivate> d;
+};
+
+Q_DECLARE_SHARED(QHttpServerListenerOptions)
+
+QT_END_NAMESPACE
+
+#endif // QHTTPSERVERLISTENEROPTIONS_H
@@ -32,6 +32,8 @@
 #include <QtHttpServer/qhttpserverrequest.h>
 
 #include <QtCore/qdebug.h>
+#include <QtCore/qdir.h>
+#include <QtCore/qendian.h>
 #include <QtCore/qloggingcategory.h>
 #include <QtNetwork/qtcpsocket.h>
 #if QT_CONFIG(ssl)
@@ -39,6 +41,8 @@
 #endif
 
 #include <array>
+#include <climits>
+#include <cstring>
 
 Q_LOGGING_CATEGORY(lc, "qt.httpserver.request")
 
@@ -104,25 +108,258 @@ QByteArray QHttpServerRequestPrivate::header(const QByteArray &key) const
 
 bool QHttpServerRequestPrivate::parse(QIODevice *socket)
 {
-    const auto fragment = socket->readAll();
-    if (fragment.size()) {
+    // onMessageComplete() pauses the parser, the next message of a
+    // pipeline is parsed only once the current one has been handled.
+    http_parser_pause(&httpParser, 0);
+    while (expectsProxyHeader) {
+        switch (parseProxyHeader()) {
+        case ProxyHeader::Incomplete:
+            if (!readChunk(socket))
+                return true;
+            break;
+        case ProxyHeader::Invalid:
+            qCDebug(lc, "Invalid PROXY protocol header");
+            errorStatus = QHttpServerResponder::StatusCode::BadRequest;
+            return false;
+        case ProxyHeader::Complete:
+            expectsProxyHeader = false;
+            break;
+        }
+    }
+
+    // HTTP/2 with prior knowledge, see QHttpServerConfiguration::setHttp2Enabled()
+    static const char preface[] = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+    while (acceptsHttp2Preface) {
+        const int size = qMin(buffer.size() - bufferOffset, int(sizeof(preface) - 1));
+        if (std::memcmp(buffer.constData() + bufferOffset, preface, size_t(size)) != 0) {
+            acceptsHttp2Preface = false;
+        } else if (size == int(sizeof(preface) - 1)) {
+            acceptsHttp2Preface = false;
+            http2Preface = true;
+            return true;
+        } else if (!readChunk(socket)) {
+            return true;
+        }
+    }
+
+    for (;;) {
+        if (!hasPendingData() && !readChunk(socket))
+            return true;
+
+        if (state == State::NotStarted || state == State::OnMessageComplete) {
+            messageOffset = bufferOffset;
 #if QT_CONFIG(ssl)
-        auto sslSocket = qobject_cast<QSslSocket *>(socket);
-        url.setScheme(sslSocket && sslSocket->isEncrypted() ? QStringLiteral("https")
-                                                            : QStringLiteral("http"));
+            auto sslSocket = qobject_cast<QSslSocket *>(socket);
+            url.setScheme(sslSocket && sslSocket->isEncrypted() ? QStringLiteral("https")
+                                                                : QStringLiteral("http"));
 #else
-        url.setScheme(QStringLiteral("http"));
+            url.setScheme(QStringLiteral("http"));
 #endif
+        }
+
+        const int size = buffer.size() - bufferOffset;
         const auto parsed = http_parser_execute(&httpParser,
                                                 &httpParserSettings,
-                                                fragment.constData(),
-                                                size_t(fragment.size()));
-        if (int(parsed) < fragment.size()) {
+                                                buffer.constData() + bufferOffset,
+                                                size_t(size));
+        bufferOffset += int(parsed);
+        if (HTTP_PARSER_ERRNO(&httpParser) == HPE_PAUSED)
+            return true;
+        if (int(parsed) < size || HTTP_PARSER_ERRNO(&httpParser) != HPE_OK) {
             qCDebug(lc, "Parse error: %d", httpParser.http_errno);
+            if (HTTP_PARSER_ERRNO(&httpParser) == HPE_HEADER_OVERFLOW)
+                errorStatus = QHttpServerResponder::StatusCode::RequestHeaderFieldsTooLarge;
             return false;
         }
     }
-    return true;
+}
+
+/*!
+    \internal
+
+    Parses the PROXY protocol header at the start of the read buffer, of
+    either version, and skips it once it is complete. The address of the
+    client it carries replaces the one of the socket.
+*/
+QHttpServerRequestPrivate::ProxyHeader QHttpServerRequestPrivate::parseProxyHeader()
+{
+    const char *data = buffer.constData() + bufferOffset;
+    const int size = buffer.size() - bufferOffset;
+    if (!size)
+        return ProxyHeader::Incomplete;
+    // The signature of version 2 starts with "\r", the one of version 1 with "P"
+    if (data[0] == '\r')
+        return parseProxyHeaderV2(reinterpret_cast<const uchar *>(data), size);
+    return parseProxyHeaderV1(data, size);
+}
+
+QHttpServerRequestPrivate::ProxyHeader QHttpServerRequestPrivate::parseProxyHeaderV1(
+        const char *data, int size)
+{
+    // "PROXY TCP4 192.0.2.1 192.0.2.2 56324 443\r\n", 107 bytes at most
+    static const char signature[] = "PROXY ";
+    static constexpr int maxHeaderSize = 107;
+    if (std::memcmp(data, signature, size_t(qMin(size, int(sizeof(signature)) - 1))) != 0)
+        return ProxyHeader::Invalid;
+
+    const auto end = static_cast<const char *>(std::memchr(data, '\n',
+                                                           size_t(qMin(size, maxHeaderSize))));
+    if (!end)
+        return size < maxHeaderSize ? ProxyHeader::Incomplete : ProxyHeader::Invalid;
+    if (end - data < 2 || end[-1] != '\r')
+        return ProxyHeader::Invalid;
+
+    const auto fields = QByteArray::fromRawData(data, int(end - data) - 1).split(' ');
+    bufferOffset += int(end - data) + 1;
+    // Sent for connections the balancer could not make sense of
+    if (fields.size() >= 2 && fields.at(1) == "UNKNOWN")
+        return ProxyHeader::Complete;
+    if (fields.size() != 6)
+        return ProxyHeader::Invalid;
+
+    const auto protocol = fields.at(1) == "TCP4" ? QAbstractSocket::IPv4Protocol
+                        : fields.at(1) == "TCP6" ? QAbstractSocket::IPv6Protocol
+                                                 : QAbstractSocket::UnknownNetworkLayerProtocol;
+    QHostAddress address;
+    bool ok = false;
+    const uint port = fields.at(4).toUInt(&ok);
+    if (!address.setAddress(QString::fromLatin1(fields.at(2))) || address.protocol() != protocol
+            || !ok || port > 0xffff) {
+        return ProxyHeader::Invalid;
+    }
+
+    remoteAddress = address;
+    remotePort = quint16(port);
+    return ProxyHeader::Complete;
+}
+
+QHttpServerRequestPrivate::ProxyHeader QHttpServerRequestPrivate::parseProxyHeaderV2(
+        const uchar *data, int size)
+{
+    // Signature, version and command, family and protocol, length of the rest
+    static const uchar signature[] = {
+        0x0d, 0x0a, 0x0d, 0x0a, 0x00, 0x0d, 0x0a, 0x51, 0x55, 0x49, 0x54, 0x0a
+    };
+    static constexpr int fixedSize = 16;
+    if (std::memcmp(data, signature, size_t(qMin(size, int(sizeof(signature))))) != 0)
+        return ProxyHeader::Invalid;
+    if (size < fixedSize)
+        return ProxyHeader::Incomplete;
+    if ((data[12] & 0xf0) != 0x20)
+        return ProxyHeader::Invalid;
+    const int length = qFromBigEndian<quint16>(data + 14);
+    if (size < fixedSize + length)
+        return ProxyHeader::Incomplete;
+    bufferOffset += fixedSize + length;
+
+    switch (data[12] & 0x0f) {
+    case 0x0: // LOCAL, the balancer checks the health of the server itself
+        return ProxyHeader::Complete;
+    case 0x1: // PROXY
+        break;
+    default:
+        return ProxyHeader::Invalid;
+    }
+    // Only STREAM connections carry HTTP, UNSPEC comes with AF_UNSPEC
+    if ((data[13] & 0x0f) != 0x1 && data[13] != 0x00)
+        return ProxyHeader::Invalid;
+
+    const uchar *addresses = data + fixedSize;
+    int addressesSize = 0;
+    switch (data[13] >> 4) {
+    case 0x1: // AF_INET
+        addressesSize = 12;
+        if (length < addressesSize)
+            return ProxyHeader::Invalid;
+        remoteAddress.setAddress(qFromBigEndian<quint32>(addresses));
+        remotePort = qFromBigEndian<quint16>(addresses + 8);
+        break;
+    case 0x2: // AF_INET6
+        addressesSize = 36;
+        if (length < addressesSize)
+            return ProxyHeader::Invalid;
+        remoteAddress.setAddress(addresses);
+        remotePort = qFromBigEndian<quint16>(addresses + 32);
+        break;
+    case 0x3: // AF_UNIX, no address to tell
+        addressesSize = 216;
+        if (length < addressesSize)
+            return ProxyHeader::Invalid;
+        remoteAddress.clear();
+        remotePort = 0;
+        break;
+    default: // AF_UNSPEC, the address of the socket stays
+        break;
+    }
+
+    if (length > addressesSize) {
+        sharedConnectionState()->proxyTlvs = QByteArray(
+                reinterpret_cast<const char *>(addresses) + addressesSize, length - addressesSize);
+    }
+    return ProxyHeader::Complete;
+}
+
+/*!
+    \internal
+
+    Reads the next chunk of \a socket into the spare room of the read
+    buffer, which is only reallocated to hold a message with large
+    headers. Returns \c false if there was nothing to read.
+*/
+bool QHttpServerRequestPrivate::readChunk(QIODevice *socket)
+{
+    const qint64 available = socket->bytesAvailable();
+    if (available <= 0)
+        return false;
+
+    const bool inHeaders = state == State::OnMessageBegin || state == State::OnUrl
+            || state == State::OnStatus || state == State::OnHeaders;
+    const int keep = inHeaders ? messageOffset : bufferOffset;
+    if (keep == buffer.size()) {
+        buffer.resize(0);
+    } else if (keep) {
+        std::memmove(buffer.data(), buffer.constData() + keep, size_t(buffer.size() - keep));
+        buffer.resize(buffer.size() - keep);
+    }
+    bufferOffset -= keep;
+    messageOffset = inHeaders ? 0 : bufferOffset;
+
+    const int size = buffer.size();
+    const int chunk = int(qMin(available, qint64(readChunkSize)));
+    if (buffer.capacity() < size + chunk)
+        buffer.reserve(qMax(size + chunk, readChunkSize));
+    buffer.resize(size + chunk);
+    const qint64 read = socket->read(buffer.data() + size, chunk);
+    buffer.resize(size + int(qMax(read, qint64(0))));
+    return read > 0;
+}
+
+/*!
+    \internal
+
+    Gives the current message, and whatever follows it, back to
+    \a socket, so that the handler of an upgrade reads the request
+    itself.
+*/
+void QHttpServerRequestPrivate::unreadMessage(QIODevice *socket)
+{
+    for (int i = buffer.size() - 1; i >= messageOffset; --i)
+        socket->ungetChar(buffer.at(i));
+    buffer.resize(0);
+    bufferOffset = messageOffset = 0;
+}
+
+/*!
+    \internal
+
+    Returns what was read from the socket but not parsed, and forgets it.
+*/
+QByteArray QHttpServerRequestPrivate::takeUnparsed()
+{
+    const QByteArray unparsed = buffer.mid(bufferOffset);
+    buffer.resize(0);
+    bufferOffset = messageOffset = 0;
+    return unparsed;
 }
 
 uint QHttpServerRequestPrivate::headerHash(const QByteArray &key) const
@@ -136,6 +373,79 @@ void QHttpServerRequestPrivate::clear()
     lastHeader.clear();
     headers.clear();
     body.clear();
+    bodyDevice.reset();
+    bodyFile.reset();
+    bodyBuffer.reset();
+    headersHandled = false;
+    routeMaxBodySize = 0;
+    urlLength = 0;
+    headerCount = 0;
+    headerSize = 0;
+    bodySize = 0;
+    parsingHeaderValue = false;
+    expectsContinue = false;
+    admission = QHttpServerResponder::StatusCode::Continue;
+    errorStatus = QHttpServerResponder::StatusCode::BadRequest;
+}
+
+void QHttpServerRequestPrivate::sendContinue(QIODevice *socket)
+{
+    if (!expectsContinue)
+        return;
+    expectsContinue = false;
+    static const char continueResponse[] = "HTTP/1.1 100 Continue\r\n\r\n";
+    socket->write(continueResponse, sizeof(continueResponse) - 1);
+}
+
+bool QHttpServerRequestPrivate::exceedsBodyLimit(qint64 size) const
+{
+    return (maxBodySize && size > maxBodySize) || (routeMaxBodySize && size > routeMaxBodySize);
+}
+
+bool QHttpServerRequestPrivate::exceedsBodyLimit() const
+{
+    // Chunked bodies announce no length, they are checked as they arrive
+    return !(httpParser.flags & F_CHUNKED) && httpParser.content_length != ULLONG_MAX
+            && exceedsBodyLimit(qint64(httpParser.content_length));
+}
+
+QHttpServerRequestPrivate::ConnectionState::~ConnectionState()
+{
+    // Destroyed latest first, a context may rely on one created before it
+    while (!contexts.empty())
+        contexts.pop_back();
+}
+
+/*!
+    \internal
+
+    Returns the state of the connection of this request, creating it if
+    need be.
+*/
+const std::shared_ptr<QHttpServerRequestPrivate::ConnectionState> &
+QHttpServerRequestPrivate::sharedConnectionState()
+{
+    if (!connectionState)
+        connectionState = std::make_shared<ConnectionState>();
+    return connectionState;
+}
+
+void QHttpServerRequestPrivate::reset(const QHostAddress &address, quint16 port)
+{
+    clear();
+    buffer.resize(0); // Keeps the capacity for the next connection
+    bufferOffset = 0;
+    messageOffset = 0;
+    // The streams of an HTTP/2 connection might still hold on to its state
+    connectionState.reset();
+    remoteAddress = address;
+    remotePort = port;
+    expectsProxyHeader = false;
+    acceptsHttp2Preface = false;
+    http2Preface = false;
+    state = State::NotStarted;
+    handling = false;
+    http_parser_init(&httpParser, HTTP_REQUEST);
 }
 
 bool QHttpServerRequestPrivate::parseUrl(const char *at, size_t length, bool connect, QUrl *url)
@@ -171,6 +481,11 @@ int QHttpServerRequestPrivate::onUrl(http_parser *httpParser, const char *at, si
     qCDebug(lc) << httpParser << QString::fromUtf8(at, int(length));
     auto instance = static_cast<QHttpServerRequestPrivate *>(httpParser->data);
     instance->state = State::OnUrl;
+    instance->urlLength += int(length);
+    if (instance->maxUrlLength && instance->urlLength > instance->maxUrlLength) {
+        instance->errorStatus = QHttpServerResponder::StatusCode::UriTooLong;
+        return 1;
+    }
     parseUrl(at, length, false, &instance->url);
     return 0;
 }
@@ -187,6 +502,11 @@ int QHttpServerRequestPrivate::onHeaderField(http_parser *httpParser, const char
     qCDebug(lc) << httpParser << QString::fromUtf8(at, int(length));
     auto i = instance(httpParser);
     i->state = State::OnHeaders;
+    if (!i->parsingHeaderValue) // Only the first piece of a name starts a new field
+        ++i->headerCount;
+    i->parsingHeaderValue = false;
+    if (!i->checkHeaderLimits(length))
+        return 1;
     const auto key = QByteArray(at, int(length));
     i->headers.insert(i->headerHash(key), qMakePair(key, QByteArray()));
     i->lastHeader = key;
@@ -198,6 +518,9 @@ int QHttpServerRequestPrivate::onHeaderValue(http_parser *httpParser, const char
     qCDebug(lc) << httpParser << QString::fromUtf8(at, int(length));
     auto i = instance(httpParser);
     i->state = State::OnHeaders;
+    i->parsingHeaderValue = true;
+    if (!i->checkHeaderLimits(length))
+        return 1;
     Q_ASSERT(!i->lastHeader.isEmpty());
     const auto value = QByteArray(at, int(length));
     i->headers[i->headerHash(i->lastHeader)] = qMakePair(i->lastHeader, value);
@@ -212,7 +535,28 @@ int QHttpServerRequestPrivate::onHeaderValue(http_parser *httpParser, const char
 int QHttpServerRequestPrivate::onHeadersComplete(http_parser *httpParser)
 {
     qCDebug(lc) << httpParser;
-    instance(httpParser)->state = State::OnHeadersComplete;
+    auto i = instance(httpParser);
+    i->state = State::OnHeadersComplete;
+    const auto expect = i->header(QByteArrayLiteral("expect"));
+    if (!expect.isEmpty()) {
+        if (expect.compare(QByteArrayLiteral("100-continue"), Qt::CaseInsensitive) != 0) {
+            i->errorStatus = QHttpServerResponder::StatusCode::ExpectationFailed;
+            return -1;
+        }
+        // HTTP/1.0 clients do not wait for the interim response
+        i->expectsContinue = httpParser->http_major > 1
+                || (httpParser->http_major == 1 && httpParser->http_minor >= 1);
+    }
+    if (i->exceedsBodyLimit()) {
+        i->errorStatus = QHttpServerResponder::StatusCode::PayloadTooLarge;
+        return -1;
+    }
+    // Give the server a chance to stream the body, before any of it is parsed.
+    // This includes h2c upgrades, which are served as HTTP/1.1 with a body.
+    if ((httpParser->flags & F_CHUNKED)
+            || (httpParser->content_length > 0 && httpParser->content_length != ULLONG_MAX)) {
+        http_parser_pause(httpParser, 1);
+    }
     return 0;
 }
 
@@ -221,20 +565,76 @@ int QHttpServerRequestPrivate::onBody(http_parser *httpParser, const char *at, s
     qCDebug(lc) << httpParser << QString::fromUtf8(at, int(length));
     auto i = instance(httpParser);
     i->state = State::OnBody;
-    if (i->body.isEmpty()) {
-        i->body.reserve(
-                static_cast<int>(httpParser->content_length) +
-                static_cast<int>(length));
+    i->bodySize += qint64(length);
+    if (i->exceedsBodyLimit(i->bodySize)) {
+        i->errorStatus = QHttpServerResponder::StatusCode::PayloadTooLarge;
+        return 1;
+    }
+    if (i->bodyDevice) {
+        i->bodyDevice->append(at, qint64(length));
+        return 0;
     }
 
-    i->body.append(at, int(length));
-    return 0;
+    return i->appendBody(httpParser, at, qint64(length)) ? 0 : 1;
+}
+
+bool QHttpServerRequestPrivate::appendBody(const http_parser *httpParser,
+                                           const char *at, qint64 length)
+{
+    if (!bodyFile && bodyMemoryThreshold && body.size() + length > bodyMemoryThreshold) {
+        bodyFile.reset(new QTemporaryFile(QDir::tempPath()
+                                          + QLatin1String("/qthttpserver-body-XXXXXX")));
+        if (!bodyFile->open() || bodyFile->write(body) != body.size()) {
+            qCWarning(lc, "Cannot buffer the request body to disk: %s",
+                      qPrintable(bodyFile->errorString()));
+            bodyFile.reset();
+            return false;
+        }
+        body = QByteArray();
+    }
+
+    if (bodyFile) {
+        if (bodyFile->write(at, length) != length) {
+            qCWarning(lc, "Cannot buffer the request body to disk: %s",
+                      qPrintable(bodyFile->errorString()));
+            return false;
+        }
+        return true;
+    }
+
+    // Only trust the announced length up to a point, chunked bodies have
+    // none. Past it, the body grows as QByteArray sees fit.
+    if (body.isEmpty() && !(httpParser->flags & F_CHUNKED)) {
+        const qint64 cap = bodyMemoryThreshold ? bodyMemoryThreshold : maxBodyReservation;
+        const qint64 expected = qint64(httpParser->content_length) + length;
+        body.reserve(int(qMin(expected, cap)));
+    }
+
+    body.append(at, int(length));
+    return true;
+}
+
+bool QHttpServerRequestPrivate::checkHeaderLimits(size_t length)
+{
+    headerSize += int(length);
+    if ((maxHeaderCount && headerCount > maxHeaderCount)
+            || (maxHeaderSize && headerSize > maxHeaderSize)) {
+        errorStatus = QHttpServerResponder::StatusCode::RequestHeaderFieldsTooLarge;
+        return false;
+    }
+    return true;
 }
 
 int QHttpServerRequestPrivate::onMessageComplete(http_parser *httpParser)
 {
     qCDebug(lc) << httpParser;
-    instance(httpParser)->state = State::OnMessageComplete;
+    auto i = instance(httpParser);
+    i->state = State::OnMessageComplete;
+    if (i->bodyDevice)
+        i->bodyDevice->finish();
+    if (i->bodyFile && (!i->bodyFile->flush() || !i->bodyFile->seek(0)))
+        return 1;
+    http_parser_pause(httpParser, 1);
     return 0;
 }
 
@@ -306,14 +706,161 @@ QVariantMap QHttpServerRequest::headers() const
     return ret;
 }
 
+/*!
+    Returns the body of the request.
+
+    A body that was buffered to disk, see
+    QHttpServerConfiguration::setBodyMemoryThreshold(), is read back into
+    memory by this function. Use bodyDevice() to avoid that.
+*/
 QByteArray QHttpServerRequest::body() const
 {
+    if (d->bodyFile) {
+        const qint64 position = d->bodyFile->pos();
+        d->bodyFile->seek(0);
+        const QByteArray body = d->bodyFile->readAll();
+        d->bodyFile->seek(position);
+        return body;
+    }
     return d->body;
 }
 
+/*!
+    Returns a device to read the body of this request from, or \c nullptr
+    if the request has no body.
+
+    For a request passed complete, the device holds the whole body, in
+    memory or in a temporary file, see
+    QHttpServerConfiguration::setBodyMemoryThreshold(), and is positioned
+    at its start.
+
+    When the route of the request streams its body, see
+    QHttpServerRouterRule::setBodyStreaming(), the device is sequential
+    and the body arrives through it. The handler of such a route is
+    called as soon as the headers are
+    received. The body then becomes readable piece by piece, with the
+    device emitting QIODevice::readyRead() as data arrives, and
+    QIODevice::readChannelFinished() at its end. body() stays empty.
+
+    Reading from the socket pauses while too much of the body is left
+    unread in the device, so a large upload takes constant memory. To
+    answer, keep the QHttpServerResponder and write to it once the body
+    is consumed; the device is valid until then.
+
+    \sa QHttpServerStreamingRouterRule
+*/
+QIODevice *QHttpServerRequest::bodyDevice() const
+{
+    if (d->bodyDevice)
+        return d->bodyDevice.get();
+    if (d->bodyFile)
+        return d->bodyFile.get();
+    if (d->body.isEmpty())
+        return nullptr;
+    if (!d->bodyBuffer) {
+        d->bodyBuffer.reset(new QBuffer(&d->body));
+        d->bodyBuffer->open(QIODevice::ReadOnly);
+    }
+    return d->bodyBuffer.get();
+}
+
 QHostAddress QHttpServerRequest::remoteAddress() const
 {
     return d->remoteAddress;
 }
 
+/*!
+    Returns the port of the client on its side of the connection, or 0
+    for a client without one.
+
+    With QHttpServerListenerOptions::proxyProtocol(), this is the port
+    the PROXY protocol header tells, like remoteAddress() is its address.
+
+    \sa remoteAddress()
+*/
+quint16 QHttpServerRequest::remotePort() const
+{
+    return d->remotePort;
+}
+
+/*!
+    Returns the value of the field of type \a type of the PROXY protocol
+    version 2 header the connection started with, or an empty byte
+    array if there is no such field.
+
+    Balancers pass on more about the client this way, for example the
+    ALPN protocol it negotiated (\c 0x01), the host name it asked for
+    (\c 0x02) or an identifier of the connection (\c 0x05).
+
+    \sa QHttpServerListenerOptions::setProxyProtocol()
+*/
+QByteArray QHttpServerRequest::proxyProtocolTlv(quint8 type) const
+{
+    if (!d->connectionState)
+        return QByteArray();
+    const QByteArray &tlvs = d->connectionState->proxyTlvs;
+    int i = 0;
+    while (i + 3 <= tlvs.size()) {
+        const int length = qFromBigEndian<quint16>(tlvs.constData() + i + 1);
+        if (i + 3 + length > tlvs.size())
+            break;
+        if (quint8(tlvs.at(i)) == type)
+            return tlvs.mid(i + 3, length);
+        i += 3 + length;
+    }
+    return QByteArray();
+}
+
+/*!
+    \fn template <typename T> T *QHttpServerRequest::connectionContext() const
+
+    Returns the object of type \c T attached to the connection this
+    request arrived on, default-constructing it the first time it is
+    asked for.
+
+    The object is shared by all the requests of a keep-alive connection,
+    or of the streams of an HTTP/2 connection, and destroyed once the
+    connection is closed. This lets a handler
+    derive something costly from the client only once, such as a
+    verified authentication token or a session looked up from it:
+
+    \code
+    struct Session
+    {
+        bool authenticated = false;
+        QString user;
+    };
+
+    server.route("/profile", [] (const QHttpServerRequest &request) {
+        Session *session = request.connectionContext<Session>();
+        if (!session->authenticated)
+            authenticate(request, session);
+        return profile(session->user);
+    });
+    \endcode
+
+    There is one object per type and connection. It must only be used
+    from the thread the request is handled in.
+
+    \sa QHttpServerResponder::connectionContext()
+*/
+
+void *QHttpServerRequest::findConnectionContext(const std::type_info &type) const
+{
+    if (!d->connectionState)
+        return nullptr;
+    for (const auto &context : d->connectionState->contexts) {
+        if (context.type == type)
+            return context.data.get();
+    }
+    return nullptr;
+}
+
+void *QHttpServerRequest::addConnectionContext(const std::type_info &type, void *context,
+                                               ConnectionContextDeleter deleter) const
+{
+    d->sharedConnectionState()->contexts.push_back({std::type_index(type), {context, deleter}});
+    return context;
+}
+
 QT_END_NAMESPACE
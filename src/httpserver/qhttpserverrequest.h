@@ -38,8 +38,11 @@
 #include <QtCore/qurlquery.h>
 #include <QtNetwork/qhostaddress.h>
 
+#include <typeinfo>
+
 QT_BEGIN_NAMESPACE
 
+class QIODevice;
 class QRegularExpression;
 class QString;
 class QTcpSocket;
@@ -48,7 +51,11 @@ class QHttpServerRequestPrivate;
 class Q_HTTPSERVER_EXPORT QHttpServerRequest
 {
     friend class QAbstractHttpServerPrivate;
+    friend class QHttpServerConnection;
+    friend class QHttpServerHttp2Connection;
     friend class QHttpServerResponse;
+    friend class QHttpServerRouter;
+    friend class QHttpServerWorker;
 
     Q_GADGET
 
@@ -89,11 +96,29 @@ public:
     Method method() const;
     QVariantMap headers() const;
     QByteArray body() const;
+    QIODevice *bodyDevice() const;
     QHostAddress remoteAddress() const;
+    quint16 remotePort() const;
+    QByteArray proxyProtocolTlv(quint8 type) const;
+
+    template <typename T>
+    T *connectionContext() const
+    {
+        if (void *context = findConnectionContext(typeid(T)))
+            return static_cast<T *>(context);
+        return static_cast<T *>(addConnectionContext(typeid(T), new T, [] (void *context) {
+            delete static_cast<T *>(context);
+        }));
+    }
 
 private:
     Q_DISABLE_COPY(QHttpServerRequest)
 
+    using ConnectionContextDeleter = void (*)(void *);
+    void *findConnectionContext(const std::type_info &type) const;
+    void *addConnectionContext(const std::type_info &type, void *context,
+                               ConnectionContextDeleter deleter) const;
+
 #if !defined(QT_NO_DEBUG_STREAM)
     friend Q_HTTPSERVER_EXPORT QDebug operator<<(QDebug debug, const QHttpServerRequest &request);
 #endif
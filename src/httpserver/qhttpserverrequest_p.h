@@ -31,15 +31,23 @@
 #define QHTTPSERVERREQUEST_P_H
 
 #include <QtHttpServer/qhttpserverrequest.h>
+#include <QtHttpServer/qhttpserverresponder.h>
+#include <private/qhttpserverbodydevice_p.h>
 
+#include <QtCore/qbuffer.h>
 #include <QtCore/qbytearray.h>
 #include <QtCore/qpair.h>
 #include <QtCore/qregularexpression.h>
 #include <QtCore/qshareddata.h>
 #include <QtCore/qstring.h>
+#include <QtCore/qtemporaryfile.h>
 #include <QtCore/qurl.h>
 #include <QtNetwork/qhostaddress.h>
 
+#include <memory>
+#include <typeindex>
+#include <vector>
+
 #include "../3rdparty/http-parser/http_parser.h"
 
 //
@@ -54,7 +62,7 @@
 
 QT_BEGIN_NAMESPACE
 
-class QHttpServerRequestPrivate : public QSharedData
+class Q_HTTPSERVER_EXPORT QHttpServerRequestPrivate : public QSharedData
 {
 public:
     QHttpServerRequestPrivate(const QHostAddress &remoteAddress);
@@ -74,12 +82,58 @@ public:
     } state = State::NotStarted;
     QByteArray body;
 
+    // Only set for requests whose body is streamed to their handler
+    std::unique_ptr<QHttpServerBodyDevice> bodyDevice;
+    // Only set for bodies larger than bodyMemoryThreshold
+    std::unique_ptr<QTemporaryFile> bodyFile;
+    std::unique_ptr<QBuffer> bodyBuffer;
+    qint64 bodyMemoryThreshold = 0;
+    static constexpr qint64 maxBodyReservation = 1024 * 1024;
+    bool headersHandled = false;
+    bool isStreamingBody() const { return bodyDevice && !bodyDevice->isFinished(); }
+
+    // Limits of QHttpServerConfiguration, zero if unlimited
+    int maxUrlLength = 0;
+    int maxHeaderCount = 0;
+    int maxHeaderSize = 0;
+    qint64 maxBodySize = 0;
+    // Set by the route of the request once its headers are in
+    qint64 routeMaxBodySize = 0;
+    bool exceedsBodyLimit(qint64 size) const;
+    bool exceedsBodyLimit() const;
+
+    // What was parsed of the current request, to check it against the limits
+    int urlLength = 0;
+    int headerCount = 0;
+    int headerSize = 0;
+    qint64 bodySize = 0;
+    bool parsingHeaderValue = false;
+    // Set for HTTP/1.1 requests with "Expect: 100-continue" until answered
+    bool expectsContinue = false;
+    void sendContinue(QIODevice *socket);
+    // Decision of the route of a request with a body, once its headers are in
+    QHttpServerResponder::StatusCode admission = QHttpServerResponder::StatusCode::Continue;
+    // Answer to a request the parser gave up on
+    QHttpServerResponder::StatusCode errorStatus = QHttpServerResponder::StatusCode::BadRequest;
+
     QUrl url;
 
     http_parser httpParser;
 
     QByteArray header(const QByteArray &key) const;
     bool parse(QIODevice *socket);
+    bool hasPendingData() const { return bufferOffset < buffer.size(); }
+    void unreadMessage(QIODevice *socket);
+    QByteArray takeUnparsed();
+
+    // Read buffer of the connection, reused across reads and requests.
+    // Parsed bytes are dropped when making room, except for those of a
+    // message whose headers are incomplete, so that an upgrade can hand
+    // them back to the socket.
+    static constexpr int readChunkSize = 16 * 1024;
+    QByteArray buffer;
+    int bufferOffset = 0;
+    int messageOffset = 0;
 
     QByteArray lastHeader;
     QMap<uint, QPair<QByteArray, QByteArray>> headers;
@@ -87,9 +141,38 @@ public:
     uint headerHash(const QByteArray &key) const;
 
     void clear();
+    void reset(const QHostAddress &address, quint16 port);
     QHostAddress remoteAddress;
+    quint16 remotePort = 0;
+
+    // Set for connections of listeners with QHttpServerListenerOptions::proxyProtocol()
+    // until the PROXY protocol header is read
+    bool expectsProxyHeader = false;
+    // Set for connections which may start with the HTTP/2 connection
+    // preface, until the first request shows whether they do
+    bool acceptsHttp2Preface = false;
+    // Set once the preface came, parse() leaves it in the buffer
+    bool http2Preface = false;
     bool handling{false};
 
+    // State of the connection, which the requests of its HTTP/2 streams
+    // share with it. Created once needed.
+    struct ConnectionContext
+    {
+        std::type_index type;
+        std::unique_ptr<void, void (*)(void *)> data;
+    };
+    struct ConnectionState
+    {
+        ~ConnectionState();
+        // Of the handlers, see connectionContext()
+        std::vector<ConnectionContext> contexts;
+        // Type-length-value fields of a version 2 PROXY protocol header, as they came
+        QByteArray proxyTlvs;
+    };
+    std::shared_ptr<ConnectionState> connectionState;
+    const std::shared_ptr<ConnectionState> &sharedConnectionState();
+
 private:
     static http_parser_settings httpParserSettings;
     static bool parseUrl(const char *at, size_t length, bool connect, QUrl *url);
@@ -106,6 +189,19 @@ private:
     static int onMessageComplete(http_parser *httpParser);
     static int onChunkHeader(http_parser *httpParser);
     static int onChunkComplete(http_parser *httpParser);
+
+    enum class ProxyHeader {
+        Incomplete,
+        Invalid,
+        Complete
+    };
+    ProxyHeader parseProxyHeader();
+    ProxyHeader parseProxyHeaderV1(const char *data, int size);
+    ProxyHeader parseProxyHeaderV2(const uchar *data, int size);
+
+    bool appendBody(const http_parser *httpParser, const char *at, qint64 length);
+    bool readChunk(QIODevice *socket);
+    bool checkHeaderLimits(size_t length);
 };
 
 QT_END_NAMESPACE
@@ -32,13 +32,24 @@
 #include <private/qhttpserverresponder_p.h>
 #include <private/qhttpserverliterals_p.h>
 #include <private/qhttpserverrequest_p.h>
+#include <QtCore/qfiledevice.h>
 #include <QtCore/qjsondocument.h>
 #include <QtCore/qloggingcategory.h>
+#include <QtCore/qsocketnotifier.h>
 #include <QtCore/qtimer.h>
 #include <QtNetwork/qtcpsocket.h>
+#if QT_CONFIG(ssl)
+#include <QtNetwork/qsslsocket.h>
+#endif
 #include <map>
 #include <memory>
 
+#if defined(Q_OS_LINUX)
+#include <cerrno>
+#include <cstring>
+#include <sys/sendfile.h>
+#endif
+
 #include "../3rdparty/http-parser/http_parser.h"
 
 QT_BEGIN_NAMESPACE
@@ -56,6 +67,11 @@ static const std::map<QHttpServerResponder::StatusCode, QByteArray> statusString
 #undef XX
 };
 
+#if QT_CONFIG(ssl)
+// The largest plaintext a TLS record carries, RFC 8446 section 5.1
+static constexpr qint64 tlsRecordSize = 16 * 1024;
+#endif
+
 template <qint64 BUFFERSIZE = 512>
 struct IOChunkedTransfer
 {
@@ -68,10 +84,14 @@ struct IOChunkedTransfer
     char buffer[BUFFERSIZE];
     qint64 beginIndex = -1;
     qint64 endIndex = -1;
+    // Set while the client lags behind reading, see QHttpServerResponseGuard
+    bool paused = false;
     QPointer<QIODevice> source;
     const QPointer<QIODevice> sink;
     const QMetaObject::Connection bytesWrittenConnection;
     const QMetaObject::Connection readyReadConnection;
+    // The next pipelined request waits until the body is written
+    const QHttpServerResponseGuard guard;
     IOChunkedTransfer(QIODevice *input, QIODevice *output) :
         source(input),
         sink(output),
@@ -80,13 +100,15 @@ struct IOChunkedTransfer
         })),
         readyReadConnection(QObject::connect(source.data(), &QIODevice::readyRead, [this] () {
             readFromInput();
-        }))
+        })),
+        guard(output)
     {
         Q_ASSERT(!source->atEnd());  // TODO error out
         QObject::connect(sink.data(), &QObject::destroyed, source.data(), &QObject::deleteLater);
         QObject::connect(source.data(), &QObject::destroyed, [this] () {
             delete this;
         });
+        guard.setCorked(true);
         readFromInput();
     }
 
@@ -94,6 +116,7 @@ struct IOChunkedTransfer
     {
         QObject::disconnect(bytesWrittenConnection);
         QObject::disconnect(readyReadConnection);
+        guard.setCorked(false);
     }
 
     inline bool isBufferEmpty()
@@ -104,7 +127,7 @@ struct IOChunkedTransfer
 
     void readFromInput()
     {
-        if (!isBufferEmpty()) // We haven't consumed all the data yet.
+        if (paused || !isBufferEmpty()) // We haven't consumed all the data yet.
             return;
         beginIndex = 0;
         endIndex = source->read(buffer, bufferSize);
@@ -119,8 +142,13 @@ struct IOChunkedTransfer
 
     void writeToOutput()
     {
-        if (isBufferEmpty())
+        if (isBufferEmpty()) {
+            if (paused && guard.isWriteBufferDrained()) {
+                paused = false;
+                readFromInput();
+            }
             return;
+        }
 
         const auto writtenBytes = sink->write(buffer + beginIndex, endIndex);
         if (writtenBytes < 0) {
@@ -129,7 +157,9 @@ struct IOChunkedTransfer
         }
         beginIndex += writtenBytes;
         if (isBufferEmpty()) {
-            if (source->bytesAvailable())
+            if (source->bytesAvailable() && guard.isWriteBufferFull())
+                paused = true; // Resumed from bytesWritten()
+            else if (source->bytesAvailable())
                 QTimer::singleShot(0, source.data(), [this]() { readFromInput(); });
             else if (source->atEnd()) // Finishing
                 source->deleteLater();
@@ -137,6 +167,213 @@ struct IOChunkedTransfer
     }
 };
 
+#if defined(Q_OS_LINUX)
+// Sends a file body with sendfile(2), straight from the page cache to the
+// socket, without copying it through user space.
+struct SendFileTransfer
+{
+    // Sent before yielding to the other connections of the thread
+    static constexpr qint64 maxBurstSize = 1024 * 1024;
+
+    QFileDevice *const source;
+    const QPointer<QTcpSocket> sink;
+    qint64 offset;
+    const qint64 end;
+    std::unique_ptr<QSocketNotifier> notifier;
+    QMetaObject::Connection bytesWrittenConnection;
+    // The next pipelined request waits until the body is written
+    const QHttpServerResponseGuard guard;
+
+    static QFileDevice *fileToSend(QIODevice *input, QTcpSocket *socket)
+    {
+        auto file = qobject_cast<QFileDevice *>(input);
+        if (!file || file->isSequential() || file->handle() < 0 || socket->socketDescriptor() < 0)
+            return nullptr;
+#if QT_CONFIG(ssl)
+        // Encrypted in user space
+        if (qobject_cast<QSslSocket *>(socket))
+            return nullptr;
+#endif
+        return file;
+    }
+
+    SendFileTransfer(QFileDevice *input, QTcpSocket *output) :
+        source(input),
+        sink(output),
+        offset(input->pos()),
+        end(input->size()),
+        guard(output)
+    {
+        // The notifier has to go before the socket closes its descriptor,
+        // which a new connection may get next
+        QObject::connect(sink.data(), &QIODevice::aboutToClose, source, [this] () {
+            stop();
+        });
+        QObject::connect(sink.data(), &QObject::destroyed, source, [this] () {
+            stop();
+        });
+        QObject::connect(source, &QObject::destroyed, [this] () {
+            delete this;
+        });
+        // Data still buffered in the device is not in the file yet
+        if (source->openMode() & QIODevice::WriteOnly)
+            source->flush();
+
+        // The headers, and the responses before this one, leave first
+        guard.setCorked(true);
+        sink->flush();
+        if (!sink->bytesToWrite()) {
+            send();
+            return;
+        }
+        bytesWrittenConnection = QObject::connect(sink.data(), &QIODevice::bytesWritten, [this] () {
+            if (sink->bytesToWrite())
+                return;
+            QObject::disconnect(bytesWrittenConnection);
+            send();
+        });
+    }
+
+    ~SendFileTransfer()
+    {
+        QObject::disconnect(bytesWrittenConnection);
+        guard.setCorked(false);
+    }
+
+    void send()
+    {
+        if (!sink || sink->state() != QAbstractSocket::ConnectedState) {
+            stop();
+            return;
+        }
+
+        const int socketDescriptor = int(sink->socketDescriptor());
+        qint64 burst = 0;
+        while (offset < end) {
+            if (burst >= maxBurstSize) {
+                waitForWritable();
+                return;
+            }
+            off_t position = off_t(offset);
+            const ssize_t sent = ::sendfile(socketDescriptor, source->handle(), &position,
+                                            size_t(qMin(end - offset, maxBurstSize)));
+            if (sent > 0) {
+                offset += sent;
+                burst += sent;
+            } else if (sent < 0 && errno == EINTR) {
+                continue;
+            } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                waitForWritable();
+                return;
+            } else {
+                // The announced Content-Length cannot be honored any more
+                qCWarning(lc, "Error sending file: %s",
+                          sent < 0 ? std::strerror(errno) : "file truncated");
+                stop();
+                sink->abort();
+                return;
+            }
+        }
+
+        stop();
+    }
+
+    // Ends the transfer, on success or not. Disabling the notifier
+    // unregisters it right away, send() may be running from its signal.
+    void stop()
+    {
+        if (notifier) {
+            notifier->setEnabled(false);
+            notifier.release()->deleteLater();
+        }
+        source->deleteLater();
+    }
+
+    // Nothing else writes to the socket meanwhile, so its own write
+    // notifier is disabled and this one does not clash with it.
+    void waitForWritable()
+    {
+        if (!notifier) {
+            notifier.reset(new QSocketNotifier(sink->socketDescriptor(), QSocketNotifier::Write));
+            QObject::connect(notifier.get(), &QSocketNotifier::activated, [this] () {
+                send();
+            });
+        }
+        notifier->setEnabled(true);
+    }
+};
+#endif // Q_OS_LINUX
+
+/*!
+    \internal
+
+    Ends the headers and writes the body from \a input, which is
+    deleted once done. A file sent over plain TCP goes through
+    sendfile(2) on Linux, any other device is copied in chunks.
+
+    QSslSocket encrypts in user space, through memory buffers the kernel
+    cannot take over, so kernel TLS and sendfile(2) are out of reach.
+    Its chunks are made as large as a TLS record instead, so that each
+    write fills one record rather than a few hundred bytes of one.
+*/
+void QHttpServerResponderPrivate::writeBody(QIODevice *input)
+{
+    head += "\r\n";
+    bodyStarted = true;
+    flush();
+
+    if (input->atEnd()) {
+        qCDebug(lc, "No more data available.");
+        input->deleteLater();
+        return;
+    }
+
+#if defined(Q_OS_LINUX)
+    if (auto file = SendFileTransfer::fileToSend(input, socket)) {
+        // file takes ownership of the SendFileTransfer pointer inside its constructor
+        new SendFileTransfer(file, socket);
+        return;
+    }
+#endif
+
+#if QT_CONFIG(ssl)
+    if (qobject_cast<QSslSocket *>(socket)) {
+        // input takes ownership of the IOChunkedTransfer pointer inside his constructor
+        new IOChunkedTransfer<tlsRecordSize>(input, socket);
+        return;
+    }
+#endif
+
+    // input takes ownership of the IOChunkedTransfer pointer inside his constructor
+    new IOChunkedTransfer<>(input, socket);
+}
+
+/*!
+    \internal
+
+    Writes the buffered status line and headers followed by \a size
+    bytes of \a body. A small body is appended to the headers, so that
+    the whole response reaches the socket in one write and usually
+    leaves in one segment, instead of as a dozen fragments.
+*/
+void QHttpServerResponderPrivate::flush(const char *body, qint64 size)
+{
+    if (head.isEmpty()) {
+        if (size > 0)
+            socket->write(body, size);
+        return;
+    }
+
+    if (size > 0 && size <= maxCoalescedBodySize) {
+        head.append(body, int(size));
+        size = 0;
+    }
+    socket->write(head);
+    head.clear();
+    if (size > 0)
+        socket->write(body, size);
+}
+
 /*!
     Constructs a QHttpServerResponder using the request \a request
     and the socket \a socket.
@@ -160,7 +397,12 @@ QHttpServerResponder::QHttpServerResponder(QHttpServerResponder &&other) :
     Destroys a QHttpServerResponder.
 */
 QHttpServerResponder::~QHttpServerResponder()
-{}
+{
+    Q_D(QHttpServerResponder);
+    // Headers written without a body, the socket may be gone by now
+    if (d && !d->head.isEmpty() && d->guard.isCurrent())
+        d->flush();
+}
 
 /*!
     Answers a request with an HTTP status code \a status and
@@ -170,6 +412,10 @@ QHttpServerResponder::~QHttpServerResponder()
     the content is available and sends it all at once but the read
     is done in chunks.
 
+    On Linux, a file sent over a connection without TLS is passed to
+    sendfile(2), so its content goes from the page cache to the socket
+    without being copied through the server.
+
     \note This function takes the ownership of \a data.
 */
 void QHttpServerResponder::write(QIODevice *data,
@@ -210,15 +456,7 @@ void QHttpServerResponder::write(QIODevice *data,
     for (auto &&header : headers)
         writeHeader(header.first, header.second);
 
-    d->socket->write("\r\n");
-
-    if (input->atEnd()) {
-        qCDebug(lc, "No more data available.");
-        return;
-    }
-
-    // input takes ownership of the IOChunkedTransfer pointer inside his constructor
-    new IOChunkedTransfer<>(input.take(), d->socket);
+    d->writeBody(input.take());
 }
 
 /*!
@@ -258,7 +496,7 @@ void QHttpServerResponder::write(const QJsonDocument &document,
     writeHeader(QHttpServerLiterals::contentLengthHeader(),
                 QByteArray::number(json.size()));
     writeHeaders(std::move(headers));
-    writeBody(document.toJson());
+    writeBody(json);
 }
 
 /*!
@@ -332,17 +570,21 @@ void QHttpServerResponder::write(HeaderList headers, StatusCode status)
 void QHttpServerResponder::writeStatusLine(StatusCode status,
                                            const QPair<quint8, quint8> &version)
 {
-    Q_D(const QHttpServerResponder);
+    Q_D(QHttpServerResponder);
     Q_ASSERT(d->socket->isOpen());
-    d->socket->write("HTTP/");
-    d->socket->write(QByteArray::number(version.first));
-    d->socket->write(".");
-    d->socket->write(QByteArray::number(version.second));
-    d->socket->write(" ");
-    d->socket->write(QByteArray::number(quint32(status)));
-    d->socket->write(" ");
-    d->socket->write(statusString.at(status));
-    d->socket->write("\r\n");
+    d->head.reserve(256);
+    d->head += "HTTP/";
+    d->head += QByteArray::number(version.first);
+    d->head += '.';
+    d->head += QByteArray::number(version.second);
+    d->head += ' ';
+    d->head += QByteArray::number(quint32(status));
+    d->head += ' ';
+    d->head += statusString.at(status);
+    d->head += "\r\n";
+    // The server closes the connection after this response, let the client know
+    if (d->guard.isLastResponse())
+        d->head += "Connection: close\r\n";
 }
 
 /*!
@@ -352,12 +594,12 @@ void QHttpServerResponder::writeStatusLine(StatusCode status,
 void QHttpServerResponder::writeHeader(const QByteArray &header,
                                        const QByteArray &value)
 {
-    Q_D(const QHttpServerResponder);
+    Q_D(QHttpServerResponder);
     Q_ASSERT(d->socket->isOpen());
-    d->socket->write(header);
-    d->socket->write(": ");
-    d->socket->write(value);
-    d->socket->write("\r\n");
+    d->head += header;
+    d->head += ": ";
+    d->head += value;
+    d->head += "\r\n";
 }
 
 /*!
@@ -378,11 +620,11 @@ void QHttpServerResponder::writeBody(const char *body, qint64 size)
     Q_ASSERT(d->socket->isOpen());
 
     if (!d->bodyStarted) {
-        d->socket->write("\r\n");
+        d->head += "\r\n";
         d->bodyStarted = true;
     }
 
-    d->socket->write(body, size);
+    d->flush(body, size);
 }
 
 /*!
@@ -403,11 +645,31 @@ void QHttpServerResponder::writeBody(const QByteArray &body)
 
 /*!
     Returns the socket used.
+
+    The status line and headers are buffered until the body starts, they
+    are written out first so that writes to the socket come after them.
 */
 QTcpSocket *QHttpServerResponder::socket() const
+{
+    d_ptr->flush();
+    return d_ptr->socket;
+}
+
+/*!
+    \fn template <typename T> T *QHttpServerResponder::connectionContext() const
+
+    Returns the object of type \c T attached to the connection this
+    responder answers on, like QHttpServerRequest::connectionContext().
+
+    A responder kept past its handler, for instance to answer a streamed
+    body, may outlive its connection. This function then returns
+    \c nullptr.
+*/
+
+const QHttpServerRequest *QHttpServerResponder::connectionRequest() const
 {
     Q_D(const QHttpServerResponder);
-    return d->socket;
+    return d->guard.isCurrent() ? &d->request : nullptr;
 }
 
 QT_END_NAMESPACE
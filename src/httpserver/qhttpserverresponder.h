@@ -31,6 +31,7 @@
 #define QHTTPSERVERRESPONDER_H
 
 #include <QtHttpServer/qthttpserverglobal.h>
+#include <QtHttpServer/qhttpserverrequest.h>
 
 #include <QtCore/qdebug.h>
 #include <QtCore/qpair.h>
@@ -46,7 +47,6 @@
 QT_BEGIN_NAMESPACE
 
 class QTcpSocket;
-class QHttpServerRequest;
 
 class QHttpServerResponderPrivate;
 class Q_HTTPSERVER_EXPORT QHttpServerResponder final
@@ -54,6 +54,7 @@ class Q_HTTPSERVER_EXPORT QHttpServerResponder final
     Q_DECLARE_PRIVATE(QHttpServerResponder)
 
     friend class QAbstractHttpServer;
+    friend class QHttpServerResponse;
 
 public:
     enum class StatusCode {
@@ -174,9 +175,18 @@ public:
 
     QTcpSocket *socket() const;
 
+    template <typename T>
+    T *connectionContext() const
+    {
+        const QHttpServerRequest *request = connectionRequest();
+        return request ? request->connectionContext<T>() : nullptr;
+    }
+
 private:
     QHttpServerResponder(const QHttpServerRequest &request, QTcpSocket *socket);
 
+    const QHttpServerRequest *connectionRequest() const;
+
     QScopedPointer<QHttpServerResponderPrivate> d_ptr;
 };
 
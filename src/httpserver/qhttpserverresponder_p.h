@@ -33,6 +33,7 @@
 #include <QtHttpServer/qthttpserverglobal.h>
 #include <QtHttpServer/qhttpserverrequest.h>
 #include <QtHttpServer/qhttpserverresponder.h>
+#include <private/qhttpserverconnection_p.h>
 
 #include <QtCore/qcoreapplication.h>
 #include <QtCore/qpair.h>
@@ -57,7 +58,13 @@ class QHttpServerResponderPrivate
 {
 public:
     QHttpServerResponderPrivate(const QHttpServerRequest &request, QTcpSocket *const socket)
-        : request(request), socket(socket) {}
+        : request(request), socket(socket), guard(socket) {}
+
+    void flush(const char *body = nullptr, qint64 size = 0);
+    void writeBody(QIODevice *input);
+
+    // Bodies up to this size leave in the same write as the headers
+    static constexpr qint64 maxCoalescedBodySize = 16 * 1024;
 
     const QHttpServerRequest &request;
 #if defined(QT_DEBUG)
@@ -66,6 +73,9 @@ public:
     QTcpSocket *const socket;
 #endif
     bool bodyStarted{false};
+    // Status line and headers, written together once the body starts
+    QByteArray head;
+    const QHttpServerResponseGuard guard;
 };
 
 QT_END_NAMESPACE
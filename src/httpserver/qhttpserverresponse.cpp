@@ -39,6 +39,8 @@
 #include <QtCore/qmimedatabase.h>
 #include <QtNetwork/qtcpsocket.h>
 
+#include <memory>
+
 QT_BEGIN_NAMESPACE
 
 QHttpServerResponsePrivate::QHttpServerResponsePrivate(
@@ -148,10 +150,11 @@ QHttpServerResponse QHttpServerResponse::fromFile(const QString &fileName)
     QFile file(fileName);
     if (!file.open(QFile::ReadOnly))
         return QHttpServerResponse(StatusCode::NotFound);
-    const QByteArray data = file.readAll();
-    file.close();
-    const QByteArray mimeType = QMimeDatabase().mimeTypeForFileNameAndData(fileName, data).name().toLocal8Bit();
-    return QHttpServerResponse(mimeType, data);
+    // Only the start of the file is read, the body is sent when written
+    const QByteArray mimeType = QMimeDatabase().mimeTypeForFileNameAndData(fileName, &file).name().toLocal8Bit();
+    QHttpServerResponse response(mimeType, QByteArray());
+    response.d_ptr->fileName = fileName;
+    return response;
 }
 
 QHttpServerResponse::QHttpServerResponse(QHttpServerResponsePrivate *d)
@@ -166,6 +169,10 @@ QHttpServerResponse::QHttpServerResponse(QHttpServerResponsePrivate *d)
 QByteArray QHttpServerResponse::data() const
 {
     Q_D(const QHttpServerResponse);
+    if (!d->fileName.isEmpty()) {
+        QFile file(d->fileName);
+        return file.open(QFile::ReadOnly) ? file.readAll() : QByteArray();
+    }
     return d->data;
 }
 
@@ -356,11 +363,27 @@ void QHttpServerResponse::write(QHttpServerResponder &&responder) const
     if (responder.socket()->state() != QAbstractSocket::ConnectedState)
         return;
 
+    std::unique_ptr<QFile> file;
+    if (!d->fileName.isEmpty()) {
+        file.reset(new QFile(d->fileName));
+        if (!file->open(QFile::ReadOnly)) {
+            responder.write(StatusCode::NotFound);
+            return;
+        }
+    }
+
     responder.writeStatusLine(d->statusCode);
 
     for (auto &&header : d->headers)
         responder.writeHeader(header.first, header.second);
 
+    if (file) {
+        responder.writeHeader(QHttpServerLiterals::contentLengthHeader(),
+                              QByteArray::number(file->size()));
+        responder.d_func()->writeBody(file.release());
+        return;
+    }
+
     responder.writeHeader(QHttpServerLiterals::contentLengthHeader(),
                           QByteArray::number(d->data.size()));
 
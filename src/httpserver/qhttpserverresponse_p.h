@@ -66,6 +66,8 @@ public:
     QHttpServerResponsePrivate(const QHttpServerResponse::StatusCode sc);
 
     QByteArray data;
+    // Set by fromFile(), the body is read from the file when written
+    QString fileName;
     QHttpServerResponse::StatusCode statusCode;
     std::unordered_multimap<QByteArray, QByteArray, HashHelper> headers;
     bool derived{false};
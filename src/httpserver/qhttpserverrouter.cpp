@@ -33,6 +33,7 @@
 #include <QtHttpServer/qhttpserverrouterrule.h>
 #include <QtHttpServer/qhttpserverrequest.h>
 
+#include <private/qhttpserverrequest_p.h>
 #include <private/qhttpserverrouterrule_p.h>
 
 #include <QtCore/qloggingcategory.h>
@@ -286,7 +287,9 @@ bool QHttpServerRouter::addRuleImpl(QHttpServerRouterRule *rule,
         return false;
     }
 
+    QMutexLocker locker(&d->mutex);
     d->rules.emplace_back(rule);
+    d->generation.ref();
     return true;
 }
 
@@ -296,17 +299,110 @@ bool QHttpServerRouter::addRuleImpl(QHttpServerRouterRule *rule,
     Iterates through the list of rules to find the first that matches,
     then executes this rule, returning \c true. Returns \c false if no rule
     matches the request.
+
+    When called from a thread other than the one that created the router,
+    as happens with QHttpServerConfiguration::setWorkerThreadCount(), the
+    matching rule runs a copy of its handler that belongs to the calling
+    thread.
 */
 bool QHttpServerRouter::handleRequest(const QHttpServerRequest &request,
                                       QTcpSocket *socket) const
+{
+    return handleRequestImpl(request, socket, false);
+}
+
+/*!
+    Handles a request whose headers were received, but not its body yet.
+
+    Finds the first rule that matches, like handleRequest(). Executes it
+    and returns \c true if that rule streams the request body, see
+    QHttpServerRouterRule::setBodyStreaming(). Returns \c false
+    otherwise, and the request is to be handled with handleRequest() once
+    complete.
+
+    A request sent with \c {Expect: 100-continue} that no rule matches is
+    refused with \c {404 Not Found}, without asking for its body.
+*/
+bool QHttpServerRouter::handleRequestHeaders(const QHttpServerRequest &request,
+                                             QTcpSocket *socket) const
+{
+    return handleRequestImpl(request, socket, true);
+}
+
+/*!
+    \internal
+
+    Decides whether \a rule admits the body of \a request, applying its
+    size limit and admission handler, and returns \c true if \a rule is
+    to be executed before the body is received. Requests to such rules
+    get their \c {100 Continue} answer right away, on \a socket.
+
+    A null \a rule stands for a request no rule matches.
+*/
+bool QHttpServerRouter::acceptsBody(const QHttpServerRouterRule *rule,
+                                    const QHttpServerRequest &request, QTcpSocket *socket)
+{
+    auto d = request.d.data();
+    if (!rule) {
+        // The client waits for a go-ahead, the missing handler would
+        // only answer after the body
+        if (d->expectsContinue)
+            d->admission = QHttpServerResponder::StatusCode::NotFound;
+        return false;
+    }
+
+    d->routeMaxBodySize = rule->maxBodySize();
+    if (d->exceedsBodyLimit())
+        d->admission = QHttpServerResponder::StatusCode::PayloadTooLarge;
+    else if (const auto &admissionHandler = rule->d_func()->admissionHandler)
+        d->admission = admissionHandler(request);
+
+    if (d->admission != QHttpServerResponder::StatusCode::Continue || !rule->bodyStreaming())
+        return false;
+
+    d->sendContinue(socket);
+    return true;
+}
+
+bool QHttpServerRouter::handleRequestImpl(const QHttpServerRequest &request,
+                                          QTcpSocket *socket, bool headersOnly) const
 {
     Q_D(const QHttpServerRouter);
-    for (const auto &rule : qAsConst(d->rules)) {
-        if (rule->exec(request, socket))
+    if (QThread::currentThread() == d->thread) {
+        for (const auto &rule : qAsConst(d->rules)) {
+            QRegularExpressionMatch match;
+            if (!rule->matches(request, &match))
+                continue;
+            if (headersOnly && !acceptsBody(rule.get(), request, socket))
+                return false;
+            rule->d_func()->routerHandler(match, request, socket);
             return true;
+        }
+
+        return headersOnly && acceptsBody(nullptr, request, socket);
+    }
+
+    auto &replica = d->replicas.localData();
+    if (replica.generation != d->generation.loadAcquire()) {
+        QMutexLocker locker(&d->mutex);
+        replica.rules.clear();
+        replica.rules.reserve(d->rules.size());
+        for (const auto &rule : d->rules)
+            replica.rules.emplace_back(rule.get(), rule->d_func()->routerHandler);
+        replica.generation = d->generation.loadRelaxed();
+    }
+
+    for (const auto &entry : replica.rules) {
+        QRegularExpressionMatch match;
+        if (!entry.first->matches(request, &match))
+            continue;
+        if (headersOnly && !acceptsBody(entry.first, request, socket))
+            return false;
+        entry.second(match, request, socket);
+        return true;
     }
 
-    return false;
+    return headersOnly && acceptsBody(nullptr, request, socket);
 }
 
 QT_END_NAMESPACE
@@ -113,6 +113,8 @@ public:
 
     bool handleRequest(const QHttpServerRequest &request,
                        QTcpSocket *socket) const;
+    bool handleRequestHeaders(const QHttpServerRequest &request,
+                              QTcpSocket *socket) const;
 
 private:
     template<typename ViewTraits, int ... Idx>
@@ -127,6 +129,11 @@ private:
     bool addRuleImpl(QHttpServerRouterRule *rule,
                      const std::initializer_list<int> &metaTypes);
 
+    bool handleRequestImpl(const QHttpServerRequest &request,
+                           QTcpSocket *socket, bool headersOnly) const;
+    static bool acceptsBody(const QHttpServerRouterRule *rule,
+                            const QHttpServerRequest &request, QTcpSocket *socket);
+
     template<typename ViewHandler, typename ViewTraits, int ... Cx, int ... Px>
     typename std::enable_if<ViewTraits::Arguments::CapturableCount != 0, typename ViewTraits::BindableType>::type
             bindCapturedImpl(ViewHandler &&handler,
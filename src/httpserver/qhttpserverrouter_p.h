@@ -33,11 +33,17 @@
 #include <QtHttpServer/qhttpserverrouter.h>
 #include <QtHttpServer/qhttpserverrouterrule.h>
 
+#include <QtCore/qatomic.h>
 #include <QtCore/qmap.h>
 #include <QtCore/qlist.h>
+#include <QtCore/qmutex.h>
 #include <QtCore/qstring.h>
+#include <QtCore/qthread.h>
+#include <QtCore/qthreadstorage.h>
 
 #include <memory>
+#include <utility>
+#include <vector>
 
 //
 //  W A R N I N G
@@ -58,6 +64,20 @@ public:
 
     QMap<int, QLatin1String> converters;
     std::list<std::unique_ptr<QHttpServerRouterRule>> rules;
+
+    // Threads other than the one owning the router run their own copy
+    // of the rule handlers, see QHttpServerRouter::handleRequest().
+    struct Replica
+    {
+        int generation = 0;
+        std::vector<std::pair<const QHttpServerRouterRule *,
+                              QHttpServerRouterRule::RouterHandler>> rules;
+    };
+
+    QThread *const thread = QThread::currentThread();
+    QAtomicInt generation{1};
+    mutable QMutex mutex;
+    mutable QThreadStorage<Replica> replicas;
 };
 
 QT_END_NAMESPACE
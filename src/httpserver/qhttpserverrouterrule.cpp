@@ -176,6 +176,127 @@ QHttpServerRouterRule::~QHttpServerRouterRule()
 {
 }
 
+/*!
+    Returns \c true if requests matching this rule stream their body.
+
+    \sa setBodyStreaming()
+*/
+bool QHttpServerRouterRule::bodyStreaming() const
+{
+    Q_D(const QHttpServerRouterRule);
+    return d->bodyStreaming;
+}
+
+/*!
+    Enables or disables streaming of the request body, according to
+    \a enabled.
+
+    By default, a request is only passed to its rule once its whole body
+    has been received. With streaming enabled, the rule is executed as
+    soon as the headers are in, and the body arrives through
+    QHttpServerRequest::bodyDevice() afterwards. Requests without a body
+    are passed once complete, with no body device.
+
+    Call this function before adding the rule to a router.
+
+    \sa QHttpServerStreamingRouterRule, QAbstractHttpServer::handleRequestHeaders()
+*/
+void QHttpServerRouterRule::setBodyStreaming(bool enabled)
+{
+    Q_D(QHttpServerRouterRule);
+    d->bodyStreaming = enabled;
+}
+
+/*!
+    Returns the maximum size, in bytes, of the body of requests to this
+    rule.
+
+    \sa setMaxBodySize()
+*/
+qint64 QHttpServerRouterRule::maxBodySize() const
+{
+    Q_D(const QHttpServerRouterRule);
+    return d->maxBodySize;
+}
+
+/*!
+    Limits the body of requests matching this rule to \a size bytes, on
+    top of QHttpServerConfiguration::maxBodySize(). Requests announcing a
+    larger body are answered with \c {413 Payload Too Large} without
+    calling the rule, chunked ones as soon as they exceed the limit.
+
+    A value of zero (the default) leaves only the limit of the server,
+    which a rule cannot raise.
+
+    Call this function before adding the rule to a router.
+*/
+void QHttpServerRouterRule::setMaxBodySize(qint64 size)
+{
+    Q_D(QHttpServerRouterRule);
+    d->maxBodySize = qMax(qint64(0), size);
+}
+
+/*!
+    Sets \a handler to decide whether requests matching this rule may
+    send their body.
+
+    The handler is called with the request once its headers are complete,
+    before any of its body is read, and only for requests having a body.
+    Returning QHttpServerResponder::StatusCode::Continue admits the
+    request. Any other status, typically a 4xx or 5xx one such as
+    \c {401 Unauthorized} or \c {507 Insufficient Storage}, is sent as
+    the final answer and the connection is closed, without the rule
+    being executed.
+
+    Clients sending \c {Expect: 100-continue} wait for the decision
+    before sending the body, so rejected uploads cost neither the
+    bandwidth nor the time to transfer them. Admitted ones are answered
+    with \c {100 Continue}.
+
+    \code
+    auto rule = std::make_unique<QHttpServerRouterRule>("/upload", "POST", ...);
+    rule->setAdmissionHandler([] (const QHttpServerRequest &request) {
+        return request.value("Authorization").isEmpty()
+                ? QHttpServerResponder::StatusCode::Unauthorized
+                : QHttpServerResponder::StatusCode::Continue;
+    });
+    server.router()->addRule(std::move(rule));
+    \endcode
+
+    With worker threads, the handler is called from all of them at once.
+
+    Call this function before adding the rule to a router.
+
+    \sa setMaxBodySize(), QHttpServerConfiguration::setWorkerThreadCount()
+*/
+void QHttpServerRouterRule::setAdmissionHandler(AdmissionHandler &&handler)
+{
+    Q_D(QHttpServerRouterRule);
+    d->admissionHandler = std::move(handler);
+}
+
+/*!
+    \class QHttpServerStreamingRouterRule
+    \brief The QHttpServerStreamingRouterRule class is a rule streaming the
+    body of its requests.
+
+    QHttpServerStreamingRouterRule is a QHttpServerRouterRule with
+    QHttpServerRouterRule::setBodyStreaming() enabled. It takes the same
+    constructor arguments, and is meant to be passed as the rule type of
+    QHttpServer::route():
+
+    \code
+    server.route<QHttpServerStreamingRouterRule>("/upload", "POST",
+            [] (const QHttpServerRequest &request, QHttpServerResponder &&responder) {
+        auto upload = new Upload(request.bodyDevice(), std::move(responder));
+        ...
+    });
+    \endcode
+
+    The handler is called once the headers are received. It must keep
+    the responder until it has consumed the body, and answer then.
+*/
+
 /*!
     Returns true if the methods is valid
 */
@@ -31,9 +31,13 @@
 #define QHTTPSERVERROUTERRULE_H
 
 #include <QtHttpServer/qhttpserverrequest.h>
+#include <QtHttpServer/qhttpserverresponder.h>
 
 #include <QtCore/qmap.h>
 
+#include <functional>
+#include <utility>
+
 QT_BEGIN_NAMESPACE
 
 class QString;
@@ -51,6 +55,8 @@ public:
     using RouterHandler = std::function<void(const QRegularExpressionMatch &,
                                              const QHttpServerRequest &,
                                              QTcpSocket *)>;
+    using AdmissionHandler = std::function<QHttpServerResponder::StatusCode(
+                                               const QHttpServerRequest &)>;
 
     explicit QHttpServerRouterRule(const QString &pathPattern, RouterHandler &&routerHandler);
     explicit QHttpServerRouterRule(const QString &pathPattern,
@@ -65,6 +71,14 @@ public:
 
     virtual ~QHttpServerRouterRule();
 
+    bool bodyStreaming() const;
+    void setBodyStreaming(bool enabled);
+
+    qint64 maxBodySize() const;
+    void setMaxBodySize(qint64 size);
+
+    void setAdmissionHandler(AdmissionHandler &&handler);
+
 protected:
     bool exec(const QHttpServerRequest &request, QTcpSocket *socket) const;
 
@@ -85,6 +99,17 @@ private:
     friend class QHttpServerRouter;
 };
 
+class QHttpServerStreamingRouterRule : public QHttpServerRouterRule
+{
+public:
+    template<typename ... Args>
+    explicit QHttpServerStreamingRouterRule(Args && ... args)
+        : QHttpServerRouterRule(std::forward<Args>(args)...)
+    {
+        setBodyStreaming(true);
+    }
+};
+
 QT_END_NAMESPACE
 
 #endif // QHTTPSERVERROUTERRULE_H
@@ -55,6 +55,9 @@ public:
     QHttpServerRouterRule::RouterHandler routerHandler;
 
     QRegularExpression pathRegexp;
+    bool bodyStreaming = false;
+    qint64 maxBodySize = 0;
+    QHttpServerRouterRule::AdmissionHandler admissionHandler;
 };
 
 QT_END_NAMESPACE
@@ -0,0 +1,184 @@
+/****************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtHttpServer module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <private/qhttpservertimerwheel_p.h>
+
+QT_BEGIN_NAMESPACE
+
+// With the 100 ms resolution, one turn of the wheel takes 51.2 seconds.
+// Longer timeouts stay in their bucket for more than one turn.
+static const int BucketCount = 512;
+
+/*!
+    \internal
+    \class QHttpServerTimerWheel
+
+    A hashed timer wheel, tracking the timeouts of many connections with
+    a single timer.
+
+    Entries hash into one of a fixed number of buckets by the tick they
+    expire at. Scheduling and cancelling are O(1), and advance() only
+    looks at the buckets of the ticks that elapsed since the last call,
+    so a large number of idle entries costs next to nothing per tick.
+
+    The owner of the wheel calls advance() every Resolution milliseconds
+    while the wheel is not empty. Expired entries are removed from the
+    wheel before their Entry::expire() is called, which may schedule or
+    cancel any entry, including itself.
+*/
+
+/*!
+    \internal
+
+    Removes the entry from its wheel, if it is scheduled.
+*/
+QHttpServerTimerWheel::Entry::~Entry()
+{
+    if (wheel)
+        wheel->cancel(this);
+}
+
+QHttpServerTimerWheel::QHttpServerTimerWheel()
+    : buckets(BucketCount)
+{
+    for (auto &bucket : buckets)
+        bucket.prev = bucket.next = &bucket;
+    clock.start();
+}
+
+QHttpServerTimerWheel::~QHttpServerTimerWheel()
+{
+    for (auto &bucket : buckets) {
+        while (bucket.next != &bucket) {
+            auto entry = static_cast<Entry *>(bucket.next);
+            remove(entry);
+            entry->wheel = nullptr;
+        }
+    }
+}
+
+/*!
+    \internal
+
+    Schedules \a entry to expire in \a msecs milliseconds, rounded up to
+    the resolution of the wheel. An entry which is already scheduled is
+    moved to its new deadline.
+*/
+void QHttpServerTimerWheel::schedule(Entry *entry, int msecs)
+{
+    Q_ASSERT(!entry->wheel || entry->wheel == this);
+    const qint64 elapsed = clock.elapsed();
+    if (entry->wheel) {
+        remove(entry);
+    } else {
+        // Nothing moved the wheel while it was empty
+        if (isEmpty())
+            currentTick = elapsed / Resolution;
+        entry->wheel = this;
+        ++count;
+    }
+
+    entry->tick = qMax((elapsed + msecs + Resolution - 1) / Resolution, currentTick + 1);
+    append(&buckets[std::size_t(entry->tick % BucketCount)], entry);
+}
+
+/*!
+    \internal
+
+    Removes \a entry from the wheel, it does not expire.
+*/
+void QHttpServerTimerWheel::cancel(Entry *entry)
+{
+    if (!entry->wheel)
+        return;
+    Q_ASSERT(entry->wheel == this);
+    remove(entry);
+    entry->wheel = nullptr;
+    --count;
+}
+
+/*!
+    \internal
+
+    Expires every entry whose deadline has passed.
+*/
+void QHttpServerTimerWheel::advance()
+{
+    const qint64 now = clock.elapsed() / Resolution;
+    Link expired;
+    expired.prev = expired.next = &expired;
+
+    if (now - currentTick >= BucketCount) {
+        for (auto &bucket : buckets)
+            collect(&bucket, now, &expired);
+    } else {
+        for (qint64 tick = currentTick + 1; tick <= now; ++tick)
+            collect(&buckets[std::size_t(tick % BucketCount)], now, &expired);
+    }
+    currentTick = now;
+
+    // Entries stay scheduled while they wait in the expired list, so that
+    // the expiry of one entry can still cancel or reschedule another.
+    while (expired.next != &expired) {
+        auto entry = static_cast<Entry *>(expired.next);
+        remove(entry);
+        entry->wheel = nullptr;
+        --count;
+        entry->expire();
+    }
+}
+
+void QHttpServerTimerWheel::append(Link *list, Link *node)
+{
+    node->prev = list->prev;
+    node->next = list;
+    list->prev->next = node;
+    list->prev = node;
+}
+
+void QHttpServerTimerWheel::remove(Link *node)
+{
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->prev = node->next = nullptr;
+}
+
+void QHttpServerTimerWheel::collect(Link *bucket, qint64 tick, Link *expired)
+{
+    for (Link *node = bucket->next; node != bucket;) {
+        Link *next = node->next;
+        if (static_cast<Entry *>(node)->tick <= tick) {
+            remove(node);
+            append(expired, node);
+        }
+        node = next;
+    }
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,105 @@
+/****************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtHttpServer module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QHTTPSERVERTIMERWHEEL_P_H
+#define QHTTPSERVERTIMERWHEEL_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists for the convenience
+// of QHttpServer. This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+
+#include <QtHttpServer/qthttpserverglobal.h>
+
+#include <QtCore/qelapsedtimer.h>
+
+#include <vector>
+
+QT_BEGIN_NAMESPACE
+
+class QHttpServerTimerWheel
+{
+    struct Link
+    {
+        Link *prev = nullptr;
+        Link *next = nullptr;
+    };
+
+public:
+    class Entry : private Link
+    {
+    public:
+        Entry() = default;
+        virtual ~Entry();
+
+        bool isScheduled() const { return wheel != nullptr; }
+
+    protected:
+        virtual void expire() = 0;
+
+    private:
+        Q_DISABLE_COPY(Entry)
+        friend class QHttpServerTimerWheel;
+
+        QHttpServerTimerWheel *wheel = nullptr;
+        qint64 tick = 0;
+    };
+
+    static constexpr int Resolution = 100;
+
+    QHttpServerTimerWheel();
+    ~QHttpServerTimerWheel();
+
+    void schedule(Entry *entry, int msecs);
+    void cancel(Entry *entry);
+    void advance();
+
+    bool isEmpty() const { return count == 0; }
+
+private:
+    Q_DISABLE_COPY(QHttpServerTimerWheel)
+
+    static void append(Link *list, Link *node);
+    static void remove(Link *node);
+    void collect(Link *bucket, qint64 tick, Link *expired);
+
+    QElapsedTimer clock;
+    std::vector<Link> buckets;
+    qint64 currentTick = 0;
+    int count = 0;
+};
+
+QT_END_NAMESPACE
+
+#endif // QHTTPSERVERTIMERWHEEL_P_H
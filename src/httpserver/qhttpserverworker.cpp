@@ -0,0 +1,274 @@
+/****************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtHttpServer module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <private/qhttpserverworker_p.h>
+
+#include <private/qabstracthttpserver_p.h>
+#include <private/qhttpserverconnection_p.h>
+#include <private/qhttpserverhttp2connection_p.h>
+
+#include <QtCore/qcoreevent.h>
+#include <QtCore/qloggingcategory.h>
+#include <QtCore/qmetaobject.h>
+#include <QtNetwork/qtcpserver.h>
+#include <QtNetwork/qtcpsocket.h>
+
+QT_BEGIN_NAMESPACE
+
+Q_DECLARE_LOGGING_CATEGORY(lcHttpServer)
+
+// Idle connections kept around for reuse, per worker
+static const std::size_t maxIdleConnections = 128;
+
+/*!
+    \internal
+    \class QHttpServerWorker
+
+    Owns the connections handled by one thread of a QAbstractHttpServer.
+
+    Worker threads each run one of these, see
+    QHttpServerConfiguration::setWorkerThreadCount(). When there are no
+    worker threads, a single worker living in the thread of the server
+    handles every connection.
+
+    The worker keeps a pool of idle QHttpServerConnection objects, so
+    that connection churn reuses their request and parser state instead
+    of allocating it for every accepted socket.
+
+    The timeouts of all the connections of a worker share a single timer
+    wheel, see QHttpServerTimerWheel.
+*/
+
+QHttpServerWorker::QHttpServerWorker(QAbstractHttpServerPrivate *server)
+    : server(server), configuration(server->configuration)
+{
+}
+
+QHttpServerWorker::~QHttpServerWorker()
+{
+}
+
+/*!
+    \internal
+
+    Creates a server listening on \a socketDescriptor which belongs to
+    this worker, see QHttpServerConfiguration::setListenerSharding().
+    Returns \c nullptr on failure.
+*/
+QTcpServer *QHttpServerWorker::listen(qintptr socketDescriptor)
+{
+    auto tcpServer = server->createTcpServer(this);
+    if (!tcpServer->setSocketDescriptor(socketDescriptor)) {
+        qCCritical(lcHttpServer, "listen failed: %s", qPrintable(tcpServer->errorString()));
+        delete tcpServer;
+        return nullptr;
+    }
+
+    connect(tcpServer, &QTcpServer::newConnection, this, [this, tcpServer]() {
+        acceptConnections(tcpServer);
+    });
+    return tcpServer;
+}
+
+/*!
+    \internal
+
+    Handles all the pending connections of \a tcpServer in this worker.
+*/
+void QHttpServerWorker::acceptConnections(QTcpServer *tcpServer)
+{
+    const auto options = server->listenerOptionsOf(tcpServer);
+    QHostAddress countedAddress;
+    while (auto socket = server->nextPendingConnection(tcpServer, configuration,
+                                                       &countedAddress)) {
+        connectionCount.ref();
+        handleConnection(socket, options, countedAddress);
+    }
+}
+
+/*!
+    \internal
+
+    Takes over \a socket, which lives in the thread of this worker and
+    is already accounted for in connectionCount, with the \a options of
+    the listener which accepted it. The server counted it against
+    \a countedAddress, unless that is null.
+*/
+void QHttpServerWorker::handleConnection(QTcpSocket *socket,
+                                         const QHttpServerListenerOptions &options,
+                                         const QHostAddress &countedAddress)
+{
+    auto connection = acquireConnection();
+    acceptedConnections.ref();
+    connection->setSocket(socket, options);
+    connection->countedAddress = countedAddress;
+
+    // The socket might have buffered data or lost its peer while it was
+    // moving between threads, nobody was listening to its signals then.
+    if (socket->state() == QAbstractSocket::UnconnectedState)
+        socket->deleteLater();
+    else if (socket->bytesAvailable())
+        Q_EMIT socket->readyRead();
+}
+
+/*!
+    \internal
+
+    Serves the HTTP/2 \a stream, a stand-in socket carrying a single
+    request, like a connection of its own. Streams are not counted as
+    connections, and their requests share the state of the connection
+    carrying them.
+
+    \sa QHttpServerHttp2Connection
+*/
+void QHttpServerWorker::handleStream(QHttpServerHttp2Stream *stream)
+{
+    auto connection = acquireConnection();
+    connection->isStream = true;
+    connection->setSocket(stream, QHttpServerListenerOptions());
+    connection->request.d->connectionState = stream->connectionState();
+    if (stream->state() == QAbstractSocket::UnconnectedState)
+        stream->deleteLater();
+    else if (stream->bytesAvailable())
+        Q_EMIT stream->readyRead();
+}
+
+/*!
+    \internal
+
+    Called by \a connection once its socket is gone.
+*/
+void QHttpServerWorker::releaseConnection(QHttpServerConnection *connection)
+{
+    connectionCount.deref();
+    recycleConnection(connection);
+    if (draining)
+        checkDrained();
+}
+
+/*!
+    \internal
+
+    Keeps \a connection, which has no socket anymore, for reuse.
+*/
+void QHttpServerWorker::recycleConnection(QHttpServerConnection *connection)
+{
+    if (idleConnections.size() < maxIdleConnections)
+        idleConnections.push_back(connection);
+    else
+        connection->deleteLater();
+}
+
+/*!
+    \internal
+
+    Stops the listener shards of this worker and closes its connections
+    as soon as they are done with their current request. The server is
+    told once the last one is gone.
+
+    \sa QAbstractHttpServer::drain()
+*/
+void QHttpServerWorker::drain()
+{
+    draining = true;
+    const auto tcpServers = findChildren<QTcpServer *>(QString(), Qt::FindDirectChildrenOnly);
+    for (auto tcpServer : tcpServers)
+        tcpServer->close();
+
+    const auto connections = findChildren<QHttpServerConnection *>(QString(),
+                                                                  Qt::FindDirectChildrenOnly);
+    for (auto connection : connections) {
+        if (connection->socket)
+            connection->drain();
+    }
+    checkDrained();
+}
+
+/*!
+    \internal
+
+    Closes the connections a drain is still waiting for, dropping their
+    pending responses.
+*/
+void QHttpServerWorker::abortConnections()
+{
+    const auto connections = findChildren<QHttpServerConnection *>(QString(),
+                                                                  Qt::FindDirectChildrenOnly);
+    for (auto connection : connections) {
+        if (connection->socket)
+            connection->socket->abort();
+    }
+}
+
+QHttpServerConnection *QHttpServerWorker::acquireConnection()
+{
+    if (idleConnections.empty())
+        return new QHttpServerConnection(this);
+    auto connection = idleConnections.back();
+    idleConnections.pop_back();
+    return connection;
+}
+
+void QHttpServerWorker::checkDrained()
+{
+    if (drained || connectionCount.loadAcquire())
+        return;
+    drained = true;
+    auto server = this->server;
+    QMetaObject::invokeMethod(server->q_ptr, [server]() {
+        server->workerDrained();
+    }, Qt::QueuedConnection);
+}
+
+/*!
+    \internal
+
+    Schedules \a entry in the timer wheel of this worker to expire in
+    \a msecs milliseconds.
+*/
+void QHttpServerWorker::scheduleTimeout(QHttpServerTimerWheel::Entry *entry, int msecs)
+{
+    timerWheel.schedule(entry, msecs);
+    if (!timerWheelTimer.isActive())
+        timerWheelTimer.start(QHttpServerTimerWheel::Resolution, Qt::CoarseTimer, this);
+}
+
+void QHttpServerWorker::timerEvent(QTimerEvent *event)
+{
+    if (event->timerId() != timerWheelTimer.timerId()) {
+        QObject::timerEvent(event);
+        return;
+    }
+
+    timerWheel.advance();
+    if (timerWheel.isEmpty())
+        timerWheelTimer.stop();
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,104 @@
+/****************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtHttpServer module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QHTTPSERVERWORKER_P_H
+#define QHTTPSERVERWORKER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists for the convenience
+// of QHttpServer. This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+
+#include <QtHttpServer/qhttpserverconfiguration.h>
+#include <QtHttpServer/qhttpserverlisteneroptions.h>
+#include <private/qhttpservertimerwheel_p.h>
+
+#include <QtCore/qatomic.h>
+#include <QtCore/qbasictimer.h>
+#include <QtCore/qobject.h>
+
+#include <vector>
+
+QT_BEGIN_NAMESPACE
+
+class QAbstractHttpServerPrivate;
+class QHttpServerConnection;
+class QHttpServerHttp2Stream;
+class QTcpServer;
+class QTcpSocket;
+
+class QHttpServerWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit QHttpServerWorker(QAbstractHttpServerPrivate *server);
+    ~QHttpServerWorker() override;
+
+    QTcpServer *listen(qintptr socketDescriptor);
+    void acceptConnections(QTcpServer *tcpServer);
+    void handleConnection(QTcpSocket *socket, const QHttpServerListenerOptions &options,
+                          const QHostAddress &countedAddress);
+    void handleStream(QHttpServerHttp2Stream *stream);
+    void releaseConnection(QHttpServerConnection *connection);
+    void recycleConnection(QHttpServerConnection *connection);
+    void scheduleTimeout(QHttpServerTimerWheel::Entry *entry, int msecs);
+    void drain();
+    void abortConnections();
+
+    QAbstractHttpServerPrivate *const server;
+    QHttpServerConfiguration configuration;
+    std::vector<QHttpServerConnection *> idleConnections;
+    QHttpServerTimerWheel timerWheel;
+    QBasicTimer timerWheelTimer;
+    bool draining = false;
+    bool drained = false;
+
+    QAtomicInt connectionCount;
+    QAtomicInteger<quint64> acceptedConnections;
+    QAtomicInteger<quint64> handledRequests;
+    QAtomicInteger<quint64> readPauses;
+    QAtomicInt pausedConnections;
+
+protected:
+    void timerEvent(QTimerEvent *event) override;
+
+private:
+    QHttpServerConnection *acquireConnection();
+    void checkDrained();
+};
+
+QT_END_NAMESPACE
+
+#endif // QHTTPSERVERWORKER_P_H
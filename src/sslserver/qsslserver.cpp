@@ -30,6 +30,7 @@
 #include <private/qsslserver_p.h>
 
 #include <QtCore/qloggingcategory.h>
+#include <QtCore/qtimer.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -47,10 +48,35 @@ QSslServer::QSslServer(const QSslConfiguration &sslConfiguration,
     d->sslConfiguration = sslConfiguration;
 }
 
-QSslServer::~QSslServer() = default;
+QSslServer::~QSslServer()
+{
+    for (const auto &waiting : d->waiting)
+        QSslServerPrivate::closeDescriptor(waiting.handle);
+}
 
 void QSslServer::incomingConnection(qintptr handle)
 {
+    QElapsedTimer accepted;
+    accepted.start();
+    if (d->maxConcurrentHandshakes && d->handshaking >= d->maxConcurrentHandshakes) {
+        d->waiting.push_back({ handle, accepted });
+        d->queued.ref();
+        return;
+    }
+    startHandshake(handle, accepted);
+}
+
+void QSslServer::startHandshake(qintptr handle, const QElapsedTimer &accepted)
+{
+    auto handshakes = d->handshakes;
+    if (d->handshakeTimeout && accepted.hasExpired(d->handshakeTimeout)) {
+        // Waited for a slot for so long that its client likely gave up
+        QSslServerPrivate::closeDescriptor(handle);
+        handshakes->timedOut.ref();
+        handshakes->failed.ref();
+        return;
+    }
+
     QSslSocket *socket = new QSslSocket(this);
     connect(socket, QOverload<const QList<QSslError>&>::of(&QSslSocket::sslErrors),
             [this, socket](const QList<QSslError> &errors) {
@@ -59,14 +85,283 @@ void QSslServer::incomingConnection(qintptr handle)
         Q_EMIT sslErrors(socket, errors);
     });
     socket->setSocketDescriptor(handle);
-    socket->setSslConfiguration(d->sslConfiguration);
+
+    // The socket may have moved to another thread by the time its
+    // handshake is over, these run in whichever it is
+    handshakes->inProgress.ref();
+    auto finished = std::make_shared<bool>(false);
+    connect(socket, &QSslSocket::encrypted, [handshakes, accepted, finished]() {
+        if (*finished)
+            return;
+        *finished = true;
+        handshakes->finish(accepted.nsecsElapsed() / 1000);
+    });
+    const auto fail = [handshakes, finished]() {
+        if (*finished)
+            return;
+        *finished = true;
+        handshakes->failed.ref();
+        handshakes->inProgress.deref();
+    };
+    connect(socket, &QAbstractSocket::disconnected, fail);
+    connect(socket, &QObject::destroyed, fail);
+
+    if (d->handshakeTimeout) {
+        auto timer = new QTimer(socket);
+        timer->setSingleShot(true);
+        connect(timer, &QTimer::timeout, socket, [socket, handshakes]() {
+            qCWarning(lcSS) << "Handshake timed out with" << socket->peerAddress();
+            handshakes->timedOut.ref();
+            socket->abort();
+        });
+        connect(socket, &QSslSocket::encrypted, timer, &QObject::deleteLater);
+        timer->start(int(qMax<qint64>(0, d->handshakeTimeout - accepted.elapsed())));
+    }
+
+    auto cache = d->sessionCache.d;
+    const auto context = cache->context(d->sslConfiguration);
+    if (cache->lifetime.loadRelaxed()) {
+        // The context is shared, keep the sockets from caching their session in it
+        auto configuration = d->sslConfiguration;
+        configuration.setSslOption(QSsl::SslOptionDisableSessionSharing, true);
+        socket->setSslConfiguration(configuration);
+    } else {
+        socket->setSslConfiguration(d->sslConfiguration);
+    }
+    if (context)
+        QSslSocketPrivate::checkSettingSslContext(socket, context);
     socket->startServerEncryption();
+    if (!context)
+        cache->setContext(QSslSocketPrivate::sslContext(socket), d->sslConfiguration);
+
+    if (!d->maxConcurrentHandshakes) {
+        addPendingConnection(socket);
+        return;
+    }
+
+    // Handed over once encrypted, making room for the next handshake
+    ++d->handshaking;
+    connect(socket, &QSslSocket::encrypted, this, [this, socket]() {
+        disconnect(socket, nullptr, this, nullptr);
+        --d->handshaking;
+        addPendingConnection(socket);
+        Q_EMIT newConnection();
+        startWaitingHandshakes();
+    });
+    connect(socket, &QAbstractSocket::disconnected, this, [this, socket]() {
+        disconnect(socket, nullptr, this, nullptr);
+        --d->handshaking;
+        socket->deleteLater();
+        startWaitingHandshakes();
+    });
+}
 
-    addPendingConnection(socket);
+void QSslServer::startWaitingHandshakes()
+{
+    const bool pending = hasPendingConnections();
+    while (!d->waiting.empty()
+           && (!d->maxConcurrentHandshakes || d->handshaking < d->maxConcurrentHandshakes)) {
+        const auto next = d->waiting.front();
+        d->waiting.pop_front();
+        d->queued.deref();
+        startHandshake(next.handle, next.accepted);
+    }
+    // Without a limit anymore, the waiting ones skipped the wait for encrypted
+    if (!pending && hasPendingConnections())
+        Q_EMIT newConnection();
 }
 
+/*!
+    Sets the configuration of the connections this server accepts to
+    \a sslConfiguration. It applies from the next handshake on, the
+    connections established already keep theirs, so that a certificate
+    can be renewed while listening.
+
+    \sa sslConfiguration()
+*/
 void QSslServer::setSslConfiguration(const QSslConfiguration &sslConfiguration)
 {
     d->sslConfiguration = sslConfiguration;
 }
+
+/*!
+    Returns the configuration of the connections this server accepts.
+
+    \sa setSslConfiguration()
+*/
+QSslConfiguration QSslServer::sslConfiguration() const
+{
+    return d->sslConfiguration;
+}
+
+/*!
+    Shares \a cache with the other servers using it, letting returning
+    clients resume their TLS session on any of them.
+
+    Each server has a cache of its own by default, disabled until its
+    QSslServerSessionCache::lifetime() is set.
+
+    \sa sessionCache()
+*/
+void QSslServer::setSessionCache(const QSslServerSessionCache &cache)
+{
+    d->sessionCache = cache;
+}
+
+/*!
+    Returns the session cache of this server.
+
+    \sa setSessionCache()
+*/
+QSslServerSessionCache QSslServer::sessionCache() const
+{
+    return d->sessionCache;
+}
+
+/*!
+    Limits the TLS handshakes this server runs at once to \a count,
+    sparing the connections already established from a storm of new
+    ones, after a failover for instance. The connections accepted over
+    the limit wait for a handshake to finish before starting theirs, and
+    so do not use any CPU until then.
+
+    With a limit, the handshakes run in the thread of this server, and
+    connections become pending only once encrypted. A value of zero (the
+    default) puts no limit, connections are pending right away and their
+    handshake runs in whichever thread they are moved to.
+
+    The connections waiting are not bounded, set a handshakeTimeout() to
+    drop the ones whose client has likely given up already.
+
+    \sa setHandshakeTimeout(), handshakeStatistics()
+*/
+void QSslServer::setMaxConcurrentHandshakes(int count)
+{
+    d->maxConcurrentHandshakes = qMax(0, count);
+    startWaitingHandshakes();
+}
+
+/*!
+    Returns the number of TLS handshakes this server runs at once.
+
+    \sa setMaxConcurrentHandshakes()
+*/
+int QSslServer::maxConcurrentHandshakes() const
+{
+    return d->maxConcurrentHandshakes;
+}
+
+/*!
+    Aborts connections whose TLS handshake is not done within \a msecs of
+    being accepted, including the time spent waiting for
+    maxConcurrentHandshakes(). A value of zero (the default) lets
+    handshakes take as long as their peer wants.
+
+    \sa handshakeStatistics()
+*/
+void QSslServer::setHandshakeTimeout(int msecs)
+{
+    d->handshakeTimeout = qMax(0, msecs);
+}
+
+/*!
+    Returns the time TLS handshakes are given, in milliseconds.
+
+    \sa setHandshakeTimeout()
+*/
+int QSslServer::handshakeTimeout() const
+{
+    return d->handshakeTimeout;
+}
+
+/*!
+    Returns a snapshot of the handshake counters of this server. It may be
+    called from any thread.
+*/
+QSslServerHandshakeStatistics QSslServer::handshakeStatistics() const
+{
+    const auto &handshakes = *d->handshakes;
+    QSslServerHandshakeStatistics statistics;
+    statistics.completed = handshakes.completed.loadRelaxed();
+    statistics.failed = handshakes.failed.loadRelaxed();
+    statistics.timedOut = handshakes.timedOut.loadRelaxed();
+    statistics.inProgress = handshakes.inProgress.loadRelaxed();
+    statistics.queued = d->queued.loadRelaxed();
+    statistics.totalLatency = handshakes.totalLatency.loadRelaxed();
+    statistics.maxLatency = handshakes.maxLatency.loadRelaxed();
+    return statistics;
+}
+
+/*!
+    \class QSslServerHandshakeStatistics
+    \brief The QSslServerHandshakeStatistics struct holds the TLS handshake
+    counters of a QSslServer.
+
+    Latencies are in microseconds, from the moment the connection is
+    accepted until it is encrypted, so that they include the wait for
+    QSslServer::maxConcurrentHandshakes().
+*/
+
+/*!
+    \variable QSslServerHandshakeStatistics::completed
+    The number of handshakes that succeeded.
+*/
+
+/*!
+    \variable QSslServerHandshakeStatistics::failed
+    The number of connections that were closed before their handshake
+    succeeded, including the ones that timed out.
+*/
+
+/*!
+    \variable QSslServerHandshakeStatistics::timedOut
+    The number of connections aborted by QSslServer::handshakeTimeout().
+*/
+
+/*!
+    \variable QSslServerHandshakeStatistics::inProgress
+    The number of handshakes currently running.
+*/
+
+/*!
+    \variable QSslServerHandshakeStatistics::queued
+    The number of accepted connections currently waiting for a handshake
+    to finish, see QSslServer::maxConcurrentHandshakes().
+*/
+
+/*!
+    \variable QSslServerHandshakeStatistics::totalLatency
+    The sum of the latencies of the completed handshakes, for their
+    average.
+*/
+
+/*!
+    \variable QSslServerHandshakeStatistics::maxLatency
+    The latency of the slowest completed handshake.
+*/
+
+/*!
+    \internal
+*/
+void QSslServerHandshakes::finish(qint64 latency)
+{
+    completed.ref();
+    inProgress.deref();
+    totalLatency.fetchAndAddRelaxed(latency);
+    qint64 max = maxLatency.loadRelaxed();
+    while (latency > max && !maxLatency.testAndSetRelaxed(max, latency, max)) { }
+}
+
+/*!
+    \internal
+
+    Closes the accepted \a handle of a connection that never got a socket.
+*/
+void QSslServerPrivate::closeDescriptor(qintptr handle)
+{
+    QTcpSocket socket;
+    if (socket.setSocketDescriptor(handle))
+        socket.abort();
+}
+
 QT_END_NAMESPACE
@@ -31,6 +31,7 @@
 #define QSSLSERVER_H
 
 #include <QtSslServer/qtsslserverglobal.h>
+#include <QtSslServer/qsslserversessioncache.h>
 
 #include <QtNetwork/qtcpserver.h>
 #include <QtNetwork/qsslconfiguration.h>
@@ -39,6 +40,19 @@
 
 QT_BEGIN_NAMESPACE
 
+class QElapsedTimer;
+
+struct QSslServerHandshakeStatistics
+{
+    quint64 completed = 0;
+    quint64 failed = 0;
+    quint64 timedOut = 0;
+    int inProgress = 0;
+    int queued = 0;
+    qint64 totalLatency = 0;
+    qint64 maxLatency = 0;
+};
+
 class QSslServerPrivate;
 class Q_SSLSERVER_EXPORT QSslServer : public QTcpServer
 {
@@ -49,6 +63,18 @@ public:
     ~QSslServer();
 
     void setSslConfiguration(const QSslConfiguration &sslConfiguration);
+    QSslConfiguration sslConfiguration() const;
+
+    void setSessionCache(const QSslServerSessionCache &cache);
+    QSslServerSessionCache sessionCache() const;
+
+    void setMaxConcurrentHandshakes(int count);
+    int maxConcurrentHandshakes() const;
+
+    void setHandshakeTimeout(int msecs);
+    int handshakeTimeout() const;
+
+    QSslServerHandshakeStatistics handshakeStatistics() const;
 
 Q_SIGNALS:
     void sslErrors(QSslSocket *socket, const QList<QSslError> &errors);
@@ -57,6 +83,9 @@ protected:
     void incomingConnection(qintptr handle) override final;
 
 private:
+    void startHandshake(qintptr handle, const QElapsedTimer &accepted);
+    void startWaitingHandshakes();
+
     QScopedPointer<QSslServerPrivate> d;
 };
 
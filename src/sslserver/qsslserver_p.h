@@ -30,14 +30,93 @@
 #ifndef QSSLSERVER_P_H
 #define QSSLSERVER_P_H
 
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists for the convenience
+// of QSslServer. This header file may change from version to version
+// without notice, or even be removed.
+//
+// We mean it.
+
 #include <QtSslServer/qsslserver.h>
+#include <QtSslServer/qsslserversessioncache.h>
+
+#include <QtNetwork/private/qsslsocket_p.h>
+
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qmutex.h>
+
+#include <deque>
+#include <memory>
 
 QT_BEGIN_NAMESPACE
 
+class QThread;
+
+class QSslServerSessionCachePrivate : public QSharedData
+{
+public:
+    // std::shared_ptr in Qt 6, QSharedPointer in Qt 5
+    using ContextPointer = decltype(QSslSocketPrivate::sslContext(nullptr));
+
+    ContextPointer context(const QSslConfiguration &configuration);
+    void setContext(const ContextPointer &context, const QSslConfiguration &configuration);
+
+    QAtomicInt lifetime;
+    QAtomicInteger<quint64> hits;
+    QAtomicInteger<quint64> misses;
+
+    struct Entry
+    {
+        ContextPointer context;
+        QSslConfiguration configuration;
+        QElapsedTimer age;
+    };
+
+    // Shared by the servers of all the threads, see key()
+    QMutex mutex;
+    QHash<const QThread *, Entry> entries;
+    static const QThread *key(const QSslConfiguration &configuration);
+};
+
+// Outlives the server, for the sockets handed over to other threads
+class QSslServerHandshakes
+{
+public:
+    void finish(qint64 latency);
+
+    QAtomicInteger<quint64> completed;
+    QAtomicInteger<quint64> failed;
+    QAtomicInteger<quint64> timedOut;
+    QAtomicInt inProgress;
+    QAtomicInteger<qint64> totalLatency;
+    QAtomicInteger<qint64> maxLatency;
+};
+
 class QSslServerPrivate
 {
 public:
     QSslConfiguration sslConfiguration;
+    QSslServerSessionCache sessionCache;
+    int maxConcurrentHandshakes = 0;
+    int handshakeTimeout = 0;
+    std::shared_ptr<QSslServerHandshakes> handshakes = std::make_shared<QSslServerHandshakes>();
+
+    // Accepted descriptors waiting for a handshake slot, their TLS
+    // records left in the kernel buffers until then
+    struct Waiting
+    {
+        qintptr handle;
+        QElapsedTimer accepted;
+    };
+    std::deque<Waiting> waiting;
+    QAtomicInt queued;
+    int handshaking = 0;
+
+    static void closeDescriptor(qintptr handle);
 };
 
 QT_END_NAMESPACE
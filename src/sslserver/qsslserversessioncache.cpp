@@ -0,0 +1,219 @@
+/****************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtHttpServer module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <private/qsslserver_p.h>
+
+#include <QtCore/qthread.h>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \class QSslServerSessionCache
+    \brief The QSslServerSessionCache class lets returning clients of a
+    QSslServer resume their TLS session.
+
+    A QSslServer creates a new TLS context, with a session cache and a
+    session ticket key of its own, for every connection it accepts, so
+    that every client has to go through a full handshake. Once lifetime()
+    is set, the connections accepted by the servers sharing the cache share
+    their TLS context as well. A client coming back with the session ID or
+    the session ticket of an earlier connection can then resume its
+    session, skipping the certificate exchange and the key agreement, and
+    the certificate and key are not loaded for every connection anymore.
+
+    The cache is explicitly shared: copies refer to the same cache, so
+    that the servers of several threads can use one with
+    QSslServer::setSessionCache().
+
+    \code
+
+    QSslServerSessionCache cache;
+    cache.setLifetime(3600);
+
+    for (QSslServer *server : servers)
+        server->setSessionCache(cache);
+
+    \endcode
+
+    The TLS backend sizes the session cache and issues the session tickets.
+    The shared context, and with it the cache and the session ticket key,
+    is replaced by a new one after lifetime() or when the
+    QSslConfiguration of the server changes.
+
+    \note When the configuration allows protocols to be negotiated with
+    ALPN, the TLS backend does not support using one context from several
+    threads, and the context is shared by the connections of each thread
+    instead.
+*/
+
+/*!
+    Creates a session cache, disabled until setLifetime() is called.
+*/
+QSslServerSessionCache::QSslServerSessionCache() :
+    d(new QSslServerSessionCachePrivate)
+{
+}
+
+/*!
+    Creates a copy of \a other, referring to the same cache.
+*/
+QSslServerSessionCache::QSslServerSessionCache(const QSslServerSessionCache &other) = default;
+
+/*!
+    Makes this object refer to the same cache as \a other.
+*/
+QSslServerSessionCache &
+QSslServerSessionCache::operator=(const QSslServerSessionCache &other) = default;
+
+/*!
+    Destroys the session cache object.
+*/
+QSslServerSessionCache::~QSslServerSessionCache() = default;
+
+/*!
+    Returns the number of seconds a TLS context is shared.
+
+    \sa setLifetime()
+*/
+int QSslServerSessionCache::lifetime() const
+{
+    return d->lifetime.loadRelaxed();
+}
+
+/*!
+    Shares a TLS context among the accepted connections for \a seconds,
+    after which its sessions are dropped and its session ticket key
+    retired. The sessions established before cannot be resumed anymore
+    then, and the clients go through a full handshake once more.
+
+    A value of zero (the default) disables the cache, each connection
+    gets a context of its own.
+
+    The lifetime may be changed at any time, from any thread.
+*/
+void QSslServerSessionCache::setLifetime(int seconds)
+{
+    d->lifetime.storeRelaxed(qMax(0, seconds));
+}
+
+/*!
+    Returns the number of connections that were handed a TLS context from
+    the cache, able to resume the session of a returning client.
+
+    Whether a session is actually resumed depends on the client offering
+    one, which the TLS backend does not report.
+
+    \sa misses()
+*/
+quint64 QSslServerSessionCache::hits() const
+{
+    return d->hits.loadRelaxed();
+}
+
+/*!
+    Returns the number of connections that found no TLS context to share
+    in the cache, the first one and the ones after a rotation or a change
+    of configuration, and so had to go through a full handshake.
+
+    \sa hits()
+*/
+quint64 QSslServerSessionCache::misses() const
+{
+    return d->misses.loadRelaxed();
+}
+
+/*!
+    Drops the shared TLS contexts, with their sessions and session ticket
+    keys, as if their lifetime() had expired. The counters are kept.
+*/
+void QSslServerSessionCache::clear()
+{
+    QMutexLocker locker(&d->mutex);
+    d->entries.clear();
+}
+
+/*!
+    \internal
+
+    The context of an OpenSSL backend configures ALPN anew on each
+    connection it creates, which is not thread-safe, so those are kept
+    per thread.
+*/
+const QThread *QSslServerSessionCachePrivate::key(const QSslConfiguration &configuration)
+{
+    if (configuration.allowedNextProtocols().isEmpty())
+        return nullptr;
+    return QThread::currentThread();
+}
+
+/*!
+    \internal
+
+    Returns the context to share with a new connection on
+    \a configuration, or a null pointer if a new one is to be created.
+*/
+QSslServerSessionCachePrivate::ContextPointer
+QSslServerSessionCachePrivate::context(const QSslConfiguration &configuration)
+{
+    const qint64 msecs = qint64(lifetime.loadRelaxed()) * 1000;
+    if (!msecs)
+        return {};
+
+    QMutexLocker locker(&mutex);
+    const auto it = entries.constFind(key(configuration));
+    if (it == entries.cend() || it->age.hasExpired(msecs)
+            || it->configuration != configuration) {
+        misses.ref();
+        return {};
+    }
+    hits.ref();
+    return it->context;
+}
+
+/*!
+    \internal
+
+    Keeps \a context, created by a connection on \a configuration, for
+    the connections that follow.
+*/
+void QSslServerSessionCachePrivate::setContext(const ContextPointer &context,
+                                              const QSslConfiguration &configuration)
+{
+    // Backends without a context of their own have nothing to share
+    if (!context || !lifetime.loadRelaxed())
+        return;
+
+    QMutexLocker locker(&mutex);
+    auto &entry = entries[key(configuration)];
+    entry.context = context;
+    entry.configuration = configuration;
+    entry.age.start();
+}
+
+QT_END_NAMESPACE
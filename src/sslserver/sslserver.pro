@@ -1,14 +1,16 @@
 TARGET = QtSslServer
 INCLUDEPATH += .
 
-QT = network core
+QT = network-private core
 
 HEADERS += \
     qsslserver.h \
+    qsslserversessioncache.h \
     qtsslserverglobal.h \
     qsslserver_p.h
 
 SOURCES += \
-    qsslserver.cpp
+    qsslserver.cpp \
+    qsslserversessioncache.cpp
 
 load(qt_module)
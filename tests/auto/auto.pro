@@ -6,6 +6,8 @@ SUBDIRS = \
     cmake \
     qabstracthttpserver \
     qhttpserver \
+    qhttpserverbodydevice \
+    qhttpserverhpack \
     qhttpserverresponder \
     qhttpserverrouter \
     qhttpserverresponse
@@ -28,6 +28,9 @@
 ****************************************************************************/
 
 #include <QtHttpServer/qabstracthttpserver.h>
+#include <QtHttpServer/qhttpserverconfiguration.h>
+#include <QtHttpServer/qhttpserverlisteneroptions.h>
+#include <QtHttpServer/qhttpserverresponder.h>
 
 #if defined(QT_WEBSOCKETS_LIB)
 #  include <QtWebSockets/qwebsocket.h>
@@ -36,21 +39,95 @@
 #include <QtTest/qsignalspy.h>
 #include <QtTest/qtest.h>
 
+#include <QtCore/qabstracteventdispatcher.h>
+#include <QtCore/qdatetime.h>
+#include <QtCore/qendian.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qfiledevice.h>
+#include <QtCore/qmap.h>
+#include <QtCore/qmutex.h>
 #include <QtCore/qregularexpression.h>
+#include <QtCore/qset.h>
+#include <QtCore/qthread.h>
+#include <QtCore/qtemporarydir.h>
+#include <QtCore/qtimer.h>
 #include <QtCore/qurl.h>
+#include <QtNetwork/qlocalsocket.h>
 #include <QtNetwork/qnetworkaccessmanager.h>
 #include <QtNetwork/qnetworkreply.h>
 #include <QtNetwork/qnetworkrequest.h>
 #include <QtNetwork/qtcpserver.h>
 #include <QtHttpServer/qhttpserverrequest.h>
 
+#include <memory>
+#include <vector>
+
 #if defined(Q_OS_UNIX)
+#  include <netinet/in.h>
+#  include <netinet/tcp.h>
 #  include <signal.h>
+#  include <sys/socket.h>
 #  include <unistd.h>
 #endif
 
 QT_BEGIN_NAMESPACE
 
+namespace {
+
+// RFC 7540, section 6
+enum Http2FrameType : uchar {
+    DataFrame = 0x0,
+    HeadersFrame = 0x1,
+    RstStreamFrame = 0x3,
+    SettingsFrame = 0x4,
+    PingFrame = 0x6,
+    GoAwayFrame = 0x7,
+    WindowUpdateFrame = 0x8,
+    ContinuationFrame = 0x9
+};
+
+enum Http2FrameFlag : uchar {
+    EndStreamFlag = 0x1,
+    EndHeadersFlag = 0x4
+};
+
+struct Http2Frame
+{
+    uchar type = 0;
+    uchar flags = 0;
+    quint32 streamId = 0;
+    QByteArray payload;
+};
+
+QByteArray http2Frame(uchar type, uchar flags, quint32 streamId,
+                      const QByteArray &payload = QByteArray())
+{
+    char header[9];
+    qToBigEndian<quint32>(quint32(payload.size()) << 8 | type, header);
+    header[4] = char(flags);
+    qToBigEndian<quint32>(streamId, header + 5);
+    return QByteArray(header, 9) + payload;
+}
+
+// Takes the first complete frame out of the bytes \a received
+bool takeHttp2Frame(QByteArray *received, Http2Frame *frame)
+{
+    if (received->size() < 9)
+        return false;
+    const uchar *data = reinterpret_cast<const uchar *>(received->constData());
+    const int length = int(qFromBigEndian<quint32>(data) >> 8);
+    if (received->size() < 9 + length)
+        return false;
+    frame->type = data[3];
+    frame->flags = data[4];
+    frame->streamId = qFromBigEndian<quint32>(data + 5) & 0x7fffffff;
+    frame->payload = received->mid(9, length);
+    received->remove(0, 9 + length);
+    return true;
+}
+
+} // namespace
+
 class tst_QAbstractHttpServer : public QObject
 {
     Q_OBJECT
@@ -63,6 +140,30 @@ private slots:
     void servers();
     void fork();
     void qtbug82053();
+    void workerThreads();
+    void listenerSharding();
+    void epollEventBackend();
+    void listenerOptions();
+    void listenLocal_data();
+    void listenLocal();
+    void proxyProtocol_data();
+    void proxyProtocol();
+    void http2_data();
+    void http2();
+    void http2Upgrade();
+    void http2UpgradeIgnored_data();
+    void http2UpgradeIgnored();
+    void http2ConnectionContext();
+    void http2FrameErrors_data();
+    void http2FrameErrors();
+    void connectionReuse();
+    void timeouts();
+    void bodyMemoryThreshold();
+    void requestLimits_data();
+    void requestLimits();
+    void writeBufferWatermarks();
+    void drain();
+    void connectionLimits();
 };
 
 void tst_QAbstractHttpServer::request_data()
@@ -273,6 +374,1130 @@ void tst_QAbstractHttpServer::qtbug82053()
     QTRY_VERIFY(server.wasConnectRequest);
 }
 
+void tst_QAbstractHttpServer::workerThreads()
+{
+    struct HttpServer : QAbstractHttpServer
+    {
+        QMutex mutex;
+        QSet<QThread *> threads;
+        QAtomicInt requests;
+
+        bool handleRequest(const QHttpServerRequest &, QTcpSocket *socket) override
+        {
+            {
+                QMutexLocker locker(&mutex);
+                threads.insert(QThread::currentThread());
+            }
+            socket->write("HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n");
+            requests.ref();
+            return true;
+        }
+    } server;
+    QHttpServerConfiguration configuration;
+    configuration.setWorkerThreadCount(2);
+    server.setConfiguration(configuration);
+    QCOMPARE(server.configuration().workerThreadCount(), 2);
+    const auto port = server.listen(QHostAddress::LocalHost);
+    QVERIFY(port);
+
+    std::vector<std::unique_ptr<QTcpSocket>> clients;
+    for (int i = 0; i < 4; ++i) {
+        clients.emplace_back(new QTcpSocket);
+        clients.back()->connectToHost(QHostAddress::LocalHost, port);
+        QVERIFY(clients.back()->waitForConnected());
+        clients.back()->write("GET / HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    }
+    QTRY_COMPARE(server.requests.loadAcquire(), 4);
+
+    QMutexLocker locker(&server.mutex);
+    QCOMPARE(server.threads.size(), 2);
+    QVERIFY(!server.threads.contains(QThread::currentThread()));
+}
+
+void tst_QAbstractHttpServer::listenerSharding()
+{
+#if !defined(Q_OS_LINUX)
+    QSKIP("SO_REUSEPORT load balancing is only tested on Linux");
+#else
+    struct HttpServer : QAbstractHttpServer
+    {
+        bool handleRequest(const QHttpServerRequest &, QTcpSocket *socket) override
+        {
+            socket->write("HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n");
+            return true;
+        }
+    } server;
+    QHttpServerConfiguration configuration;
+    configuration.setWorkerThreadCount(2);
+    configuration.setListenerSharding(true);
+    server.setConfiguration(configuration);
+    const auto port = server.listen(QHostAddress::LocalHost);
+    QVERIFY(port);
+    QCOMPARE(server.serverPorts(), QVector<quint16>({ port, port }));
+
+    const int count = 8;
+    std::vector<std::unique_ptr<QTcpSocket>> clients;
+    for (int i = 0; i < count; ++i) {
+        clients.emplace_back(new QTcpSocket);
+        clients.back()->connectToHost(QHostAddress::LocalHost, port);
+        QVERIFY(clients.back()->waitForConnected());
+        clients.back()->write("GET / HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    }
+
+    const auto handledRequests = [&server]() {
+        quint64 sum = 0;
+        for (const auto &statistics : server.workerStatistics())
+            sum += statistics.handledRequests;
+        return sum;
+    };
+    QTRY_COMPARE(handledRequests(), quint64(count));
+    QCOMPARE(server.workerStatistics().size(), 2);
+#endif
+}
+
+void tst_QAbstractHttpServer::epollEventBackend()
+{
+#if !defined(Q_OS_LINUX)
+    QSKIP("The epoll event backend is only available on Linux");
+#else
+    struct HttpServer : QAbstractHttpServer
+    {
+        QMutex mutex;
+        QByteArray dispatcher;
+
+        bool handleRequest(const QHttpServerRequest &, QTcpSocket *socket) override
+        {
+            {
+                QMutexLocker locker(&mutex);
+                dispatcher = QThread::currentThread()->eventDispatcher()->metaObject()->className();
+            }
+            socket->write("HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n");
+            return true;
+        }
+    } server;
+    QHttpServerConfiguration configuration;
+    configuration.setWorkerThreadCount(1);
+    configuration.setListenerSharding(true);
+    configuration.setEventBackend(QHttpServerConfiguration::EventBackend::Epoll);
+    configuration.setKeepAliveTimeout(200);
+    server.setConfiguration(configuration);
+    const auto port = server.listen(QHostAddress::LocalHost);
+    QVERIFY(port);
+
+    QTcpSocket client;
+    client.connectToHost(QHostAddress::LocalHost, port);
+    QVERIFY(client.waitForConnected());
+    QByteArray response;
+    client.write("GET / HTTP/1.1\r\nHost: localhost\r\n\r\n"
+                 "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    QTRY_COMPARE((response += client.readAll()).count("HTTP/1.1 200"), 2);
+    {
+        QMutexLocker locker(&server.mutex);
+        QCOMPARE(server.dispatcher, QByteArray("QHttpServerEpollEventDispatcher"));
+    }
+
+    // The keep-alive timeout runs on the timers of the dispatcher
+    QTRY_COMPARE(client.state(), QAbstractSocket::UnconnectedState);
+#endif
+}
+
+void tst_QAbstractHttpServer::listenerOptions()
+{
+#if !defined(Q_OS_LINUX)
+    QSKIP("The listening socket options are only tested on Linux");
+#else
+    struct HttpServer : QAbstractHttpServer
+    {
+        QAtomicInt lowDelay = -1;
+
+        bool handleRequest(const QHttpServerRequest &, QTcpSocket *socket) override
+        {
+            lowDelay.storeRelease(socket->socketOption(QAbstractSocket::LowDelayOption).toInt());
+            socket->write("HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n");
+            return true;
+        }
+    } server;
+    QHttpServerListenerOptions options;
+    options.setNoDelay(true);
+    options.setBacklog(128);
+    options.setDeferAcceptTimeout(5);
+    QCOMPARE(options.deferAcceptTimeout(), 5);
+    const auto port = server.listen(QHostAddress::LocalHost, 0, options);
+    QVERIFY(port);
+
+    int deferAccept = 0;
+    socklen_t length = sizeof(deferAccept);
+    QVERIFY(::getsockopt(int(server.servers().first()->socketDescriptor()), IPPROTO_TCP,
+                         TCP_DEFER_ACCEPT, &deferAccept, &length) == 0);
+    QVERIFY(deferAccept > 0);
+
+    // Deferred accepts only wait for the first bytes of the request
+    QTcpSocket client;
+    client.connectToHost(QHostAddress::LocalHost, port);
+    QVERIFY(client.waitForConnected());
+    client.write("GET / HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    QByteArray response;
+    QTRY_VERIFY((response += client.readAll()).startsWith("HTTP/1.1 200"));
+    QCOMPARE(server.lowDelay.loadAcquire(), 1);
+#endif
+}
+
+void tst_QAbstractHttpServer::listenLocal_data()
+{
+    QTest::addColumn<bool>("abstract");
+    QTest::addColumn<int>("workerThreadCount");
+
+    QTest::addRow("path") << false << 0;
+    QTest::addRow("path, worker threads") << false << 2;
+#if defined(Q_OS_LINUX) && QT_VERSION >= QT_VERSION_CHECK(6, 2, 0)
+    QTest::addRow("abstract") << true << 0;
+#endif
+}
+
+void tst_QAbstractHttpServer::listenLocal()
+{
+#if !defined(Q_OS_UNIX)
+    QSKIP("Unix domain sockets are only supported on Unix");
+#else
+    QFETCH(bool, abstract);
+    QFETCH(int, workerThreadCount);
+
+    struct HttpServer : QAbstractHttpServer
+    {
+        QMutex mutex;
+        QHostAddress remoteAddress = QHostAddress::Any;
+
+        bool handleRequest(const QHttpServerRequest &request, QTcpSocket *socket) override
+        {
+            {
+                QMutexLocker locker(&mutex);
+                remoteAddress = request.remoteAddress();
+            }
+            makeResponder(request, socket).write(QByteArrayLiteral("local"), "text/plain");
+            return true;
+        }
+    };
+
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    QString name = directory.filePath(QStringLiteral("http.sock"));
+    if (abstract) {
+        name = QStringLiteral("@tst_qabstracthttpserver-%1-%2")
+                .arg(QCoreApplication::applicationPid()).arg(QDateTime::currentMSecsSinceEpoch());
+    }
+
+    {
+        HttpServer server;
+        QHttpServerConfiguration configuration;
+        configuration.setWorkerThreadCount(workerThreadCount);
+        configuration.setMaxConnectionsPerAddress(1);
+        server.setConfiguration(configuration);
+        QVERIFY(server.listenLocal(name));
+        QCOMPARE(server.serverPorts(), QVector<quint16>{ 0 });
+        QCOMPARE(QFile::exists(name), !abstract);
+
+        // QLocalSocket takes abstract names without the leading '@'
+        const QString serverName = abstract ? name.mid(1) : name;
+        QLocalSocket clients[2];
+        for (auto &client : clients) {
+#if QT_VERSION >= QT_VERSION_CHECK(6, 2, 0)
+            if (abstract)
+                client.setSocketOptions(QLocalSocket::AbstractNamespaceOption);
+#endif
+            client.connectToServer(serverName);
+            QVERIFY(client.waitForConnected());
+            client.write("GET / HTTP/1.1\r\nHost: localhost\r\n\r\n");
+        }
+
+        // The limit per address does not apply, the clients have none
+        for (auto &client : clients) {
+            QByteArray response;
+            QTRY_VERIFY((response += client.readAll()).endsWith("local"));
+            QVERIFY(response.startsWith("HTTP/1.1 200 OK"));
+        }
+        QMutexLocker locker(&server.mutex);
+        QVERIFY(server.remoteAddress.isNull());
+    }
+    QVERIFY(!QFile::exists(name));
+#endif
+}
+
+void tst_QAbstractHttpServer::proxyProtocol_data()
+{
+    QTest::addColumn<QByteArray>("header");
+    QTest::addColumn<QString>("address");
+    QTest::addColumn<int>("port");
+    QTest::addColumn<QByteArray>("authority");
+
+    const QByteArray signature("\r\n\r\n\0\r\nQUIT\n", 12);
+    QTest::addRow("v1, TCP4") << QByteArray("PROXY TCP4 192.0.2.1 198.51.100.1 56324 443\r\n")
+                              << QStringLiteral("192.0.2.1") << 56324 << QByteArray();
+    QTest::addRow("v1, TCP6") << QByteArray("PROXY TCP6 2001:db8::1 2001:db8::2 4000 443\r\n")
+                              << QStringLiteral("2001:db8::1") << 4000 << QByteArray();
+    QTest::addRow("v1, UNKNOWN") << QByteArray("PROXY UNKNOWN\r\n")
+                                 << QStringLiteral("127.0.0.1") << -1 << QByteArray();
+    QTest::addRow("v2, IPv4") << signature + QByteArray::fromHex("2111001a"
+                                                                 "c0000201" "c6336401"
+                                                                 "dc04" "01bb"
+                                                                 "02000b") + "example.com"
+                              << QStringLiteral("192.0.2.1") << 56324
+                              << QByteArray("example.com");
+    QTest::addRow("v2, IPv6") << signature + QByteArray::fromHex("21210024"
+                                                                 "20010db8000000000000000000000001"
+                                                                 "20010db8000000000000000000000002"
+                                                                 "0fa0" "01bb")
+                              << QStringLiteral("2001:db8::1") << 4000 << QByteArray();
+    QTest::addRow("v2, LOCAL") << signature + QByteArray::fromHex("20000000")
+                               << QStringLiteral("127.0.0.1") << -1 << QByteArray();
+    QTest::addRow("v2, UNSPEC") << signature + QByteArray::fromHex("21000000")
+                                << QStringLiteral("127.0.0.1") << -1 << QByteArray();
+    QTest::addRow("missing") << QByteArray() << QString() << 0 << QByteArray();
+    QTest::addRow("v1, bad address") << QByteArray("PROXY TCP4 2001:db8::1 ::1 1 2\r\n")
+                                     << QString() << 0 << QByteArray();
+    QTest::addRow("v2, bad version") << signature + QByteArray::fromHex("11110000")
+                                     << QString() << 0 << QByteArray();
+    QTest::addRow("v2, UDP") << signature + QByteArray::fromHex("2112000c"
+                                                                "c0000201" "c6336401"
+                                                                "dc04" "01bb")
+                             << QString() << 0 << QByteArray();
+    QTest::addRow("v2, IPv4 over UNSPEC") << signature + QByteArray::fromHex("2110000c"
+                                                                             "c0000201" "c6336401"
+                                                                             "dc04" "01bb")
+                                          << QString() << 0 << QByteArray();
+}
+
+void tst_QAbstractHttpServer::proxyProtocol()
+{
+    QFETCH(QByteArray, header);
+    QFETCH(QString, address);
+    QFETCH(int, port);
+    QFETCH(QByteArray, authority);
+
+    struct HttpServer : QAbstractHttpServer
+    {
+        QHostAddress remoteAddress;
+        quint16 remotePort = 0;
+        QByteArray authority;
+
+        bool handleRequest(const QHttpServerRequest &request, QTcpSocket *socket) override
+        {
+            remoteAddress = request.remoteAddress();
+            remotePort = request.remotePort();
+            authority = request.proxyProtocolTlv(0x02);
+            makeResponder(request, socket).write(QHttpServerResponder::StatusCode::Ok);
+            return true;
+        }
+    } server;
+    QHttpServerListenerOptions options;
+    options.setProxyProtocol(true);
+    const auto serverPort = server.listen(QHostAddress::LocalHost, 0, options);
+    QVERIFY(serverPort);
+
+    QTcpSocket client;
+    client.connectToHost(QHostAddress::LocalHost, serverPort);
+    QVERIFY(client.waitForConnected());
+    // The header may come in pieces, the request right behind it
+    if (!header.isEmpty()) {
+        client.write(header.left(5));
+        QVERIFY(client.waitForBytesWritten());
+        QTest::qWait(10);
+    }
+    client.write(header.mid(5) + "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n");
+
+    QByteArray response;
+    QTRY_VERIFY((response += client.readAll()).contains("\r\n\r\n"));
+    if (address.isEmpty()) {
+        QVERIFY(response.startsWith("HTTP/1.1 400"));
+        QTRY_COMPARE(client.state(), QAbstractSocket::UnconnectedState);
+        return;
+    }
+    QVERIFY(response.startsWith("HTTP/1.1 200"));
+    QCOMPARE(server.remoteAddress, QHostAddress(address));
+    QCOMPARE(server.remotePort, port == -1 ? client.localPort() : quint16(port));
+    QCOMPARE(server.authority, authority);
+}
+
+void tst_QAbstractHttpServer::http2_data()
+{
+    QTest::addColumn<int>("attribute");
+
+    QTest::addRow("prior knowledge") << int(QNetworkRequest::Http2DirectAttribute);
+#if QT_VERSION >= QT_VERSION_CHECK(6, 3, 0)
+    QTest::addRow("upgrade") << int(QNetworkRequest::Http2CleartextAllowedAttribute);
+#endif
+}
+
+void tst_QAbstractHttpServer::http2()
+{
+    QFETCH(int, attribute);
+
+    struct HttpServer : QAbstractHttpServer
+    {
+        bool handleRequest(const QHttpServerRequest &request, QTcpSocket *socket) override
+        {
+            const auto path = request.url().path().toUtf8();
+            const auto body = path == "/large" ? QByteArray(200000, 'x') : path;
+            makeResponder(request, socket).write(body, "text/plain");
+            return true;
+        }
+    } server;
+    QHttpServerConfiguration configuration;
+    configuration.setWorkerThreadCount(1);
+    configuration.setHttp2Enabled(true);
+    server.setConfiguration(configuration);
+    const auto port = server.listen(QHostAddress::LocalHost);
+    QVERIFY(port);
+
+    // The first request sets up the connection, the others share it. The
+    // large response goes beyond the initial flow control window.
+    QNetworkAccessManager networkAccessManager;
+    const QByteArray paths[] = { "/a", "/large", "/b", "/c" };
+    std::vector<std::unique_ptr<QNetworkReply>> replies;
+    for (const auto &path : paths) {
+        QNetworkRequest request(QUrl(QStringLiteral("http://127.0.0.1:%1%2")
+                                     .arg(port).arg(QString::fromUtf8(path))));
+        request.setAttribute(QNetworkRequest::Attribute(attribute), true);
+        replies.emplace_back(networkAccessManager.get(request));
+        if (replies.size() == 1)
+            QTRY_VERIFY(replies.front()->isFinished());
+    }
+    for (std::size_t i = 0; i < replies.size(); ++i) {
+        const auto reply = replies[i].get();
+        QTRY_VERIFY(reply->isFinished());
+        QCOMPARE(reply->error(), QNetworkReply::NoError);
+        QVERIFY(reply->attribute(QNetworkRequest::Http2WasUsedAttribute).toBool());
+        QCOMPARE(reply->readAll(), paths[i] == "/large" ? QByteArray(200000, 'x') : paths[i]);
+    }
+    QCOMPARE(server.workerStatistics().value(0).acceptedConnections, quint64(1));
+    QCOMPARE(server.workerStatistics().value(0).handledRequests, quint64(replies.size()));
+}
+
+void tst_QAbstractHttpServer::http2Upgrade()
+{
+    struct HttpServer : QAbstractHttpServer
+    {
+        bool handleRequest(const QHttpServerRequest &request, QTcpSocket *socket) override
+        {
+            makeResponder(request, socket).write(request.url().path().toUtf8(), "text/plain");
+            return true;
+        }
+    } server;
+    QHttpServerConfiguration configuration;
+    configuration.setWorkerThreadCount(1);
+    configuration.setHttp2Enabled(true);
+    server.setConfiguration(configuration);
+    const auto port = server.listen(QHostAddress::LocalHost);
+    QVERIFY(port);
+
+    QTcpSocket client;
+    client.connectToHost(QHostAddress::LocalHost, port);
+    QVERIFY(client.waitForConnected());
+    // SETTINGS_MAX_CONCURRENT_STREAMS of 100
+    client.write("GET /upgraded HTTP/1.1\r\n"
+                 "Host: localhost\r\n"
+                 "Connection: Upgrade, HTTP2-Settings\r\n"
+                 "Upgrade: h2c\r\n"
+                 "HTTP2-Settings: AAMAAABk\r\n"
+                 "\r\n");
+    QByteArray received;
+    QTRY_VERIFY((received += client.readAll()).contains("\r\n\r\n"));
+    QVERIFY(received.startsWith("HTTP/1.1 101"));
+    received.remove(0, received.indexOf("\r\n\r\n") + 4);
+
+    // The request which asked for the upgrade is answered on stream 1
+    client.write("PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n" + http2Frame(SettingsFrame, 0, 0));
+    QByteArray body;
+    bool headersSeen = false;
+    bool ended = false;
+    Http2Frame frame;
+    const auto readResponse = [&] {
+        received += client.readAll();
+        while (!ended && takeHttp2Frame(&received, &frame)) {
+            if (frame.type == GoAwayFrame || frame.type == RstStreamFrame)
+                return true;
+            if (frame.streamId != 1)
+                continue;
+            headersSeen = headersSeen || frame.type == HeadersFrame;
+            if (frame.type == DataFrame)
+                body += frame.payload;
+            ended = frame.flags & EndStreamFlag;
+        }
+        return ended;
+    };
+    QTRY_VERIFY(readResponse());
+    QVERIFY(frame.type != GoAwayFrame && frame.type != RstStreamFrame);
+    QVERIFY(headersSeen);
+    QCOMPARE(body, QByteArray("/upgraded"));
+}
+
+void tst_QAbstractHttpServer::http2UpgradeIgnored_data()
+{
+    QTest::addColumn<bool>("http2Enabled");
+    QTest::addColumn<QByteArray>("head");
+    QTest::addColumn<QByteArray>("body");
+    QTest::addColumn<QByteArray>("expected");
+
+    const QByteArray upgrade = "Host: localhost\r\n"
+                               "Connection: Upgrade, HTTP2-Settings\r\n"
+                               "Upgrade: h2c\r\n"
+                               "HTTP2-Settings: AAMAAABk\r\n";
+    QTest::addRow("body") << true << "POST /echo HTTP/1.1\r\n" + upgrade
+                                     + "Content-Length: 4\r\n\r\n"
+                          << QByteArray("body") << QByteArray("/echobody");
+    QTest::addRow("chunked body") << true << "POST /echo HTTP/1.1\r\n" + upgrade
+                                             + "Transfer-Encoding: chunked\r\n\r\n"
+                                  << QByteArray("4\r\nbody\r\n0\r\n\r\n")
+                                  << QByteArray("/echobody");
+    QTest::addRow("HTTP/2 disabled") << false << "GET /echo HTTP/1.1\r\n" + upgrade + "\r\n"
+                                     << QByteArray() << QByteArray("/echo");
+}
+
+void tst_QAbstractHttpServer::http2UpgradeIgnored()
+{
+    QFETCH(bool, http2Enabled);
+    QFETCH(QByteArray, head);
+    QFETCH(QByteArray, body);
+    QFETCH(QByteArray, expected);
+
+    struct HttpServer : QAbstractHttpServer
+    {
+        bool handleRequest(const QHttpServerRequest &request, QTcpSocket *socket) override
+        {
+            makeResponder(request, socket).write(request.url().path().toUtf8() + request.body(),
+                                                 "text/plain");
+            return true;
+        }
+    } server;
+    QHttpServerConfiguration configuration;
+    configuration.setWorkerThreadCount(1);
+    configuration.setHttp2Enabled(http2Enabled);
+    server.setConfiguration(configuration);
+    const auto port = server.listen(QHostAddress::LocalHost);
+    QVERIFY(port);
+
+    QTcpSocket client;
+    client.connectToHost(QHostAddress::LocalHost, port);
+    QVERIFY(client.waitForConnected());
+    // The body comes after the server saw the head
+    client.write(head);
+    QVERIFY(client.waitForBytesWritten());
+    QTest::qWait(50);
+    QCOMPARE(client.state(), QAbstractSocket::ConnectedState);
+    client.write(body);
+
+    // Served as HTTP/1.1, and so is the next request
+    QByteArray response;
+    QTRY_VERIFY((response += client.readAll()).endsWith(expected));
+    QVERIFY(response.startsWith("HTTP/1.1 200"));
+    response.clear();
+    client.write("GET /next HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    QTRY_VERIFY((response += client.readAll()).endsWith("/next"));
+    QVERIFY(response.startsWith("HTTP/1.1 200"));
+}
+
+void tst_QAbstractHttpServer::http2ConnectionContext()
+{
+    static int destroyed = 0;
+    struct Counter
+    {
+        ~Counter() { ++destroyed; }
+        int requests = 0;
+    };
+    struct HttpServer : QAbstractHttpServer
+    {
+        bool handleRequest(const QHttpServerRequest &request, QTcpSocket *socket) override
+        {
+            auto responder = makeResponder(request, socket);
+            const int requests = ++responder.connectionContext<Counter>()->requests;
+            responder.write(QByteArray::number(requests) + ' ' + request.proxyProtocolTlv(0x02),
+                            "text/plain");
+            return true;
+        }
+    } server;
+    QHttpServerConfiguration configuration;
+    configuration.setWorkerThreadCount(1);
+    configuration.setHttp2Enabled(true);
+    server.setConfiguration(configuration);
+    QHttpServerListenerOptions options;
+    options.setProxyProtocol(true);
+    const auto port = server.listen(QHostAddress::LocalHost, 0, options);
+    QVERIFY(port);
+
+    QTcpSocket client;
+    client.connectToHost(QHostAddress::LocalHost, port);
+    QVERIFY(client.waitForConnected());
+    // The streams share the objects and the PROXY protocol fields of the
+    // connection carrying them
+    const QByteArray proxyHeader = QByteArray("\r\n\r\n\0\r\nQUIT\n", 12)
+            + QByteArray::fromHex("2111001a" "c0000201" "c6336401" "dc04" "01bb" "02000b")
+            + "example.com";
+    const QByteArray block = QByteArray::fromHex("8286840109") + "localhost";
+    client.write(proxyHeader + "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n"
+                 + http2Frame(SettingsFrame, 0, 0)
+                 + http2Frame(HeadersFrame, EndHeadersFlag | EndStreamFlag, 1, block)
+                 + http2Frame(HeadersFrame, EndHeadersFlag | EndStreamFlag, 3, block));
+
+    QByteArray received;
+    QMap<quint32, QByteArray> bodies;
+    int ended = 0;
+    Http2Frame frame;
+    const auto readResponses = [&] {
+        received += client.readAll();
+        while (takeHttp2Frame(&received, &frame)) {
+            if (frame.type == GoAwayFrame || frame.type == RstStreamFrame)
+                return true;
+            if (frame.type == DataFrame)
+                bodies[frame.streamId] += frame.payload;
+            if ((frame.type == DataFrame || frame.type == HeadersFrame)
+                    && (frame.flags & EndStreamFlag)) {
+                ++ended;
+            }
+        }
+        return ended == 2;
+    };
+    QTRY_VERIFY(readResponses());
+    QCOMPARE(ended, 2);
+    QCOMPARE(bodies.value(1), QByteArray("1 example.com"));
+    QCOMPARE(bodies.value(3), QByteArray("2 example.com"));
+    QCOMPARE(destroyed, 0);
+
+    client.disconnectFromHost();
+    QTRY_COMPARE(destroyed, 1);
+}
+
+void tst_QAbstractHttpServer::http2FrameErrors_data()
+{
+    QTest::addColumn<QByteArray>("input");
+    QTest::addColumn<int>("frameType");
+    QTest::addColumn<quint32>("streamId");
+    QTest::addColumn<quint32>("errorCode");
+
+    const QByteArray preface("PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n");
+    const QByteArray start = preface + http2Frame(SettingsFrame, 0, 0);
+    // GET http://localhost/, the authority as a literal without indexing
+    const QByteArray block = QByteArray::fromHex("8286840109") + "localhost";
+    const QByteArray increment = QByteArray::fromHex("7fffffff");
+
+    // RFC 7540, section 3.5, the client sends the preface after the 101
+    QTest::addRow("bad preface after upgrade")
+        << QByteArray("GET / HTTP/1.1\r\n"
+                      "Host: localhost\r\n"
+                      "Connection: Upgrade, HTTP2-Settings\r\n"
+                      "Upgrade: h2c\r\n"
+                      "HTTP2-Settings: AAMAAABk\r\n"
+                      "\r\n"
+                      "PRI * HTTP/2.0\r\n\r\nXX\r\n\r\n")
+        << int(GoAwayFrame) << 0u << 0x1u;
+    QTest::addRow("no settings first")
+        << preface + http2Frame(PingFrame, 0, 0, QByteArray(8, '\0'))
+        << int(GoAwayFrame) << 0u << 0x1u;
+    // The length alone is refused, before the payload arrives
+    QTest::addRow("oversized frame")
+        << start + http2Frame(DataFrame, 0, 1, QByteArray(16385, 'x')).left(9)
+        << int(GoAwayFrame) << 0u << 0x6u;
+    QTest::addRow("connection window overflow")
+        << start + http2Frame(WindowUpdateFrame, 0, 0, increment)
+        << int(GoAwayFrame) << 0u << 0x3u;
+    QTest::addRow("stream window overflow")
+        << start + http2Frame(HeadersFrame, EndHeadersFlag, 1, block)
+                 + http2Frame(WindowUpdateFrame, 0, 1, increment)
+        << int(RstStreamFrame) << 1u << 0x3u;
+    QTest::addRow("headers interleaving a header block")
+        << start + http2Frame(HeadersFrame, 0, 1, block)
+                 + http2Frame(HeadersFrame, EndHeadersFlag | EndStreamFlag, 3, block)
+        << int(GoAwayFrame) << 0u << 0x1u;
+    QTest::addRow("continuation of another stream")
+        << start + http2Frame(HeadersFrame, 0, 1, block.left(3))
+                 + http2Frame(ContinuationFrame, EndHeadersFlag, 3, block.mid(3))
+        << int(GoAwayFrame) << 0u << 0x1u;
+    QTest::addRow("continuation without headers")
+        << start + http2Frame(ContinuationFrame, EndHeadersFlag, 1, block)
+        << int(GoAwayFrame) << 0u << 0x1u;
+    QTest::addRow("invalid header block")
+        << start + http2Frame(HeadersFrame, EndHeadersFlag | EndStreamFlag, 1,
+                              QByteArray::fromHex("80"))
+        << int(GoAwayFrame) << 0u << 0x9u;
+}
+
+void tst_QAbstractHttpServer::http2FrameErrors()
+{
+    QFETCH(QByteArray, input);
+    QFETCH(int, frameType);
+    QFETCH(quint32, streamId);
+    QFETCH(quint32, errorCode);
+
+    struct HttpServer : QAbstractHttpServer
+    {
+        bool handleRequest(const QHttpServerRequest &request, QTcpSocket *socket) override
+        {
+            makeResponder(request, socket).write(QHttpServerResponder::StatusCode::Ok);
+            return true;
+        }
+    } server;
+    QHttpServerConfiguration configuration;
+    configuration.setWorkerThreadCount(1);
+    configuration.setHttp2Enabled(true);
+    server.setConfiguration(configuration);
+    const auto port = server.listen(QHostAddress::LocalHost);
+    QVERIFY(port);
+
+    QTcpSocket client;
+    client.connectToHost(QHostAddress::LocalHost, port);
+    QVERIFY(client.waitForConnected());
+    client.write(input);
+
+    // The frames of the server up to the error are skipped
+    bool switched = !input.startsWith("GET ");
+    QByteArray received;
+    Http2Frame frame;
+    const auto readErrorFrame = [&] {
+        received += client.readAll();
+        if (!switched) {
+            const int end = received.indexOf("\r\n\r\n");
+            if (end < 0)
+                return false;
+            if (!received.startsWith("HTTP/1.1 101"))
+                return true;
+            received.remove(0, end + 4);
+            switched = true;
+        }
+        while (takeHttp2Frame(&received, &frame)) {
+            if (frame.type == GoAwayFrame || frame.type == RstStreamFrame)
+                return true;
+        }
+        return false;
+    };
+    QTRY_VERIFY(readErrorFrame());
+    QVERIFY(switched);
+    QCOMPARE(int(frame.type), frameType);
+    QCOMPARE(frame.streamId, streamId);
+    const int errorOffset = frame.type == GoAwayFrame ? 4 : 0;
+    QCOMPARE(frame.payload.size(), errorOffset + 4);
+    QCOMPARE(qFromBigEndian<quint32>(frame.payload.constData() + errorOffset), errorCode);
+    if (frame.type == GoAwayFrame)
+        QTRY_COMPARE(client.state(), QAbstractSocket::UnconnectedState);
+}
+
+void tst_QAbstractHttpServer::connectionReuse()
+{
+    struct HttpServer : QAbstractHttpServer
+    {
+        bool handleRequest(const QHttpServerRequest &request, QTcpSocket *socket) override
+        {
+            const auto path = request.url().path().toUtf8();
+            socket->write("HTTP/1.1 200 OK\r\nContent-Length: "
+                          + QByteArray::number(path.size()) + "\r\n\r\n" + path);
+            return true;
+        }
+    } server;
+    QHttpServerConfiguration configuration;
+    configuration.setWorkerThreadCount(1);
+    server.setConfiguration(configuration);
+    const auto port = server.listen(QHostAddress::LocalHost);
+    QVERIFY(port);
+
+    // Connections come and go, their recycled state must not leak into
+    // the requests of the next ones.
+    for (int i = 0; i < 3; ++i) {
+        const auto path = QByteArray("/") + QByteArray::number(i);
+        QTcpSocket client;
+        client.connectToHost(QHostAddress::LocalHost, port);
+        QVERIFY(client.waitForConnected());
+        client.write("GET " + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n");
+        QByteArray response;
+        while (!response.endsWith("\r\n\r\n" + path) && client.waitForReadyRead())
+            response += client.readAll();
+        QVERIFY(response.endsWith("\r\n\r\n" + path));
+        client.disconnectFromHost();
+        QTRY_COMPARE(server.workerStatistics().value(0).activeConnections, 0);
+    }
+    QCOMPARE(server.workerStatistics().value(0).acceptedConnections, quint64(3));
+    QCOMPARE(server.workerStatistics().value(0).handledRequests, quint64(3));
+}
+
+void tst_QAbstractHttpServer::timeouts()
+{
+    struct HttpServer : QAbstractHttpServer
+    {
+        bool handleRequest(const QHttpServerRequest &, QTcpSocket *socket) override
+        {
+            socket->write("HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n");
+            return true;
+        }
+    } server;
+    QHttpServerConfiguration configuration;
+    configuration.setKeepAliveTimeout(200);
+    configuration.setHeaderReadTimeout(200);
+    configuration.setMaxRequestsPerConnection(2);
+    server.setConfiguration(configuration);
+    const auto port = server.listen(QHostAddress::LocalHost);
+    QVERIFY(port);
+
+    const QByteArray request = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    {
+        // Idle after a response
+        QTcpSocket client;
+        client.connectToHost(QHostAddress::LocalHost, port);
+        QVERIFY(client.waitForConnected());
+        client.write(request);
+        QByteArray response;
+        QTRY_VERIFY((response += client.readAll()).startsWith("HTTP/1.1 200 OK"));
+        QTRY_COMPARE(client.state(), QAbstractSocket::UnconnectedState);
+    }
+    {
+        // Headers never completed
+        QTcpSocket client;
+        client.connectToHost(QHostAddress::LocalHost, port);
+        QVERIFY(client.waitForConnected());
+        client.write("GET / HTTP/1.1\r\nHost: local");
+        QByteArray response;
+        QTRY_VERIFY((response += client.readAll()).startsWith("HTTP/1.1 408"));
+        QTRY_COMPARE(client.state(), QAbstractSocket::UnconnectedState);
+    }
+    {
+        // Request limit
+        QTcpSocket client;
+        client.connectToHost(QHostAddress::LocalHost, port);
+        QVERIFY(client.waitForConnected());
+        QByteArray response;
+        client.write(request);
+        QTRY_VERIFY((response += client.readAll()).count("200 OK") == 1);
+        client.write(request);
+        QTRY_VERIFY((response += client.readAll()).count("200 OK") == 2);
+        QTRY_COMPARE_WITH_TIMEOUT(client.state(), QAbstractSocket::UnconnectedState, 150);
+    }
+}
+
+void tst_QAbstractHttpServer::bodyMemoryThreshold()
+{
+    struct HttpServer : QAbstractHttpServer
+    {
+        QByteArray body;
+        bool spilled = false;
+
+        bool handleRequest(const QHttpServerRequest &request, QTcpSocket *socket) override
+        {
+            body = request.body();
+            spilled = qobject_cast<QFileDevice *>(request.bodyDevice()) != nullptr;
+            socket->write("HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n");
+            return true;
+        }
+    } server;
+    QHttpServerConfiguration configuration;
+    configuration.setBodyMemoryThreshold(1024);
+    server.setConfiguration(configuration);
+    const auto port = server.listen(QHostAddress::LocalHost);
+    QVERIFY(port);
+
+    QByteArray body;
+    for (int i = 0; i < 10000; ++i)
+        body += QByteArray::number(i);
+
+    QTcpSocket client;
+    client.connectToHost(QHostAddress::LocalHost, port);
+    QVERIFY(client.waitForConnected());
+    client.write("POST / HTTP/1.1\r\nHost: localhost\r\nContent-Length: "
+                 + QByteArray::number(body.size()) + "\r\n\r\n" + body);
+    QTRY_COMPARE(server.body.size(), body.size());
+    QCOMPARE(server.body, body);
+    QVERIFY(server.spilled);
+
+    server.body.clear();
+    client.write("POST / HTTP/1.1\r\nHost: localhost\r\nContent-Length: 5\r\n\r\nsmall");
+    QTRY_COMPARE(server.body, QByteArray("small"));
+    QVERIFY(!server.spilled);
+}
+
+void tst_QAbstractHttpServer::requestLimits_data()
+{
+    QTest::addColumn<QByteArray>("request");
+    QTest::addColumn<QByteArray>("status");
+
+    QTest::addRow("within") << QByteArray("POST /x HTTP/1.1\r\nHost: localhost\r\n"
+                                          "Content-Length: 4\r\n\r\nbody")
+                            << QByteArray("200");
+    QTest::addRow("url") << "GET /" + QByteArray(64, 'x') + " HTTP/1.1\r\n\r\n"
+                         << QByteArray("414");
+    QTest::addRow("header-count") << QByteArray("GET / HTTP/1.1\r\na: 1\r\nb: 2\r\n"
+                                                "c: 3\r\nd: 4\r\n\r\n")
+                                  << QByteArray("431");
+    QTest::addRow("header-size") << "GET / HTTP/1.1\r\nCookie: " + QByteArray(200, 'x')
+                                    + "\r\n\r\n"
+                                 << QByteArray("431");
+    QTest::addRow("content-length") << QByteArray("POST / HTTP/1.1\r\nHost: localhost\r\n"
+                                                  "Content-Length: 17\r\n\r\n")
+                                    << QByteArray("413");
+    QTest::addRow("chunked") << "POST / HTTP/1.1\r\nHost: localhost\r\n"
+                                "Transfer-Encoding: chunked\r\n\r\n"
+                                "10\r\n" + QByteArray(16, 'x') + "\r\n"
+                                "10\r\n" + QByteArray(16, 'x') + "\r\n"
+                             << QByteArray("413");
+    QTest::addRow("garbage") << QByteArray("NOT HTTP\r\n\r\n") << QByteArray("400");
+}
+
+void tst_QAbstractHttpServer::requestLimits()
+{
+    QFETCH(QByteArray, request);
+    QFETCH(QByteArray, status);
+
+    struct HttpServer : QAbstractHttpServer
+    {
+        bool handleRequest(const QHttpServerRequest &, QTcpSocket *socket) override
+        {
+            socket->write("HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n");
+            return true;
+        }
+    } server;
+    QHttpServerConfiguration configuration;
+    configuration.setMaxUrlLength(32);
+    configuration.setMaxHeaderCount(3);
+    configuration.setMaxHeaderSize(128);
+    configuration.setMaxBodySize(16);
+    server.setConfiguration(configuration);
+    const auto port = server.listen(QHostAddress::LocalHost);
+    QVERIFY(port);
+
+    QTcpSocket client;
+    client.connectToHost(QHostAddress::LocalHost, port);
+    QVERIFY(client.waitForConnected());
+    client.write(request);
+    QByteArray response;
+    QTRY_VERIFY((response += client.readAll()).startsWith("HTTP/1.1 " + status));
+    if (status != "200")
+        QTRY_COMPARE(client.state(), QAbstractSocket::UnconnectedState);
+}
+
+
+void tst_QAbstractHttpServer::writeBufferWatermarks()
+{
+    struct HttpServer : QAbstractHttpServer
+    {
+        const QByteArray body = QByteArray(16 * 1024 * 1024, 'x');
+
+        bool handleRequest(const QHttpServerRequest &, QTcpSocket *socket) override
+        {
+            socket->write("HTTP/1.1 200 OK\r\nContent-Length: "
+                          + QByteArray::number(body.size()) + "\r\n\r\n" + body);
+            return true;
+        }
+    } server;
+    QHttpServerConfiguration configuration;
+    configuration.setWorkerThreadCount(1);
+    configuration.setWriteBufferHighWatermark(64 * 1024);
+    configuration.setWriteBufferLowWatermark(16 * 1024);
+    server.setConfiguration(configuration);
+    const auto port = server.listen(QHostAddress::LocalHost);
+    QVERIFY(port);
+
+    QTcpSocket client;
+    client.connectToHost(QHostAddress::LocalHost, port);
+    QVERIFY(client.waitForConnected());
+    // Do not read the responses, until the server stops reading requests
+    client.setReadBufferSize(1);
+    const QByteArray request = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    client.write(request + request + request);
+    QTRY_COMPARE(server.workerStatistics().value(0).pausedConnections, 1);
+    QCOMPARE(server.workerStatistics().value(0).handledRequests, quint64(1));
+
+    client.setReadBufferSize(0);
+    qint64 received = 0;
+    const qint64 expected = 3 * server.body.size();
+    QTRY_VERIFY_WITH_TIMEOUT((received += client.readAll().size()) > expected, 20000);
+    QTRY_COMPARE(server.workerStatistics().value(0).handledRequests, quint64(3));
+    QCOMPARE(server.workerStatistics().value(0).pausedConnections, 0);
+    QVERIFY(server.workerStatistics().value(0).readPauses >= 1);
+}
+
+
+void tst_QAbstractHttpServer::drain()
+{
+    struct HttpServer : QAbstractHttpServer
+    {
+        bool handleRequest(const QHttpServerRequest &request, QTcpSocket *socket) override
+        {
+            if (request.url().path() == QLatin1String("/slow")) {
+                auto responder = std::make_shared<QHttpServerResponder>(
+                            makeResponder(request, socket));
+                QTimer::singleShot(200, socket, [responder]() {
+                    responder->write(QByteArray("slow"), "text/plain");
+                });
+                return true;
+            }
+            socket->write("HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n");
+            return true;
+        }
+    } server;
+    const auto port = server.listen(QHostAddress::LocalHost);
+    QVERIFY(port);
+
+    QTcpSocket idle;
+    idle.connectToHost(QHostAddress::LocalHost, port);
+    QVERIFY(idle.waitForConnected());
+    idle.write("GET / HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    QByteArray idleResponse;
+    QTRY_VERIFY((idleResponse += idle.readAll()).startsWith("HTTP/1.1 200"));
+
+    QTcpSocket busy;
+    busy.connectToHost(QHostAddress::LocalHost, port);
+    QVERIFY(busy.waitForConnected());
+    busy.write("GET /slow HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    QTest::qWait(50);
+
+    QSignalSpy drainedSpy(&server, &QAbstractHttpServer::drained);
+    server.drain();
+    QVERIFY(server.isDraining());
+    QTRY_COMPARE(idle.state(), QAbstractSocket::UnconnectedState);
+    QCOMPARE(drainedSpy.count(), 0);
+
+    QByteArray busyResponse;
+    QTRY_VERIFY((busyResponse += busy.readAll()).endsWith("slow"));
+    QVERIFY(busyResponse.contains("Connection: close\r\n"));
+    QTRY_COMPARE(busy.state(), QAbstractSocket::UnconnectedState);
+    QTRY_COMPARE(drainedSpy.count(), 1);
+
+    QTcpSocket late;
+    late.connectToHost(QHostAddress::LocalHost, port);
+    QVERIFY(!late.waitForConnected(1000));
+
+    // No new listeners either
+    const QRegularExpression drained(QStringLiteral("The server was drained"));
+    QTest::ignoreMessage(QtWarningMsg, drained);
+    QCOMPARE(server.listen(QHostAddress::LocalHost), quint16(0));
+#if defined(Q_OS_UNIX)
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    QTest::ignoreMessage(QtWarningMsg, drained);
+    QVERIFY(!server.listenLocal(directory.filePath(QStringLiteral("drained.sock"))));
+#endif
+    auto tcpServer = new QTcpServer;
+    QVERIFY(tcpServer->listen(QHostAddress::LocalHost));
+    QTest::ignoreMessage(QtWarningMsg, drained);
+    server.bind(tcpServer);
+    QVERIFY(!tcpServer->isListening());
+}
+
+
+void tst_QAbstractHttpServer::connectionLimits()
+{
+    struct HttpServer : QAbstractHttpServer
+    {
+        bool handleRequest(const QHttpServerRequest &, QTcpSocket *socket) override
+        {
+            socket->write("HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n");
+            return true;
+        }
+    };
+    const QByteArray request = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    const auto openConnection = [&request](quint16 port) {
+        std::unique_ptr<QTcpSocket> client(new QTcpSocket);
+        client->connectToHost(QHostAddress::LocalHost, port);
+        client->waitForConnected();
+        client->write(request);
+        return client;
+    };
+    const auto readResponse = [](QTcpSocket *client) {
+        QByteArray response;
+        QTest::qWaitFor([&]() {
+            return (response += client->readAll()).endsWith("\r\n\r\n");
+        }, 1000);
+        return response;
+    };
+
+    {
+        // Rejecting over the global limit
+        HttpServer server;
+        QHttpServerConfiguration configuration;
+        configuration.setMaxConnections(2);
+        configuration.setOverloadPolicy(QHttpServerConfiguration::OverloadPolicy::RejectConnections);
+        configuration.setRetryAfter(3);
+        server.setConfiguration(configuration);
+        const auto port = server.listen(QHostAddress::LocalHost);
+        QVERIFY(port);
+
+        auto first = openConnection(port);
+        QVERIFY(readResponse(first.get()).startsWith("HTTP/1.1 200"));
+        auto second = openConnection(port);
+        QVERIFY(readResponse(second.get()).startsWith("HTTP/1.1 200"));
+        auto third = openConnection(port);
+        const auto rejected = readResponse(third.get());
+        QVERIFY(rejected.startsWith("HTTP/1.1 503"));
+        QVERIFY(rejected.contains("Retry-After: 3\r\n"));
+        QTRY_COMPARE(third->state(), QAbstractSocket::UnconnectedState);
+
+        first->disconnectFromHost();
+        QTest::qWait(100);
+        auto fourth = openConnection(port);
+        QVERIFY(readResponse(fourth.get()).startsWith("HTTP/1.1 200"));
+    }
+    {
+        // Pausing over the global limit
+        HttpServer server;
+        QHttpServerConfiguration configuration;
+        configuration.setMaxConnections(1);
+        server.setConfiguration(configuration);
+        const auto port = server.listen(QHostAddress::LocalHost);
+        QVERIFY(port);
+
+        auto first = openConnection(port);
+        QVERIFY(readResponse(first.get()).startsWith("HTTP/1.1 200"));
+        auto second = openConnection(port);
+        QVERIFY(readResponse(second.get()).isEmpty());
+        first->disconnectFromHost();
+        QTRY_VERIFY(second->readAll().startsWith("HTTP/1.1 200"));
+    }
+    {
+        // Rejecting over the limit per address, whatever the policy
+        HttpServer server;
+        QHttpServerConfiguration configuration;
+        configuration.setMaxConnectionsPerAddress(1);
+        server.setConfiguration(configuration);
+        const auto port = server.listen(QHostAddress::LocalHost);
+        QVERIFY(port);
+
+        auto first = openConnection(port);
+        QVERIFY(readResponse(first.get()).startsWith("HTTP/1.1 200"));
+        auto second = openConnection(port);
+        QVERIFY(readResponse(second.get()).startsWith("HTTP/1.1 503"));
+    }
+    {
+        // Resuming once the limits are gone
+        HttpServer server;
+        QHttpServerConfiguration configuration;
+        configuration.setMaxConnections(1);
+        server.setConfiguration(configuration);
+        const auto port = server.listen(QHostAddress::LocalHost);
+        QVERIFY(port);
+
+        auto first = openConnection(port);
+        QVERIFY(readResponse(first.get()).startsWith("HTTP/1.1 200"));
+        auto second = openConnection(port);
+        QVERIFY(readResponse(second.get()).isEmpty());
+        server.setConfiguration(QHttpServerConfiguration());
+        first->disconnectFromHost();
+        QTRY_VERIFY(second->readAll().startsWith("HTTP/1.1 200"));
+    }
+    {
+        // Releasing connections counted per address before the limit went away
+        HttpServer server;
+        QHttpServerConfiguration configuration;
+        configuration.setMaxConnectionsPerAddress(1);
+        server.setConfiguration(configuration);
+        const auto port = server.listen(QHostAddress::LocalHost);
+        QVERIFY(port);
+
+        auto first = openConnection(port);
+        QVERIFY(readResponse(first.get()).startsWith("HTTP/1.1 200"));
+        server.setConfiguration(QHttpServerConfiguration());
+        first->disconnectFromHost();
+        QTest::qWait(100);
+        server.setConfiguration(configuration);
+        auto second = openConnection(port);
+        QVERIFY(readResponse(second.get()).startsWith("HTTP/1.1 200"));
+        auto third = openConnection(port);
+        QVERIFY(readResponse(third.get()).startsWith("HTTP/1.1 503"));
+    }
+}
+
 QT_END_NAMESPACE
 
 QTEST_MAIN(tst_QAbstractHttpServer)
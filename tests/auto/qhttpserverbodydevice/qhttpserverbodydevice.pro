@@ -0,0 +1,5 @@
+CONFIG += testcase
+TARGET = tst_qhttpserverbodydevice
+SOURCES  += tst_qhttpserverbodydevice.cpp
+
+QT = httpserver httpserver-private testlib
@@ -0,0 +1,137 @@
+/****************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtHttpServer module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <private/qhttpserverbodydevice_p.h>
+
+#include <QtTest/qsignalspy.h>
+#include <QtTest/qtest.h>
+
+QT_BEGIN_NAMESPACE
+
+class tst_QHttpServerBodyDevice : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void notify();
+    void smallReads_data();
+    void smallReads();
+};
+
+void tst_QHttpServerBodyDevice::notify()
+{
+    QHttpServerBodyDevice device;
+    QSignalSpy readyRead(&device, &QIODevice::readyRead);
+    QSignalSpy readChannelFinished(&device, &QIODevice::readChannelFinished);
+
+    device.append("body", 4);
+    device.append("", 0);
+    QCOMPARE(readyRead.count(), 0);
+    device.notify();
+    QCOMPARE(readyRead.count(), 1);
+    device.notify();
+    QCOMPARE(readyRead.count(), 1);
+
+    QCOMPARE(device.read(2), QByteArray("bo"));
+    device.finish();
+    QVERIFY(!device.atEnd());
+    device.notify();
+    QCOMPARE(readyRead.count(), 1);
+    QCOMPARE(readChannelFinished.count(), 1);
+    QCOMPARE(device.readAll(), QByteArray("dy"));
+    QVERIFY(device.atEnd());
+}
+
+void tst_QHttpServerBodyDevice::smallReads_data()
+{
+    QTest::addColumn<int>("appendSize");
+    QTest::addColumn<int>("readSize");
+
+    QTest::addRow("reads smaller than appends") << 4096 << 1000;
+    QTest::addRow("reads larger than appends") << 1000 << 4096;
+    QTest::addRow("single bytes") << 16 * 1024 << 1;
+}
+
+void tst_QHttpServerBodyDevice::smallReads()
+{
+    QFETCH(int, appendSize);
+    QFETCH(int, readSize);
+
+    // Like the server does, fill the device until it is full, and only
+    // resume once the reader drained it. The reader never empties it.
+    constexpr qint64 BodySize = 1024 * 1024;
+    QHttpServerBodyDevice device;
+    bool paused = false;
+    int drained = 0;
+    device.drained = [&]() {
+        paused = false;
+        ++drained;
+    };
+
+    QByteArray chunk(appendSize, Qt::Uninitialized);
+    qint64 appended = 0;
+    qint64 read = 0;
+    qint64 maxBufferSize = 0;
+    char expected = 0;
+    while (read < BodySize) {
+        while (!paused && appended < BodySize) {
+            const int size = int(qMin<qint64>(appendSize, BodySize - appended));
+            for (int i = 0; i < size; ++i)
+                chunk[i] = char((appended + i) % 251);
+            device.append(chunk.constData(), size);
+            appended += size;
+            paused = device.isFull();
+            maxBufferSize = qMax(maxBufferSize, device.bufferSize());
+        }
+        if (appended == BodySize && !device.isFinished())
+            device.finish();
+
+        const QByteArray data = device.read(readSize);
+        QVERIFY(!data.isEmpty());
+        for (char c : data) {
+            QCOMPARE(c, expected);
+            expected = char((read + 1) % 251);
+            ++read;
+        }
+    }
+    QCOMPARE(read, BodySize);
+    QVERIFY(device.atEnd());
+    QVERIFY(drained > 0);
+
+    // What was read is dropped along the way instead of piling up
+    QVERIFY2(maxBufferSize < QHttpServerBodyDevice::HighWatermark
+                             + QHttpServerBodyDevice::LowWatermark + appendSize,
+             QByteArray::number(maxBufferSize).constData());
+}
+
+QT_END_NAMESPACE
+
+QTEST_MAIN(tst_QHttpServerBodyDevice)
+
+#include "tst_qhttpserverbodydevice.moc"
@@ -0,0 +1,5 @@
+CONFIG += testcase
+TARGET = tst_qhttpserverhpack
+SOURCES  += tst_qhttpserverhpack.cpp
+
+QT = httpserver httpserver-private testlib
@@ -0,0 +1,277 @@
+/****************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtHttpServer module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtHttpServer/qhttpserverresponder.h>
+
+#include <private/qhttpserverhpack_p.h>
+
+#include <QtTest/qtest.h>
+
+using QHttpServerHpack::Decoder;
+using QHttpServerHpack::HeaderList;
+
+using HeaderLists = QVector<HeaderList>;
+Q_DECLARE_METATYPE(HeaderList);
+Q_DECLARE_METATYPE(HeaderLists);
+
+QT_BEGIN_NAMESPACE
+
+namespace {
+
+QHttpServerHpack::Header header(const char *name, const char *value)
+{
+    return qMakePair(QByteArray(name), QByteArray(value));
+}
+
+Decoder::Result decodeHex(Decoder *decoder, const QByteArray &hex, HeaderList *headers,
+                          int maxListSize = 0)
+{
+    const QByteArray block = QByteArray::fromHex(hex);
+    headers->clear();
+    return decoder->decode(reinterpret_cast<const uchar *>(block.constData()), block.size(),
+                           maxListSize, headers);
+}
+
+} // namespace
+
+class tst_QHttpServerHpack : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void decode_data();
+    void decode();
+    void errors_data();
+    void errors();
+    void tooLarge();
+    void encode_data();
+    void encode();
+};
+
+void tst_QHttpServerHpack::decode_data()
+{
+    QTest::addColumn<quint32>("maxTableSize");
+    QTest::addColumn<QByteArrayList>("blocks");
+    QTest::addColumn<HeaderLists>("expected");
+    // The dynamic table afterwards, newest entry first
+    QTest::addColumn<HeaderList>("table");
+
+    // RFC 7541, appendix C
+    QTest::addRow("C.2.1 literal with indexing") << 4096u
+        << QByteArrayList{ "400a637573746f6d2d6b65790d637573746f6d2d686561646572" }
+        << HeaderLists{ { header("custom-key", "custom-header") } }
+        << HeaderList{ header("custom-key", "custom-header") };
+
+    QTest::addRow("C.2.2 literal without indexing") << 4096u
+        << QByteArrayList{ "040c2f73616d706c652f70617468" }
+        << HeaderLists{ { header(":path", "/sample/path") } }
+        << HeaderList{};
+
+    QTest::addRow("C.2.3 literal never indexed") << 4096u
+        << QByteArrayList{ "100870617373776f726406736563726574" }
+        << HeaderLists{ { header("password", "secret") } }
+        << HeaderList{};
+
+    QTest::addRow("C.2.4 indexed") << 4096u
+        << QByteArrayList{ "82" }
+        << HeaderLists{ { header(":method", "GET") } }
+        << HeaderList{};
+
+    const HeaderLists requests = {
+        { header(":method", "GET"), header(":scheme", "http"), header(":path", "/"),
+          header(":authority", "www.example.com") },
+        { header(":method", "GET"), header(":scheme", "http"), header(":path", "/"),
+          header(":authority", "www.example.com"), header("cache-control", "no-cache") },
+        { header(":method", "GET"), header(":scheme", "https"), header(":path", "/index.html"),
+          header(":authority", "www.example.com"), header("custom-key", "custom-value") }
+    };
+    const HeaderList requestTable = {
+        header("custom-key", "custom-value"), header("cache-control", "no-cache"),
+        header(":authority", "www.example.com")
+    };
+
+    QTest::addRow("C.3 requests") << 4096u
+        << QByteArrayList{ "828684410f7777772e6578616d706c652e636f6d",
+                           "828684be58086e6f2d6361636865",
+                           "828785bf400a637573746f6d2d6b65790c637573746f6d2d76616c7565" }
+        << requests << requestTable;
+
+    QTest::addRow("C.4 requests, Huffman") << 4096u
+        << QByteArrayList{ "828684418cf1e3c2e5f23a6ba0ab90f4ff",
+                           "828684be5886a8eb10649cbf",
+                           "828785bf408825a849e95ba97d7f8925a849e95bb8e8b4bf" }
+        << requests << requestTable;
+
+    // The table of 256 bytes evicts entries along the way
+    const HeaderLists responses = {
+        { header(":status", "302"), header("cache-control", "private"),
+          header("date", "Mon, 21 Oct 2013 20:13:21 GMT"),
+          header("location", "https://www.example.com") },
+        { header(":status", "307"), header("cache-control", "private"),
+          header("date", "Mon, 21 Oct 2013 20:13:21 GMT"),
+          header("location", "https://www.example.com") },
+        { header(":status", "200"), header("cache-control", "private"),
+          header("date", "Mon, 21 Oct 2013 20:13:22 GMT"),
+          header("location", "https://www.example.com"), header("content-encoding", "gzip"),
+          header("set-cookie", "foo=ASDJKHQKBZXOQWEOPIUAXQWEOIU; max-age=3600; version=1") }
+    };
+    const HeaderList responseTable = {
+        header("set-cookie", "foo=ASDJKHQKBZXOQWEOPIUAXQWEOIU; max-age=3600; version=1"),
+        header("content-encoding", "gzip"), header("date", "Mon, 21 Oct 2013 20:13:22 GMT")
+    };
+
+    QTest::addRow("C.5 responses") << 256u
+        << QByteArrayList{ "4803333032580770726976617465611d4d6f6e2c203231204f637420323031"
+                           "332032303a31333a323120474d546e1768747470733a2f2f7777772e657861"
+                           "6d706c652e636f6d",
+                           "4803333037c1c0bf",
+                           "88c1611d4d6f6e2c203231204f637420323031332032303a31333a32322047"
+                           "4d54c05a04677a69707738666f6f3d4153444a4b48514b425a584f5157454f"
+                           "50495541585157454f49553b206d61782d6167653d333630303b2076657273"
+                           "696f6e3d31" }
+        << responses << responseTable;
+
+    QTest::addRow("C.6 responses, Huffman") << 256u
+        << QByteArrayList{ "488264025885aec3771a4b6196d07abe941054d444a8200595040b8166e082"
+                           "a62d1bff6e919d29ad171863c78f0b97c8e9ae82ae43d3",
+                           "4883640effc1c0bf",
+                           "88c16196d07abe941054d444a8200595040b8166e084a62d1bffc05a839bd9"
+                           "ab77ad94e7821dd7f2e6c7b335dfdfcd5b3960d5af27087f3672c1ab270fb5"
+                           "291f9587316065c003ed4ee5b1063d5007" }
+        << responses << responseTable;
+
+    // A size update at the start of a block, before any field
+    QTest::addRow("table size update") << 4096u
+        << QByteArrayList{ "400a637573746f6d2d6b65790d637573746f6d2d686561646572", "2082" }
+        << HeaderLists{ { header("custom-key", "custom-header") }, { header(":method", "GET") } }
+        << HeaderList{};
+
+    QTest::addRow("table size update to the limit") << 4096u
+        << QByteArrayList{ "3fe11f82" }
+        << HeaderLists{ { header(":method", "GET") } }
+        << HeaderList{};
+}
+
+void tst_QHttpServerHpack::decode()
+{
+    QFETCH(quint32, maxTableSize);
+    QFETCH(QByteArrayList, blocks);
+    QFETCH(HeaderLists, expected);
+    QFETCH(HeaderList, table);
+
+    Decoder decoder(maxTableSize);
+    HeaderList headers;
+    for (int i = 0; i < blocks.size(); ++i) {
+        QCOMPARE(decodeHex(&decoder, blocks.at(i), &headers), Decoder::Result::Ok);
+        QCOMPARE(headers, expected.at(i));
+    }
+
+    // The dynamic table starts at index 62, the entries past it are gone
+    for (int i = 0; i < table.size(); ++i) {
+        const QByteArray index = QByteArray::number(0x80 | (62 + i), 16);
+        QCOMPARE(decodeHex(&decoder, index, &headers), Decoder::Result::Ok);
+        QCOMPARE(headers, HeaderList{ table.at(i) });
+    }
+    const QByteArray pastTable = QByteArray::number(0x80 | (62 + table.size()), 16);
+    QCOMPARE(decodeHex(&decoder, pastTable, &headers), Decoder::Result::Error);
+}
+
+void tst_QHttpServerHpack::errors_data()
+{
+    QTest::addColumn<QByteArray>("block");
+
+    QTest::addRow("index zero") << QByteArray("80");
+    QTest::addRow("index past the tables") << QByteArray("be");
+    QTest::addRow("truncated integer") << QByteArray("ff");
+    QTest::addRow("integer overflow") << QByteArray("ffffffffff0f");
+    QTest::addRow("integer too long") << QByteArray("ffffffffffff00");
+    QTest::addRow("string past the block") << QByteArray("0001610561626364");
+    // Huffman strings
+    QTest::addRow("EOS") << QByteArray("0084ffffffff0161");
+    QTest::addRow("padding longer than 7 bits") << QByteArray("00821fff0161");
+    QTest::addRow("padding not of ones") << QByteArray("0081180161");
+    // Table size updates
+    QTest::addRow("size update after a field") << QByteArray("8220");
+    QTest::addRow("size update over the limit") << QByteArray("3fe21f");
+}
+
+void tst_QHttpServerHpack::errors()
+{
+    QFETCH(QByteArray, block);
+
+    Decoder decoder;
+    HeaderList headers;
+    QCOMPARE(decodeHex(&decoder, block, &headers), Decoder::Result::Error);
+}
+
+void tst_QHttpServerHpack::tooLarge()
+{
+    Decoder decoder;
+    HeaderList headers;
+    QCOMPARE(decodeHex(&decoder, "828684410f7777772e6578616d706c652e636f6d", &headers, 50),
+             Decoder::Result::TooLarge);
+    QVERIFY(headers.isEmpty());
+
+    // The block was still decoded, the table stays in sync with the encoder
+    QCOMPARE(decodeHex(&decoder, "828684be58086e6f2d6361636865", &headers), Decoder::Result::Ok);
+    QCOMPARE(headers.value(3), header(":authority", "www.example.com"));
+}
+
+void tst_QHttpServerHpack::encode_data()
+{
+    QTest::addColumn<HeaderList>("headers");
+
+    QTest::addRow("static") << HeaderList{ header(":status", "200") };
+    QTest::addRow("static name") << HeaderList{ header(":status", "431"),
+                                                header("content-type", "text/plain") };
+    QTest::addRow("new names") << HeaderList{ header("x-custom", "value"),
+                                              header("x-empty", "") };
+    QTest::addRow("binary value") << HeaderList{ header("x-binary", "\x01\x7f\xff") };
+}
+
+void tst_QHttpServerHpack::encode()
+{
+    QFETCH(HeaderList, headers);
+
+    QByteArray block;
+    QHttpServerHpack::encode(headers, &block);
+    // The encoder does not use the dynamic table, a fresh decoder reads it
+    Decoder decoder;
+    HeaderList decoded;
+    QCOMPARE(decoder.decode(reinterpret_cast<const uchar *>(block.constData()), block.size(), 0,
+                            &decoded),
+             Decoder::Result::Ok);
+    QCOMPARE(decoded, headers);
+}
+
+QT_END_NAMESPACE
+
+QTEST_MAIN(tst_QHttpServerHpack)
+
+#include "tst_qhttpserverhpack.moc"
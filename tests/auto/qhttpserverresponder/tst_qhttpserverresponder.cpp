@@ -38,6 +38,7 @@
 #include <QtTest/qsignalspy.h>
 #include <QtTest/qtest.h>
 #include <QtNetwork/qnetworkaccessmanager.h>
+#include <QtNetwork/qtcpsocket.h>
 
 #include <functional>
 
@@ -67,7 +68,9 @@ private slots:
     void writeFile_data();
     void writeFile();
     void writeFileExtraHeader();
+    void writeLargeFile();
     void writeByteArrayExtraHeader();
+    void writeHeadersThenSocket();
 };
 
 #define qWaitForFinished(REPLY) QVERIFY(QSignalSpy(REPLY, &QNetworkReply::finished).wait())
@@ -256,6 +259,31 @@ void tst_QHttpServerResponder::writeFileExtraHeader()
     QCOMPARE(spyDestroyIoDevice.count(), 1);
 }
 
+void tst_QHttpServerResponder::writeLargeFile()
+{
+    // Larger than the socket buffers, so that sending has to resume
+    QByteArray data;
+    for (int i = 0; data.size() < 8 * 1024 * 1024; ++i)
+        data += QByteArray::number(i) + '\n';
+    auto file = new QTemporaryFile(this);
+    QVERIFY(file->open());
+    QCOMPARE(file->write(data), qint64(data.size()));
+    QVERIFY(file->seek(0));
+    QSignalSpy spyDestroyIoDevice(file, &QObject::destroyed);
+
+    HttpServer server([=](QHttpServerResponder responder) {
+        responder.write(file, "text/plain");
+    });
+    auto reply = networkAccessManager->get(QNetworkRequest(server.url));
+    QTRY_VERIFY(reply->isFinished());
+
+    QCOMPARE(reply->error(), QNetworkReply::NoError);
+    QCOMPARE(reply->header(QNetworkRequest::ContentLengthHeader).toLongLong(),
+             qint64(data.size()));
+    QVERIFY(reply->readAll() == data);
+    QTRY_COMPARE(spyDestroyIoDevice.count(), 1);
+}
+
 void tst_QHttpServerResponder::writeByteArrayExtraHeader()
 {
     const QByteArray data("test data");
@@ -277,6 +305,26 @@ void tst_QHttpServerResponder::writeByteArrayExtraHeader()
     QCOMPARE(reply->readAll(), data);
 }
 
+void tst_QHttpServerResponder::writeHeadersThenSocket()
+{
+    const QByteArray data("test data");
+
+    HttpServer server([=](QHttpServerResponder responder) {
+        responder.writeStatusLine();
+        responder.writeHeader(QHttpServerLiterals::contentLengthHeader(),
+                              QByteArray::number(data.size()));
+        // The buffered headers go first
+        QTcpSocket *socket = responder.socket();
+        socket->write("\r\n");
+        socket->write(data);
+    });
+    auto reply = networkAccessManager->get(QNetworkRequest(server.url));
+    QTRY_VERIFY(reply->isFinished());
+
+    QCOMPARE(reply->error(), QNetworkReply::NoError);
+    QCOMPARE(reply->readAll(), data);
+}
+
 QT_END_NAMESPACE
 
 QTEST_MAIN(tst_QHttpServerResponder)
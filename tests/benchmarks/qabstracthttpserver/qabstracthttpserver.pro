@@ -0,0 +1,4 @@
+TARGET = tst_bench_qabstracthttpserver
+SOURCES  += tst_bench_qabstracthttpserver.cpp
+
+QT = httpserver testlib
@@ -0,0 +1,127 @@
+/****************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtHttpServer module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtHttpServer/qabstracthttpserver.h>
+#include <QtHttpServer/qhttpserverconfiguration.h>
+
+#include <QtTest/qtest.h>
+
+#include <QtNetwork/qtcpsocket.h>
+
+#include <memory>
+#include <vector>
+
+QT_BEGIN_NAMESPACE
+
+using EventBackend = QHttpServerConfiguration::EventBackend;
+
+static const QByteArray response = QByteArrayLiteral(
+        "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n");
+
+class tst_QAbstractHttpServer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void keepAlive_data();
+    void keepAlive();
+};
+
+void tst_QAbstractHttpServer::keepAlive_data()
+{
+    QTest::addColumn<EventBackend>("backend");
+    QTest::addColumn<int>("active");
+    QTest::addColumn<int>("idle");
+
+    for (const auto backend : { EventBackend::Default, EventBackend::Epoll }) {
+        const char *name = backend == EventBackend::Epoll ? "epoll" : "default";
+        QTest::addRow("%s, 1 active", name) << backend << 1 << 0;
+        QTest::addRow("%s, 1 active, 400 idle", name) << backend << 1 << 400;
+        QTest::addRow("%s, 64 active", name) << backend << 64 << 0;
+        QTest::addRow("%s, 64 active, 400 idle", name) << backend << 64 << 400;
+    }
+}
+
+// Round trips of keep-alive requests to one worker thread, which also
+// watches the idle connections. Both the accepting and the handling
+// happen in that thread, so the client can block on its sockets.
+void tst_QAbstractHttpServer::keepAlive()
+{
+    QFETCH(EventBackend, backend);
+    QFETCH(int, active);
+    QFETCH(int, idle);
+
+    struct HttpServer : QAbstractHttpServer
+    {
+        bool handleRequest(const QHttpServerRequest &, QTcpSocket *socket) override
+        {
+            socket->write(response);
+            return true;
+        }
+    } server;
+    QHttpServerConfiguration configuration;
+    configuration.setWorkerThreadCount(1);
+    configuration.setListenerSharding(true);
+    configuration.setEventBackend(backend);
+    server.setConfiguration(configuration);
+    const auto port = server.listen(QHostAddress::LocalHost);
+    QVERIFY(port);
+
+    std::vector<std::unique_ptr<QTcpSocket>> clients;
+    for (int i = 0; i < active + idle; ++i) {
+        clients.emplace_back(new QTcpSocket);
+        clients.back()->connectToHost(QHostAddress::LocalHost, port);
+        QVERIFY(clients.back()->waitForConnected());
+    }
+
+    const QByteArray request = QByteArrayLiteral("GET / HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    QBENCHMARK {
+        for (int i = 0; i < active; ++i) {
+            clients[i]->write(request);
+            clients[i]->flush();
+        }
+        for (int i = 0; i < active; ++i) {
+            QTcpSocket *client = clients[i].get();
+            QByteArray received;
+            while (received.size() < response.size()) {
+                QVERIFY(client->bytesAvailable() || client->waitForReadyRead());
+                received += client->readAll();
+            }
+            QCOMPARE(received, response);
+        }
+    }
+}
+
+QT_END_NAMESPACE
+
+Q_DECLARE_METATYPE(QHttpServerConfiguration::EventBackend)
+
+QTEST_MAIN(tst_QAbstractHttpServer)
+
+#include "tst_bench_qabstracthttpserver.moc"
@@ -0,0 +1,4 @@
+TARGET = tst_bench_qhttpserverrequest
+SOURCES  += tst_bench_qhttpserverrequest.cpp
+
+QT = httpserver-private testlib
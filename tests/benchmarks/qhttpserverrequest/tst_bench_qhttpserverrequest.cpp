@@ -0,0 +1,162 @@
+/****************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtHttpServer module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtHttpServer/private/qhttpserverrequest_p.h>
+
+#include <QtTest/qtest.h>
+
+#include <QtCore/qbuffer.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<quint64> allocations{0};
+
+void *operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+QT_BEGIN_NAMESPACE
+
+class tst_QHttpServerRequest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void parse_data();
+    void parse();
+    void allocations_data();
+    void allocations();
+
+private:
+    static QByteArray pipeline(int count);
+    static int parseAll(QHttpServerRequestPrivate &request, QBuffer &buffer);
+};
+
+QByteArray tst_QHttpServerRequest::pipeline(int count)
+{
+    const QByteArray message = QByteArrayLiteral(
+            "GET /api/v1/items?page=2&sort=name HTTP/1.1\r\n"
+            "Host: localhost:8080\r\n"
+            "User-Agent: tst_bench_qhttpserverrequest\r\n"
+            "Accept: application/json\r\n"
+            "Accept-Encoding: gzip, deflate\r\n"
+            "Connection: keep-alive\r\n"
+            "\r\n");
+    return message.repeated(count);
+}
+
+int tst_QHttpServerRequest::parseAll(QHttpServerRequestPrivate &request, QBuffer &buffer)
+{
+    int parsed = 0;
+    do {
+        if (request.state == QHttpServerRequestPrivate::State::OnMessageComplete)
+            request.clear();
+        if (!request.parse(&buffer))
+            break;
+        if (request.state == QHttpServerRequestPrivate::State::OnMessageComplete)
+            ++parsed;
+    } while (request.hasPendingData() || buffer.bytesAvailable());
+    return parsed;
+}
+
+void tst_QHttpServerRequest::parse_data()
+{
+    QTest::addColumn<int>("count");
+
+    QTest::addRow("1") << 1;
+    QTest::addRow("16") << 16;
+    QTest::addRow("256") << 256;
+}
+
+void tst_QHttpServerRequest::parse()
+{
+    QFETCH(int, count);
+
+    QByteArray data = pipeline(count);
+    QBuffer buffer(&data);
+    QHttpServerRequestPrivate request{QHostAddress::LocalHost};
+
+    QBENCHMARK {
+        buffer.open(QIODevice::ReadOnly);
+        QCOMPARE(parseAll(request, buffer), count);
+        buffer.close();
+        request.reset(QHostAddress::LocalHost);
+    }
+}
+
+void tst_QHttpServerRequest::allocations_data()
+{
+    parse_data();
+}
+
+// Reports the heap allocations made per request once the connection is
+// warmed up, which is what a long-lived keep-alive connection sees.
+void tst_QHttpServerRequest::allocations()
+{
+    QFETCH(int, count);
+
+    QByteArray data = pipeline(count);
+    QBuffer buffer(&data);
+    QHttpServerRequestPrivate request{QHostAddress::LocalHost};
+
+    buffer.open(QIODevice::ReadOnly);
+    QCOMPARE(parseAll(request, buffer), count);
+    buffer.close();
+    request.reset(QHostAddress::LocalHost);
+
+    buffer.open(QIODevice::ReadOnly);
+    const quint64 before = ::allocations.load();
+    QCOMPARE(parseAll(request, buffer), count);
+    const quint64 after = ::allocations.load();
+    buffer.close();
+
+    QTest::setBenchmarkResult(qreal(after - before) / count, QTest::Events);
+}
+
+QT_END_NAMESPACE
+
+QTEST_MAIN(tst_QHttpServerRequest)
+
+#include "tst_bench_qhttpserverrequest.moc"
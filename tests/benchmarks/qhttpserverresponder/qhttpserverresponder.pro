@@ -0,0 +1,4 @@
+TARGET = tst_bench_qhttpserverresponder
+SOURCES  += tst_bench_qhttpserverresponder.cpp
+
+QT = httpserver testlib
@@ -0,0 +1,189 @@
+/****************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtHttpServer module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtHttpServer/qabstracthttpserver.h>
+#include <QtHttpServer/qhttpserverconfiguration.h>
+#include <QtHttpServer/qhttpserverresponder.h>
+
+#include <QtTest/qtest.h>
+
+#include <QtCore/qpointer.h>
+#include <QtNetwork/qtcpsocket.h>
+
+#include <atomic>
+
+QT_BEGIN_NAMESPACE
+
+static const QByteArray request = QByteArrayLiteral("GET / HTTP/1.1\r\nHost: localhost\r\n\r\n");
+static const QByteArray mimeType = QByteArrayLiteral("application/octet-stream");
+
+// How the handler writes its response
+enum class Writes {
+    // Through the responder, which writes the head along with the body
+    Coalesced,
+    // A write per fragment, as the responder did before it buffered the head
+    Fragments
+};
+
+class tst_QHttpServerResponder : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void sendsPerResponse_data() { responses_data(); }
+    void sendsPerResponse();
+    void responses_data();
+    void responses();
+};
+
+namespace {
+
+// Answers every request with a body of the given size, and counts the
+// sends of its sockets: QTcpSocket emits bytesWritten() once for each of
+// them. Both the accepting and the handling happen in one worker thread,
+// so the client can block on its socket.
+struct HttpServer : QAbstractHttpServer
+{
+    HttpServer(Writes writes, int bodySize) : writes(writes), body(bodySize, 'x')
+    {
+        QHttpServerConfiguration configuration;
+        configuration.setWorkerThreadCount(1);
+        configuration.setListenerSharding(true);
+        setConfiguration(configuration);
+    }
+
+    bool handleRequest(const QHttpServerRequest &request, QTcpSocket *socket) override
+    {
+        // Everything sent for the previous responses has been counted
+        sentBefore = sent.load();
+        if (socket != lastSocket) {
+            lastSocket = socket;
+            QObject::connect(socket, &QTcpSocket::bytesWritten, [this]() { ++sent; });
+        }
+
+        if (writes == Writes::Coalesced) {
+            makeResponder(request, socket).write(body, mimeType);
+            return true;
+        }
+        for (const char *fragment : { "HTTP/", "1", ".", "1", " ", "200", " ", "OK", "\r\n" })
+            socket->write(fragment);
+        const QByteArray contentLength = QByteArray::number(body.size());
+        for (const QByteArray &fragment : { QByteArrayLiteral("Content-Type"),
+                                            QByteArrayLiteral(": "), mimeType,
+                                            QByteArrayLiteral("\r\n"),
+                                            QByteArrayLiteral("Content-Length"),
+                                            QByteArrayLiteral(": "), contentLength,
+                                            QByteArrayLiteral("\r\n\r\n"), body }) {
+            socket->write(fragment);
+        }
+        return true;
+    }
+
+    const Writes writes;
+    const QByteArray body;
+    QPointer<QTcpSocket> lastSocket;
+    std::atomic<int> sent{0};
+    std::atomic<int> sentBefore{0};
+};
+
+bool roundTrip(QTcpSocket *client, int bodySize)
+{
+    client->write(request);
+    client->flush();
+    QByteArray received;
+    int headSize = -1;
+    while (headSize < 0 || received.size() < headSize + bodySize) {
+        if (!client->bytesAvailable() && !client->waitForReadyRead())
+            return false;
+        received += client->readAll();
+        if (headSize < 0 && (headSize = received.indexOf("\r\n\r\n")) >= 0)
+            headSize += 4;
+    }
+    return received.startsWith("HTTP/1.1 200 OK\r\n") && received.size() == headSize + bodySize;
+}
+
+} // namespace
+
+void tst_QHttpServerResponder::responses_data()
+{
+    QTest::addColumn<Writes>("writes");
+    QTest::addColumn<int>("bodySize");
+
+    for (const int bodySize : { 0, 1024, 8 * 1024, 16 * 1024, 64 * 1024 }) {
+        QTest::addRow("coalesced, %d bytes", bodySize) << Writes::Coalesced << bodySize;
+        QTest::addRow("fragments, %d bytes", bodySize) << Writes::Fragments << bodySize;
+    }
+}
+
+// The send() calls a response costs, reported as events per response
+void tst_QHttpServerResponder::sendsPerResponse()
+{
+    QFETCH(Writes, writes);
+    QFETCH(int, bodySize);
+
+    HttpServer server(writes, bodySize);
+    const auto port = server.listen(QHostAddress::LocalHost);
+    QVERIFY(port);
+    QTcpSocket client;
+    client.connectToHost(QHostAddress::LocalHost, port);
+    QVERIFY(client.waitForConnected());
+
+    constexpr int Responses = 100;
+    for (int i = 0; i < Responses; ++i)
+        QVERIFY(roundTrip(&client, bodySize));
+    // Only handling the next request tells the previous one was sent
+    QVERIFY(roundTrip(&client, bodySize));
+    QTest::setBenchmarkResult(qreal(server.sentBefore.load()) / Responses, QTest::Events);
+}
+
+// Round trips of keep-alive requests
+void tst_QHttpServerResponder::responses()
+{
+    QFETCH(Writes, writes);
+    QFETCH(int, bodySize);
+
+    HttpServer server(writes, bodySize);
+    const auto port = server.listen(QHostAddress::LocalHost);
+    QVERIFY(port);
+    QTcpSocket client;
+    client.connectToHost(QHostAddress::LocalHost, port);
+    QVERIFY(client.waitForConnected());
+
+    QBENCHMARK {
+        QVERIFY(roundTrip(&client, bodySize));
+    }
+}
+
+QT_END_NAMESPACE
+
+Q_DECLARE_METATYPE(Writes)
+
+QTEST_MAIN(tst_QHttpServerResponder)
+
+#include "tst_bench_qhttpserverresponder.moc"